@@ -0,0 +1,456 @@
+#include "cluster_classes.h"
+#include "cluster_columns.h"
+#include "cluster_import.h"
+#include "cluster_index.h"
+#include "cluster_journal.h"
+#include "cluster_placement.h"
+#include "cluster_simulation.h"
+#include "cluster_snapshot.h"
+#include "cluster_telemetry.h"
+#include <chrono>
+#include <cstdio>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <random>
+
+// Замер времени выполнения функции в миллисекундах
+template <typename Func>
+double MeasureMs(Func f) {
+    auto start = chrono::high_resolution_clock::now();
+    f();
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+// Синтетический кластер из count узлов нескольких десятков типовых конфигураций
+Cluster MakeCluster(size_t count, unsigned seed = 42) {
+    static const CpuSpec cpus[] = {{"Intel-Xeon-Gold-6338", 32, 2.0}, {"Intel-Xeon-Platinum-8380", 40, 2.3},
+                                   {"AMD-EPYC-7763", 64, 2.45},        {"AMD-EPYC-9654", 96, 2.4},
+                                   {"Intel-Xeon-E-2388G", 8, 3.2},     {"AMD-Ryzen-9-7950X", 16, 4.5}};
+    static const GpuSpec gpus[] = {{"None", 0, 0},          {"NvidiaA100", 81920, 6912}, {"NvidiaH100", 81920, 16896},
+                                   {"NvidiaRtx3080", 10240, 8704}, {"NvidiaL4", 24576, 7424}};
+    static const char* ramTypes[] = {"DDR4", "DDR5"};
+    static const int ramSizes[] = {32768, 65536, 131072, 262144, 524288};
+    static const LanSpec lans[] = {{"IntelEthernet", 1.0}, {"MellanoxConnectX5", 25.0}, {"MellanoxConnectX6", 100.0},
+                                   {"BroadcomBCM57414", 10.0}};
+    mt19937 gen(seed);
+    Cluster cluster;
+    cluster.Nodes.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ClusterNode node;
+        node.Cpu = cpus[gen() % 6];
+        node.Gpu = gpus[gen() % 5];
+        node.Ram = {ramTypes[gen() % 2], ramSizes[gen() % 5]};
+        node.Lan = lans[gen() % 4];
+        cluster.AddNode(node);
+    }
+    return cluster;
+}
+
+// Агрегатный запрос "ядра узлов с частотой > 2.3 ГГц и RAM >= 64 ГБ": проход по
+// vector<ClusterNode> против столбцов в одном и нескольких потоках
+void BenchColumns(size_t count) {
+    Cluster cluster = MakeCluster(count);
+    ColumnarCluster columns;
+    double buildMs = MeasureMs([&]() { columns = ColumnarCluster(cluster); });
+    const vector<Condition> where = {{NodeField::CpuFrequency, Compare::Greater, 2.3},
+                                     {NodeField::RamSize, Compare::GreaterEqual, 65536}};
+
+    long long rowCores = 0;
+    size_t rowCount = 0;
+    double rowMs = MeasureMs([&]() {
+        for (const auto& node : cluster.Nodes) {
+            if (node.Cpu.Frequency > 2.3 && node.Ram.Size >= 65536) {
+                rowCores += node.Cpu.Cores;
+                ++rowCount;
+            }
+        }
+    });
+    Aggregate single, parallel;
+    double singleMs = MeasureMs([&]() { single = columns.Query(NodeField::CpuCores, where, 1); });
+    double parallelMs = MeasureMs([&]() { parallel = columns.Query(NodeField::CpuCores, where); });
+
+    cout << "Columnar query, " << count << " nodes (build " << buildMs << "ms): rows " << rowMs << "ms, columns "
+         << singleMs << "ms, columns x" << max(1u, thread::hardware_concurrency()) << " threads " << parallelMs
+         << "ms; " << parallel.Count << " nodes, " << parallel.Sum << " cores (rows: " << rowCount << ", " << rowCores
+         << ", single thread: " << single.Sum << ")" << endl;
+}
+
+// Загрузка кластера из текстового файла (Import) против открытия бинарного снимка
+// и первого запроса по нему. Кластер освобождается до замеров загрузки
+void BenchSnapshot(size_t count) {
+    const string textFile = "cluster_bench.txt";
+    const string snapshotFile = "cluster_bench.snap";
+    double exportMs, writeMs;
+    {
+        Cluster cluster = MakeCluster(count);
+        exportMs = MeasureMs([&]() { cluster.Export(textFile); });
+        writeMs = MeasureMs([&]() { WriteClusterSnapshot(cluster, snapshotFile); });
+    }
+    const vector<Condition> where = {{NodeField::CpuFrequency, Compare::Greater, 2.3},
+                                     {NodeField::RamSize, Compare::GreaterEqual, 65536}};
+
+    Aggregate textResult, snapshotResult;
+    double importMs, textQueryMs;
+    {
+        Cluster imported;
+        importMs = MeasureMs([&]() { imported.Import(textFile); });
+        ColumnarCluster columns;
+        textQueryMs = MeasureMs([&]() {
+            columns = ColumnarCluster(imported);
+            textResult = columns.Query(NodeField::CpuCores, where);
+        });
+    }
+    ClusterSnapshot snapshot;
+    bool opened = false;
+    double openMs = MeasureMs([&]() { opened = snapshot.Open(snapshotFile); });
+    if (!opened) {
+        cout << "Snapshot, " << count << " nodes: failed to open " << snapshotFile << endl;
+        remove(textFile.c_str());
+        remove(snapshotFile.c_str());
+        return;
+    }
+    double snapshotQueryMs = MeasureMs([&]() { snapshotResult = snapshot.Query(NodeField::CpuCores, where); });
+
+    cout << "Snapshot, " << count << " nodes: text export " << exportMs << "ms, import " << importMs
+         << "ms + columns and query " << textQueryMs << "ms; snapshot write " << writeMs << "ms, open " << openMs
+         << "ms + first query " << snapshotQueryMs << "ms (" << snapshotResult.Sum << " cores, text: "
+         << textResult.Sum << ")" << endl;
+    remove(textFile.c_str());
+    remove(snapshotFile.c_str());
+}
+
+// Cluster::Import против ClusterTextImporter: файл через mmap и тот же файл как поток
+void BenchImport(size_t count) {
+    const string textFile = "cluster_bench.txt";
+    MakeCluster(count).Export(textFile);
+    Cluster serial, mapped, streamed;
+    double serialMs = MeasureMs([&]() { serial.Import(textFile); });
+    double mappedMs = MeasureMs([&]() { ClusterTextImporter::ImportFile(textFile, mapped); });
+    double streamMs = MeasureMs([&]() {
+        ifstream in(textFile, ios::binary);
+        ClusterTextImporter::ImportStream(in, streamed);
+    });
+    cout << "Text import, " << count << " nodes: Cluster::Import " << serialMs << "ms, mapped " << mappedMs
+         << "ms, stream " << streamMs << "ms (" << mapped.Nodes.size() << " and " << streamed.Nodes.size() << " nodes)"
+         << endl;
+    remove(textFile.c_str());
+}
+
+// Запрос размещения "ядер >= 32, GPU >= 24 ГБ, сеть >= 10 Гбит/с" по индексам против
+// полного прохода, и скорость AddNode с поддержкой индексов
+void BenchIndex(size_t count) {
+    Cluster cluster = MakeCluster(count);
+    IndexedCluster indexed;
+    double buildMs = MeasureMs([&]() { indexed = IndexedCluster(cluster); });
+    const vector<Condition> where = {{NodeField::CpuCores, Compare::GreaterEqual, 32},
+                                     {NodeField::GpuMemory, Compare::GreaterEqual, 24576},
+                                     {NodeField::LanSpeed, Compare::GreaterEqual, 10}};
+    const vector<NameCondition> names = {{NameField::RamType, "DDR5"}};
+
+    size_t scanCount = 0;
+    double scanMs = MeasureMs([&]() {
+        for (const auto& node : cluster.Nodes) {
+            scanCount += node.Cpu.Cores >= 32 && node.Gpu.Memory >= 24576 && node.Lan.Speed >= 10;
+        }
+    });
+    const int repeats = 100;
+    size_t indexCount = 0, namedCount = 0;
+    double indexMs = MeasureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            indexCount = indexed.Count(where);
+        }
+    }) / repeats;
+    double namedMs = MeasureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            namedCount = indexed.Count(where, names);
+        }
+    }) / repeats;
+    const size_t added = count / 10;
+    Cluster extra = MakeCluster(added, 7);
+    double addMs = MeasureMs([&]() {
+        for (const auto& node : extra.Nodes) {
+            indexed.AddNode(node);
+        }
+    });
+
+    // Сверка индекса с проходом по столбцам на частотах NaN и +-inf, при построении и при AddNode
+    Cluster odd = MakeCluster(2000, 9);
+    const double nonFinite[] = {numeric_limits<double>::quiet_NaN(), numeric_limits<double>::infinity(),
+                                -numeric_limits<double>::infinity()};
+    for (size_t i = 0; i < odd.Nodes.size(); i += 4) {
+        odd.Nodes[i].Cpu.Frequency = nonFinite[i / 4 % 3];
+    }
+    IndexedCluster oddIndexed(odd);
+    for (size_t i = 0; i < 200; ++i) {
+        ClusterNode node = odd.Nodes[i];
+        node.Cpu.Frequency = i % 2 == 0 ? nonFinite[0] : 2.0 + double(i) / 100;
+        odd.AddNode(node);
+        oddIndexed.AddNode(node);
+    }
+    ColumnarCluster oddColumns(odd);
+    size_t mismatches = 0;
+    for (Compare op : {Compare::Less, Compare::LessEqual, Compare::Greater, Compare::GreaterEqual, Compare::Equal}) {
+        for (double value : {nonFinite[0], nonFinite[2], 2.3, 2.5, nonFinite[1]}) {
+            const vector<Condition> condition = {{NodeField::CpuFrequency, op, value}};
+            mismatches += oddIndexed.Count(condition) != oddColumns.Query(NodeField::CpuFrequency, condition).Count;
+        }
+    }
+
+    cout << "Indexes, " << count << " nodes (build " << buildMs << "ms, "
+         << indexed.Indexes().MemoryBytes() / (1024 * 1024) << "MB): scan " << scanMs * 1000 << "us, index "
+         << indexMs * 1000 << "us, index with name " << namedMs * 1000 << "us; " << indexCount << " nodes (scan: "
+         << scanCount << "), with DDR5 " << namedCount << "; AddNode " << added / addMs * 1000 << " nodes/s; "
+         << mismatches << " mismatches with NaN/inf" << endl;
+}
+
+// Синтетические задачи: 1-16 ядер, 1-32 ГБ RAM, 30% с GPU 4-32 ГБ, 0.1-3 Гбит/с
+vector<JobDemand> MakeJobs(size_t count, unsigned seed = 42) {
+    mt19937 gen(seed);
+    vector<JobDemand> jobs(count);
+    for (auto& job : jobs) {
+        job.Cores = 1 + int(gen() % 16);
+        job.RamSize = 1024 * (1 + int(gen() % 32));
+        job.GpuMemory = gen() % 10 < 7 ? 0 : 4096 * (1 + int(gen() % 8));
+        job.Bandwidth = 0.1 * (1 + int(gen() % 30));
+    }
+    return jobs;
+}
+
+// Размещение пакетами по 1000 задач каждой эвристикой и параллельно из нескольких потоков;
+// задач примерно столько, чтобы занять все ядра кластера
+void BenchPlacement(size_t nodeCount, size_t jobCount) {
+    const Cluster cluster = MakeCluster(nodeCount);
+    const vector<JobDemand> jobs = MakeJobs(jobCount);
+    const size_t batch = 1000;
+    auto run = [&](PlacementHeuristic heuristic, size_t threads, const char* name) {
+        PlacementEngine engine(cluster);
+        atomic<size_t> placed{0};
+        double ms = MeasureMs([&]() {
+            vector<thread> workers;
+            for (size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    for (size_t begin = t * batch; begin < jobs.size(); begin += threads * batch) {
+                        vector<JobDemand> part(jobs.begin() + ptrdiff_t(begin), jobs.begin() + ptrdiff_t(min(jobs.size(), begin + batch)));
+                        for (int node : engine.PlaceBatch(part, heuristic)) {
+                            placed += node >= 0;
+                        }
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        });
+        PackingReport report = engine.Report();
+        cout << "  " << name << ": " << jobs.size() / ms * 1000 << " jobs/s, placed " << placed << ", nodes used "
+             << report.NodesUsed << ", utilization cpu " << report.CoreUtilization << " ram " << report.RamUtilization
+             << " gpu " << report.GpuUtilization << " lan " << report.BandwidthUtilization << endl;
+    };
+    cout << "Placement, " << nodeCount << " nodes, " << jobCount << " jobs:" << endl;
+    run(PlacementHeuristic::FirstFitDecreasing, 1, "first-fit decreasing");
+    run(PlacementHeuristic::BestFit, 1, "best-fit");
+    run(PlacementHeuristic::DotProduct, 1, "dot-product");
+    run(PlacementHeuristic::DotProduct, 4, "dot-product x4 threads");
+}
+
+// Занятая память кучи (glibc); 0, если неизвестна
+size_t HeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Память и скорость прохода: vector<ClusterNode> против записей CompactNode в ColumnarCluster
+void BenchCompact(size_t count) {
+    size_t before = HeapBytes();
+    Cluster cluster = MakeCluster(count);
+    const size_t rowBytes = HeapBytes() - before;
+    before = HeapBytes();
+    ColumnarCluster compact(cluster);
+    const size_t compactBytes = HeapBytes() - before;
+
+    long long rowCores = 0, compactCores = 0;
+    size_t rowA100 = 0, compactA100 = 0;
+    double rowMs = MeasureMs([&]() {
+        for (const auto& node : cluster.Nodes) {
+            if (node.Ram.Size >= 65536) rowCores += node.Cpu.Cores;
+            rowA100 += node.Gpu.Name == "NvidiaA100";
+        }
+    });
+    double compactMs = MeasureMs([&]() {
+        uint32_t a100 = 0;
+        const bool known = compact.Names.Find("NvidiaA100", a100);
+        for (size_t i = 0; i < compact.Size(); ++i) {
+            if (compact.RamSize[i] >= 65536) compactCores += compact.CpuCores[i];
+            compactA100 += known && compact.GpuName[i] == a100;
+        }
+    });
+    cout << "Compact nodes, " << count << " nodes: ClusterNode " << sizeof(ClusterNode) << "B + strings, heap "
+         << rowBytes / (1024 * 1024) << "MB; CompactNode " << sizeof(CompactNode) << "B in columns, heap "
+         << compactBytes / (1024 * 1024) << "MB (estimate " << compact.MemoryBytes() / (1024 * 1024) << "MB, "
+         << compact.Names.Size() << " names); scan " << rowMs << "ms vs " << compactMs << "ms (" << compactCores
+         << " cores, " << compactA100 << " A100; rows: " << rowCores << ", " << rowA100 << ")" << endl;
+}
+
+// Поток задач (1-16 ядер, 30-90 с счёта, 0-4 ГБ данных) с пуассоновским поступлением,
+// нагружающий ядра кластера примерно на load
+vector<SimJob> MakeWorkload(const Cluster& cluster, size_t count, double load, unsigned seed = 42) {
+    long long cores = 0;
+    for (const auto& node : cluster.Nodes) {
+        cores += node.Cpu.Cores;
+    }
+    const double meanCores = 8.5, meanSeconds = 60, meanFrequency = 2.8;
+    mt19937 gen(seed);
+    exponential_distribution<double> gap(load * double(cores) / (meanCores * meanSeconds));
+    uniform_real_distribution<double> seconds(meanSeconds / 2, meanSeconds * 3 / 2);
+    vector<SimJob> jobs(count);
+    double time = 0;
+    for (auto& job : jobs) {
+        time += gap(gen);
+        job.Arrival = time;
+        job.Cores = 1 + int(gen() % 16);
+        job.Work = seconds(gen) * job.Cores * meanFrequency;
+        job.InputSize = 0.5 * double(gen() % 9);
+    }
+    return jobs;
+}
+
+// Дискретно-событийная модель: скорость в событиях в секунду и итоги при разной нагрузке
+void BenchSimulation(size_t nodeCount, size_t jobCount) {
+    const Cluster cluster = MakeCluster(nodeCount);
+    ClusterSimulator simulator(cluster);
+    for (double load : {0.7, 0.95, 1.2}) {
+        const vector<SimJob> jobs = MakeWorkload(cluster, jobCount, load);
+        SimulationReport report;
+        double ms = MeasureMs([&]() { report = simulator.Run(jobs); });
+        cout << "Simulation, " << nodeCount << " nodes, " << jobCount << " jobs, load " << load << ": " << report.Events
+             << " events in " << ms << "ms (" << report.Events / ms / 1000 << "M events/s); makespan "
+             << report.Makespan << "s, " << report.Throughput << " jobs/s, wait mean " << report.MeanWait << "s p95 "
+             << report.P95Wait << "s max " << report.MaxWait << "s, core utilization " << report.CoreUtilization << endl;
+    }
+}
+
+// Журнал изменений: цена одного изменения против полной перезаписи Export, сворачивание
+// в снимок и восстановление (снимок + хвост журнала)
+void BenchJournal(size_t count, size_t changes) {
+    const string base = "cluster_bench_journal";
+    const string textFile = "cluster_bench.txt";
+    Cluster cluster = MakeCluster(count);
+    WriteClusterSnapshot(cluster, base + ".snap");
+    double exportMs = MeasureMs([&]() { cluster.Export(textFile); });
+    remove(textFile.c_str());
+
+    const Cluster updates = MakeCluster(1024, 7);
+    double changeMs, compactMs;
+    size_t syncs, bytes;
+    {
+        JournaledCluster journal;
+        journal.Open(base);
+        mt19937 gen(1);
+        // 60% изменений узла, 30% новых узлов, 10% удалений
+        changeMs = MeasureMs([&]() {
+            for (size_t i = 0; i < changes; ++i) {
+                const unsigned kind = gen() % 10;
+                const ClusterNode& node = updates.Nodes[i % updates.Nodes.size()];
+                if (kind < 6) {
+                    journal.UpdateNode(gen() % journal.Nodes().Nodes.size(), node);
+                } else if (kind < 9) {
+                    journal.AddNode(node);
+                } else {
+                    journal.RemoveNode(gen() % journal.Nodes().Nodes.size());
+                }
+            }
+            journal.Sync();
+        });
+        syncs = journal.Stats().Syncs;
+        bytes = journal.Stats().BytesWritten;
+    }
+    JournaledCluster recovered;
+    double recoverMs = MeasureMs([&]() { recovered.Open(base); });
+    const size_t replayed = recovered.Stats().Replayed;
+    compactMs = MeasureMs([&]() { recovered.Compact(); });
+    recovered.Close();
+
+    cout << "Journal, " << count << " nodes: " << changes << " changes in " << changeMs << "ms ("
+         << changeMs * 1000 / changes << "us per change, " << syncs << " fsyncs, " << bytes / 1024
+         << "KB) vs full export " << exportMs << "ms; recovery " << recoverMs << "ms (" << replayed
+         << " records replayed), compaction " << compactMs << "ms" << endl;
+    remove((base + ".snap").c_str());
+    remove((base + ".wal").c_str());
+}
+
+// Телеметрия: запись замеров по кругу узлов в одном потоке, затем та же запись параллельно
+// с читателями, считающими сводки по окнам, и снимок по всем узлам
+void BenchTelemetry(size_t nodeCount, size_t capacity, size_t samples) {
+    TelemetryStore store(nodeCount, capacity);
+    auto write = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            TelemetrySample sample;
+            sample.Time = int64_t(i / nodeCount);
+            sample.Values[0] = float(i % 101) / 100;
+            sample.Values[1] = float(i % 65536);
+            sample.Values[2] = float(i % 1000) / 10;
+            store.Record(i % nodeCount, sample);
+        }
+    };
+    double ingestMs = MeasureMs([&]() { write(0, samples); });
+
+    const size_t window = 256;
+    atomic<bool> done{false};
+    atomic<size_t> queries{0};
+    double concurrentMs = MeasureMs([&]() {
+        vector<thread> readers;
+        for (size_t t = 0; t < 2; ++t) {
+            readers.emplace_back([&, t]() {
+                for (size_t node = t; !done.load(memory_order_relaxed); node = (node + 7) % nodeCount) {
+                    store.Last(node, TelemetryMetric(node % TELEMETRY_METRICS), window);
+                    queries.fetch_add(1, memory_order_relaxed);
+                }
+            });
+        }
+        write(samples, 2 * samples);
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    });
+    vector<NodeTelemetry> snapshot;
+    double snapshotMs = MeasureMs([&]() { snapshot = store.Snapshot(window); });
+
+    cout << "Telemetry, " << nodeCount << " nodes x " << store.Capacity() << " samples (" << store.MemoryBytes() / (1024 * 1024)
+         << "MB): ingest " << samples / ingestMs / 1000 << "M samples/s, with 2 readers "
+         << samples / concurrentMs / 1000 << "M samples/s and " << queries / concurrentMs * 1000 << " window queries/s; snapshot of "
+         << window << "-sample windows " << snapshotMs << "ms (node 0 cpu avg " << snapshot[0].Metrics[0].Average << " p99 "
+         << snapshot[0].Metrics[0].P99 << ")" << endl;
+}
+
+// --large добавляет замер на 10M узлов (нужно несколько ГБ памяти);
+// --stdin импортирует кластер из канала: cluster_benchmark --stdin < cluster_data.txt
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--stdin") {
+        Cluster cluster;
+        bool ok = false;
+        double ms = MeasureMs([&]() { ok = ClusterTextImporter::ImportStream(cin, cluster); });
+        cout << "Imported " << cluster.Nodes.size() << " nodes from stdin in " << ms << "ms" << endl;
+        return ok ? 0 : 1;
+    }
+    BenchColumns(500000);
+    BenchSnapshot(10000);
+    BenchSnapshot(1000000);
+    BenchImport(1000000);
+    BenchIndex(1000000);
+    BenchPlacement(10000, 50000);
+    BenchCompact(1000000);
+    BenchJournal(200000, 20000);
+    BenchSimulation(100000, 2000000);
+    BenchTelemetry(10000, 512, 20000000);
+    if (argc > 1 && string(argv[1]) == "--large") {
+        BenchSnapshot(10000000);
+    }
+    return 0;
+}
@@ -0,0 +1,613 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <limits>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Числовые поля узла, по которым строятся запросы
+enum class NodeField {
+    CpuCores,
+    CpuFrequency,
+    GpuMemory,
+    GpuCores,
+    RamSize,
+    LanSpeed
+};
+
+enum class Compare {
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal
+};
+
+// Условие запроса: поле, сравнение, значение (например, CpuFrequency > 3.0)
+struct Condition {
+    NodeField Field;
+    Compare Op;
+    double Value;
+};
+
+// Итог агрегатного запроса по выбранным узлам
+struct Aggregate {
+    size_t Count = 0;
+    double Sum = 0;
+    double Min = 0;   // при Count == 0 - нули
+    double Max = 0;
+
+    double Average() const { return Count > 0 ? Sum / Count : 0; }
+};
+
+// Пул строк: каждое различное название хранится один раз, узлы ссылаются на его номер.
+// Intern и Name работают за O(1); строки лежат в deque и не перемещаются, поэтому ключи
+// словаря и Views() - string_view на них
+class StringPool {
+public:
+    StringPool() = default;
+    // Копия пула должна указывать на свои строки, а не на строки оригинала
+    StringPool(const StringPool& other) : Strings(other.Strings) { Rebuild(); }
+    StringPool& operator=(const StringPool& other) {
+        if (this != &other) {
+            Strings = other.Strings;
+            Rebuild();
+        }
+        return *this;
+    }
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    // Номер названия; новое название добавляется в пул
+    uint32_t Intern(string_view name) {
+        auto found = Ids.find(name);
+        if (found != Ids.end()) {
+            return found->second;
+        }
+        const uint32_t id = uint32_t(Strings.size());
+        Strings.emplace_back(name);
+        Views.emplace_back(Strings.back());
+        Ids.emplace(Views.back(), id);
+        return id;
+    }
+
+    // Поиск без добавления; false, если такого названия нет
+    bool Find(string_view name, uint32_t& id) const {
+        auto found = Ids.find(name);
+        if (found == Ids.end()) {
+            return false;
+        }
+        id = found->second;
+        return true;
+    }
+
+    const string& Name(uint32_t id) const { return Strings[id]; }
+
+    // Названия по номерам, для NodeColumns::Names
+    const string_view* View() const { return Views.data(); }
+
+    size_t Size() const { return Strings.size(); }
+
+    size_t MemoryBytes() const {
+        size_t bytes = Strings.size() * sizeof(string) + Views.capacity() * sizeof(string_view) +
+                       Ids.bucket_count() * sizeof(void*) + Ids.size() * (sizeof(pair<string_view, uint32_t>) + sizeof(void*));
+        for (const auto& name : Strings) {
+            if (name.capacity() > 15) {
+                bytes += name.capacity() + 1;
+            }
+        }
+        return bytes;
+    }
+
+private:
+    deque<string> Strings;
+    vector<string_view> Views;
+    unordered_map<string_view, uint32_t> Ids;
+
+    void Rebuild() {
+        Views.assign(Strings.begin(), Strings.end());
+        Ids.clear();
+        for (uint32_t id = 0; id < Strings.size(); ++id) {
+            Ids.emplace(Views[id], id);
+        }
+    }
+};
+
+// Компактная запись узла: номера названий в пуле и числа, 48 байт без указателей (ClusterNode -
+// 168 байт и до четырёх строк в куче). Единая форма узла для ColumnarCluster и снимка:
+// ColumnarCluster хранит эти поля по столбцам, NodeRef::Record() собирает запись из столбцов
+// любого хранилища
+struct CompactNode {
+    uint32_t CpuName;
+    uint32_t GpuName;
+    uint32_t RamType;
+    uint32_t LanAdapter;
+    int32_t CpuCores;
+    int32_t GpuMemory;
+    int32_t GpuCores;
+    int32_t RamSize;
+    double CpuFrequency;
+    double LanSpeed;
+};
+static_assert(is_trivially_copyable<CompactNode>::value && is_standard_layout<CompactNode>::value,
+              "CompactNode must stay a POD record");
+static_assert(sizeof(CompactNode) == 48, "CompactNode layout changed");
+
+// Столбцы узлов без владения: у ColumnarCluster - его векторы и пул названий, у снимка
+// (cluster_snapshot.h) - страницы отображённого файла. Числа - по значению на узел, названия -
+// номерами в таблице Names
+struct NodeColumns {
+    size_t Size = 0;
+    const int* CpuCores = nullptr;
+    const double* CpuFrequency = nullptr;
+    const int* GpuMemory = nullptr;
+    const int* GpuCores = nullptr;
+    const int* RamSize = nullptr;
+    const double* LanSpeed = nullptr;
+    const uint32_t* CpuName = nullptr;
+    const uint32_t* GpuName = nullptr;
+    const uint32_t* RamType = nullptr;
+    const uint32_t* LanAdapter = nullptr;
+    const string_view* Names = nullptr;
+    size_t NameCount = 0;
+
+    // Название по номеру; для испорченного номера - "Unknown"
+    string_view Name(uint32_t id) const {
+        return id < NameCount ? Names[id] : string_view("Unknown");
+    }
+
+    const int* IntColumn(NodeField field) const {
+        switch (field) {
+        case NodeField::CpuCores: return CpuCores;
+        case NodeField::GpuMemory: return GpuMemory;
+        case NodeField::GpuCores: return GpuCores;
+        case NodeField::RamSize: return RamSize;
+        default: return nullptr;
+        }
+    }
+
+    const double* DoubleColumn(NodeField field) const {
+        switch (field) {
+        case NodeField::CpuFrequency: return CpuFrequency;
+        case NodeField::LanSpeed: return LanSpeed;
+        default: return nullptr;
+        }
+    }
+};
+
+// Узел index без копирования: числа читаются из столбцов, названия - string_view в таблицу
+// названий. Действителен, пока живо хранилище столбцов и в него не добавлялись узлы;
+// ToNode() - отдельный ClusterNode со своими строками
+class NodeRef {
+public:
+    NodeRef(const NodeColumns& columns, size_t index) : Columns(columns), Index(index) {}
+
+    string_view CpuName() const { return Columns.Name(Columns.CpuName[Index]); }
+    int CpuCores() const { return Columns.CpuCores[Index]; }
+    double CpuFrequency() const { return Columns.CpuFrequency[Index]; }
+    string_view GpuName() const { return Columns.Name(Columns.GpuName[Index]); }
+    int GpuMemory() const { return Columns.GpuMemory[Index]; }
+    int GpuCores() const { return Columns.GpuCores[Index]; }
+    string_view RamType() const { return Columns.Name(Columns.RamType[Index]); }
+    int RamSize() const { return Columns.RamSize[Index]; }
+    string_view LanAdapter() const { return Columns.Name(Columns.LanAdapter[Index]); }
+    double LanSpeed() const { return Columns.LanSpeed[Index]; }
+
+    // Запись узла; номера названий - в таблице Names этих же столбцов
+    CompactNode Record() const {
+        CompactNode record;
+        record.CpuName = Columns.CpuName[Index];
+        record.GpuName = Columns.GpuName[Index];
+        record.RamType = Columns.RamType[Index];
+        record.LanAdapter = Columns.LanAdapter[Index];
+        record.CpuCores = Columns.CpuCores[Index];
+        record.GpuMemory = Columns.GpuMemory[Index];
+        record.GpuCores = Columns.GpuCores[Index];
+        record.RamSize = Columns.RamSize[Index];
+        record.CpuFrequency = Columns.CpuFrequency[Index];
+        record.LanSpeed = Columns.LanSpeed[Index];
+        return record;
+    }
+
+    ClusterNode ToNode() const {
+        ClusterNode node;
+        node.Cpu = CpuSpec(string(CpuName()), CpuCores(), CpuFrequency());
+        node.Gpu = GpuSpec(string(GpuName()), GpuMemory(), GpuCores());
+        node.Ram = RamSpec(string(RamType()), RamSize());
+        node.Lan = LanSpec(string(LanAdapter()), LanSpeed());
+        return node;
+    }
+
+private:
+    NodeColumns Columns;
+    size_t Index;
+};
+
+// Запросы над столбцами: условия проверяются SIMD-сравнением блока из 64 узлов в битовую
+// маску, маски условий объединяются через AND, агрегат считается по установленным битам.
+// Большие наборы делятся между потоками.
+class NodeQuery {
+public:
+    // Начиная с этого числа узлов запрос выполняется в нескольких потоках
+    static const size_t PARALLEL_THRESHOLD = 1 << 16;
+
+    // Число узлов, удовлетворяющих всем условиям
+    static size_t Count(const NodeColumns& columns, const vector<Condition>& where, size_t threads = 0) {
+        return Query(columns, NodeField::CpuCores, where, threads).Count;
+    }
+
+    // Сумма, минимум и максимум поля target по узлам, удовлетворяющим всем условиям
+    // (например, суммарные ядра узлов с частотой > 3 ГГц и памятью >= 64 ГБ)
+    static Aggregate Query(const NodeColumns& columns, NodeField target, const vector<Condition>& where, size_t threads = 0) {
+        const size_t n = columns.Size;
+        if (threads == 0) {
+            threads = max<size_t>(1, thread::hardware_concurrency());
+        }
+        if (n < PARALLEL_THRESHOLD || threads == 1) {
+            return QueryRange(columns, target, where, 0, n);
+        }
+        // границы частей кратны 64, чтобы блоки масок не пересекались
+        const size_t words = (n + 63) / 64;
+        const size_t parts = min(threads, words);
+        vector<future<Aggregate>> futures;
+        for (size_t p = 0; p < parts; ++p) {
+            const size_t begin = words * p / parts * 64;
+            const size_t end = min(n, words * (p + 1) / parts * 64);
+            futures.push_back(async(launch::async, [&columns, target, &where, begin, end]() {
+                return QueryRange(columns, target, where, begin, end);
+            }));
+        }
+        Aggregate result;
+        for (auto& part : futures) {
+            Merge(result, part.get());
+        }
+        return result;
+    }
+
+    // Индексы узлов, удовлетворяющих всем условиям, по возрастанию
+    static vector<size_t> Select(const NodeColumns& columns, const vector<Condition>& where) {
+        vector<size_t> result;
+        const size_t n = columns.Size;
+        for (size_t begin = 0; begin < n; begin += 64) {
+            uint64_t mask = Mask(columns, where, begin, min<size_t>(64, n - begin));
+            while (mask != 0) {
+                result.push_back(begin + CountTrailingZeros(mask));
+                mask &= mask - 1;
+            }
+        }
+        return result;
+    }
+
+private:
+    static unsigned CountTrailingZeros(uint64_t mask) {
+        return unsigned(__builtin_ctzll(mask));
+    }
+
+    static void Merge(Aggregate& total, const Aggregate& part) {
+        if (part.Count == 0) {
+            return;
+        }
+        total.Min = total.Count == 0 ? part.Min : min(total.Min, part.Min);
+        total.Max = total.Count == 0 ? part.Max : max(total.Max, part.Max);
+        total.Count += part.Count;
+        total.Sum += part.Sum;
+    }
+
+    // Биты count (<= 64) узлов подряд, для которых x op value
+    static uint64_t CompareBlock(const double* x, size_t count, Compare op, double value) {
+        uint64_t bits = 0;
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256d v = _mm256_set1_pd(value);
+        for (; i + 4 <= count; i += 4) {
+            const __m256d a = _mm256_loadu_pd(x + i);
+            __m256d c;
+            switch (op) {
+            case Compare::Less: c = _mm256_cmp_pd(a, v, _CMP_LT_OQ); break;
+            case Compare::LessEqual: c = _mm256_cmp_pd(a, v, _CMP_LE_OQ); break;
+            case Compare::Greater: c = _mm256_cmp_pd(a, v, _CMP_GT_OQ); break;
+            case Compare::GreaterEqual: c = _mm256_cmp_pd(a, v, _CMP_GE_OQ); break;
+            default: c = _mm256_cmp_pd(a, v, _CMP_EQ_OQ); break;
+            }
+            bits |= uint64_t(_mm256_movemask_pd(c)) << i;
+        }
+#elif defined(__SSE2__)
+        const __m128d v = _mm_set1_pd(value);
+        for (; i + 2 <= count; i += 2) {
+            const __m128d a = _mm_loadu_pd(x + i);
+            __m128d c;
+            switch (op) {
+            case Compare::Less: c = _mm_cmplt_pd(a, v); break;
+            case Compare::LessEqual: c = _mm_cmple_pd(a, v); break;
+            case Compare::Greater: c = _mm_cmpgt_pd(a, v); break;
+            case Compare::GreaterEqual: c = _mm_cmpge_pd(a, v); break;
+            default: c = _mm_cmpeq_pd(a, v); break;
+            }
+            bits |= uint64_t(_mm_movemask_pd(c)) << i;
+        }
+#endif
+        for (; i < count; ++i) {
+            bool match;
+            switch (op) {
+            case Compare::Less: match = x[i] < value; break;
+            case Compare::LessEqual: match = x[i] <= value; break;
+            case Compare::Greater: match = x[i] > value; break;
+            case Compare::GreaterEqual: match = x[i] >= value; break;
+            default: match = x[i] == value; break;
+            }
+            bits |= uint64_t(match) << i;
+        }
+        return bits;
+    }
+
+    // Для целых столбцов условие сводится к диапазону lo <= x <= hi
+    static uint64_t RangeBlock(const int* x, size_t count, int lo, int hi) {
+        uint64_t bits = 0;
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i below = _mm256_set1_epi32(lo), above = _mm256_set1_epi32(hi);
+        for (; i + 8 <= count; i += 8) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+            // x < lo или x > hi - вне диапазона
+            const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(below, a), _mm256_cmpgt_epi32(a, above));
+            bits |= uint64_t(~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << i;
+        }
+#elif defined(__SSE2__)
+        const __m128i below = _mm_set1_epi32(lo), above = _mm_set1_epi32(hi);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+            const __m128i outside = _mm_or_si128(_mm_cmpgt_epi32(below, a), _mm_cmpgt_epi32(a, above));
+            bits |= uint64_t(~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF) << i;
+        }
+#endif
+        for (; i < count; ++i) {
+            bits |= uint64_t(x[i] >= lo && x[i] <= hi) << i;
+        }
+        return bits;
+    }
+
+    // Условие на целом поле как диапазон [lo, hi]; false, если ему не удовлетворяет ни одно целое
+    static bool IntRange(const Condition& condition, int& lo, int& hi) {
+        const double low = numeric_limits<int>::min(), high = numeric_limits<int>::max();
+        double from = low, to = high;
+        switch (condition.Op) {
+        case Compare::Less: to = ceil(condition.Value) - 1; break;
+        case Compare::LessEqual: to = floor(condition.Value); break;
+        case Compare::Greater: from = floor(condition.Value) + 1; break;
+        case Compare::GreaterEqual: from = ceil(condition.Value); break;
+        default: from = to = condition.Value; break;
+        }
+        if (std::isnan(condition.Value) || from > to || from > high || to < low || from != floor(from)) {
+            return false;
+        }
+        lo = int(max(from, low));
+        hi = int(min(to, high));
+        return true;
+    }
+
+    // Маска count (<= 64) узлов начиная с begin, удовлетворяющих всем условиям
+    static uint64_t Mask(const NodeColumns& columns, const vector<Condition>& where, size_t begin, size_t count) {
+        uint64_t mask = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+        for (const auto& condition : where) {
+            if (const int* column = columns.IntColumn(condition.Field)) {
+                int lo, hi;
+                mask &= IntRange(condition, lo, hi) ? RangeBlock(column + begin, count, lo, hi) : 0;
+            } else {
+                mask &= CompareBlock(columns.DoubleColumn(condition.Field) + begin, count, condition.Op, condition.Value);
+            }
+            if (mask == 0) {
+                break;
+            }
+        }
+        return mask;
+    }
+
+    template <typename T>
+    static void Accumulate(Aggregate& result, const T* column, size_t begin, uint64_t mask) {
+        if (mask == 0) {
+            return;
+        }
+        const T* x = column + begin;
+        double sum = 0;
+        T low, high;
+        size_t count;
+        if (mask == ~uint64_t(0)) {
+            // весь блок выбран - плотный цикл без ветвлений
+            low = high = x[0];
+            for (size_t i = 0; i < 64; ++i) {
+                sum += x[i];
+                low = min(low, x[i]);
+                high = max(high, x[i]);
+            }
+            count = 64;
+        } else {
+            low = high = x[CountTrailingZeros(mask)];
+            count = 0;
+            while (mask != 0) {
+                const T value = x[CountTrailingZeros(mask)];
+                sum += value;
+                low = min(low, value);
+                high = max(high, value);
+                ++count;
+                mask &= mask - 1;
+            }
+        }
+        Aggregate block;
+        block.Count = count;
+        block.Sum = sum;
+        block.Min = low;
+        block.Max = high;
+        Merge(result, block);
+    }
+
+    static Aggregate QueryRange(const NodeColumns& columns, NodeField target, const vector<Condition>& where, size_t begin, size_t end) {
+        Aggregate result;
+        const int* intColumn = columns.IntColumn(target);
+        const double* doubleColumn = columns.DoubleColumn(target);
+        for (size_t block = begin; block < end; block += 64) {
+            const uint64_t mask = Mask(columns, where, block, min<size_t>(64, end - block));
+            if (intColumn != nullptr) {
+                Accumulate(result, intColumn, block, mask);
+            } else {
+                Accumulate(result, doubleColumn, block, mask);
+            }
+        }
+        return result;
+    }
+};
+
+// Кластер по столбцам: каждое поле узла - отдельный непрерывный массив, так что фильтр по
+// частоте читает только частоты, а не 200-байтовые записи со строками. Названия хранятся
+// один раз в пуле Names, столбцы названий - их номера
+class ColumnarCluster {
+public:
+    StringPool Names;
+    vector<uint32_t> CpuName;
+    vector<int> CpuCores;
+    vector<double> CpuFrequency;
+    vector<uint32_t> GpuName;
+    vector<int> GpuMemory;
+    vector<int> GpuCores;
+    vector<uint32_t> RamType;
+    vector<int> RamSize;
+    vector<uint32_t> LanAdapter;
+    vector<double> LanSpeed;
+
+    ColumnarCluster() {}
+
+    explicit ColumnarCluster(const Cluster& cluster) {
+        Reserve(cluster.Nodes.size());
+        for (const auto& node : cluster.Nodes) {
+            AddNode(node);
+        }
+    }
+
+    size_t Size() const { return CpuCores.size(); }
+
+    void Reserve(size_t count) {
+        CpuName.reserve(count);
+        CpuCores.reserve(count);
+        CpuFrequency.reserve(count);
+        GpuName.reserve(count);
+        GpuMemory.reserve(count);
+        GpuCores.reserve(count);
+        RamType.reserve(count);
+        RamSize.reserve(count);
+        LanAdapter.reserve(count);
+        LanSpeed.reserve(count);
+    }
+
+    // Запись узла с названиями из пула Names (новые названия добавляются в пул)
+    CompactNode Compact(const ClusterNode& node) {
+        CompactNode record;
+        record.CpuName = Names.Intern(node.Cpu.Name);
+        record.GpuName = Names.Intern(node.Gpu.Name);
+        record.RamType = Names.Intern(node.Ram.Type);
+        record.LanAdapter = Names.Intern(node.Lan.AdapterName);
+        record.CpuCores = node.Cpu.Cores;
+        record.GpuMemory = node.Gpu.Memory;
+        record.GpuCores = node.Gpu.Cores;
+        record.RamSize = node.Ram.Size;
+        record.CpuFrequency = node.Cpu.Frequency;
+        record.LanSpeed = node.Lan.Speed;
+        return record;
+    }
+
+    void AddNode(const ClusterNode& node) {
+        AddNode(Compact(node));
+    }
+
+    // Запись с номерами названий из Names
+    void AddNode(const CompactNode& record) {
+        CpuName.push_back(record.CpuName);
+        CpuCores.push_back(record.CpuCores);
+        CpuFrequency.push_back(record.CpuFrequency);
+        GpuName.push_back(record.GpuName);
+        GpuMemory.push_back(record.GpuMemory);
+        GpuCores.push_back(record.GpuCores);
+        RamType.push_back(record.RamType);
+        RamSize.push_back(record.RamSize);
+        LanAdapter.push_back(record.LanAdapter);
+        LanSpeed.push_back(record.LanSpeed);
+    }
+
+    // Доступ к узлу index без копирования; до следующего AddNode
+    NodeRef Node(size_t index) const { return NodeRef(Columns(), index); }
+
+    void SetNode(size_t index, const ClusterNode& node) {
+        SetNode(index, Compact(node));
+    }
+
+    void SetNode(size_t index, const CompactNode& record) {
+        CpuName[index] = record.CpuName;
+        CpuCores[index] = record.CpuCores;
+        CpuFrequency[index] = record.CpuFrequency;
+        GpuName[index] = record.GpuName;
+        GpuMemory[index] = record.GpuMemory;
+        GpuCores[index] = record.GpuCores;
+        RamType[index] = record.RamType;
+        RamSize[index] = record.RamSize;
+        LanAdapter[index] = record.LanAdapter;
+        LanSpeed[index] = record.LanSpeed;
+    }
+
+    Cluster ToCluster() const {
+        Cluster cluster;
+        cluster.Nodes.reserve(Size());
+        const NodeColumns columns = Columns();
+        for (size_t i = 0; i < Size(); ++i) {
+            cluster.Nodes.push_back(NodeRef(columns, i).ToNode());
+        }
+        return cluster;
+    }
+
+    NodeColumns Columns() const {
+        NodeColumns columns;
+        columns.Size = Size();
+        columns.CpuCores = CpuCores.data();
+        columns.CpuFrequency = CpuFrequency.data();
+        columns.GpuMemory = GpuMemory.data();
+        columns.GpuCores = GpuCores.data();
+        columns.RamSize = RamSize.data();
+        columns.LanSpeed = LanSpeed.data();
+        columns.CpuName = CpuName.data();
+        columns.GpuName = GpuName.data();
+        columns.RamType = RamType.data();
+        columns.LanAdapter = LanAdapter.data();
+        columns.Names = Names.View();
+        columns.NameCount = Names.Size();
+        return columns;
+    }
+
+    // Память столбцов по их фактической ёмкости и пула названий
+    size_t MemoryBytes() const {
+        auto bytes = [](const auto& column) { return column.capacity() * sizeof(column[0]); };
+        return bytes(CpuName) + bytes(CpuCores) + bytes(CpuFrequency) + bytes(GpuName) + bytes(GpuMemory) +
+               bytes(GpuCores) + bytes(RamType) + bytes(RamSize) + bytes(LanAdapter) + bytes(LanSpeed) +
+               Names.MemoryBytes();
+    }
+
+    size_t Count(const vector<Condition>& where, size_t threads = 0) const {
+        return NodeQuery::Count(Columns(), where, threads);
+    }
+
+    // Сумма, минимум и максимум поля target по узлам, удовлетворяющим всем условиям
+    // (например, суммарные ядра узлов с частотой > 3 ГГц и памятью >= 64 ГБ)
+    Aggregate Query(NodeField target, const vector<Condition>& where, size_t threads = 0) const {
+        return NodeQuery::Query(Columns(), target, where, threads);
+    }
+
+    vector<size_t> Select(const vector<Condition>& where) const {
+        return NodeQuery::Select(Columns(), where);
+    }
+};
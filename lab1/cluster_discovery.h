@@ -0,0 +1,97 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include "../lab2/HardwareInfo.cpp"
+
+// Класс CacheSpec: размеры кэшей одного ядра в КБ и длина строки в байтах
+class CacheSpec {
+public:
+    int L1Data;
+    int L2;
+    int L3;
+    int LineSize;
+
+    CacheSpec() : L1Data(0), L2(0), L3(0), LineSize(0) {}
+
+    CacheSpec(int l1Data, int l2, int l3, int lineSize)
+        : L1Data(l1Data), L2(l2), L3(l3), LineSize(lineSize) {}
+
+    void Print() const {
+        cout << "Cache: L1d " << L1Data << "KB, L2 " << L2 << "KB, L3 " << L3 << "KB, Line: " << LineSize << "B" << endl;
+    }
+};
+
+// Класс TopologySpec: сокеты, физические ядра, потоки SMT на ядро, NUMA-узлы
+class TopologySpec {
+public:
+    int Sockets;
+    int PhysicalCores;
+    int ThreadsPerCore;
+    int LogicalCpus;
+    int NumaNodes;
+
+    TopologySpec() : Sockets(0), PhysicalCores(0), ThreadsPerCore(0), LogicalCpus(0), NumaNodes(0) {}
+
+    TopologySpec(int sockets, int physicalCores, int threadsPerCore, int logicalCpus, int numaNodes)
+        : Sockets(sockets), PhysicalCores(physicalCores), ThreadsPerCore(threadsPerCore), LogicalCpus(logicalCpus), NumaNodes(numaNodes) {}
+
+    void Print() const {
+        cout << "Topology: " << Sockets << " sockets, " << PhysicalCores << " cores x " << ThreadsPerCore
+             << " threads (" << LogicalCpus << " CPUs), NUMA nodes: " << NumaNodes << endl;
+    }
+};
+
+// Узел локальной машины: ClusterNode с кэшами и топологией. Cluster хранит узлы как
+// ClusterNode, поэтому Cache и Topology есть только у самого LocalNode
+class LocalNode : public ClusterNode {
+public:
+    CacheSpec Cache;
+    TopologySpec Topology;
+
+    void Print() const {
+        ClusterNode::Print();
+        Cache.Print();
+        Topology.Print();
+    }
+};
+
+// Название без пробелов, как в файлах Cluster::Export ("Intel(R) Xeon(R) Gold" -> "Intel(R)-Xeon(R)-Gold")
+inline string CompactName(const string& name) {
+    string result;
+    for (char c : name) {
+        if (c == ' ' || c == '\t') {
+            if (!result.empty() && result.back() != '-') {
+                result += '-';
+            }
+        } else {
+            result += c;
+        }
+    }
+    while (!result.empty() && result.back() == '-') {
+        result.pop_back();
+    }
+    return result.empty() ? "Unknown" : result;
+}
+
+// Узел этой машины по /proc и /sys (см. lab2/HardwareInfo.cpp). Тип памяти и GPU без
+// прав root не определяются: RAM "Unknown", GPU "None". Сеть - самый быстрый интерфейс
+// с известной скоростью, иначе первый найденный
+inline LocalNode DiscoverLocalNode(const hardware_info::Info& info = hardware_info::local()) {
+    LocalNode node;
+    node.Cpu = CpuSpec(CompactName(info.cpuModel), int(info.physicalCores), info.frequencyGhz);
+    node.Gpu = GpuSpec("None", 0, 0);
+    node.Ram = RamSpec("Unknown", int(info.memoryBytes / (1024 * 1024)));
+    const hardware_info::NetworkInterface* fastest = nullptr;
+    for (const auto& nic : info.network) {
+        if (fastest == nullptr || nic.speedGbps > fastest->speedGbps) {
+            fastest = &nic;
+        }
+    }
+    if (fastest != nullptr) {
+        node.Lan = LanSpec(fastest->name, fastest->speedGbps);
+    }
+    node.Cache = CacheSpec(int(info.l1d / 1024), int(info.l2 / 1024), int(info.l3 / 1024), int(info.cacheLine));
+    node.Topology = TopologySpec(int(info.sockets), int(info.physicalCores), int(info.threadsPerCore), int(info.logicalCpus),
+                                 int(info.numaNodes));
+    return node;
+}
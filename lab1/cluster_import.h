@@ -0,0 +1,329 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include "../lab2/MappedFile.cpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <string_view>
+#include <thread>
+
+// Параллельный импорт текстового формата Cluster::Export: строка с числом узлов, затем
+// по 4 строки на узел (CPU, GPU, RAM, LAN). В отличие от Cluster::Import разбор построчный:
+// числа берутся с конца строки, остальное - имя, поэтому имена могут содержать пробелы.
+// Ошибки сообщаются в cerr, кластер при этом не меняется.
+class ClusterTextImporter {
+public:
+    // Файл отображается в память, тело делится на части по границам записей,
+    // части разбираются параллельно
+    static bool ImportFile(const string& filename, Cluster& cluster, size_t threads = 0) {
+        unique_ptr<MappedFile> file;
+        try {
+            file = make_unique<MappedFile>(filename);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return false;
+        }
+        const char* data = file->data();
+        const size_t size = file->size();
+        const char* headerEnd = static_cast<const char*>(memchr(data, '\n', size));
+        const size_t headerSize = headerEnd == nullptr ? size : size_t(headerEnd - data);
+        size_t nodeCount = 0;
+        if (!ParseCount(string_view(data, headerSize), nodeCount)) {
+            cerr << "Error reading node count" << endl;
+            return false;
+        }
+        const size_t bodyBegin = min(size, headerSize + 1);
+        vector<ClusterNode> nodes;
+        // узел занимает не меньше 16 байт, испорченный счётчик не приведёт к огромному резерву
+        nodes.reserve(min(nodeCount, (size - bodyBegin) / 16 + 1));
+        size_t errorLine = 0;
+        if (!ParseRecords(data + bodyBegin, size - bodyBegin, Threads(threads), 2, nodes, errorLine)) {
+            cerr << "Error reading node data at line " << errorLine << endl;
+            return false;
+        }
+        return Finish(nodes, nodeCount, cluster);
+    }
+
+    // Потоковый режим для каналов и сокетов: поток читается блоками, полные записи блока
+    // разбираются параллельно, пока читается следующий блок
+    static bool ImportStream(istream& in, Cluster& cluster, size_t threads = 0) {
+        string header;
+        size_t nodeCount = 0;
+        if (!getline(in, header) || !ParseCount(header, nodeCount)) {
+            cerr << "Error reading node count" << endl;
+            return false;
+        }
+        threads = Threads(threads);
+        vector<ClusterNode> nodes;
+        nodes.reserve(min<size_t>(nodeCount, 1 << 20));
+
+        string pending;          // прочитанное, но ещё не отданное на разбор
+        string parsing;          // блок, который разбирается сейчас
+        vector<ClusterNode> parsed;
+        future<bool> worker;
+        size_t pendingLine = 2;  // номер строки файла, с которой начинается pending
+        size_t parsingLine = 2;
+        size_t errorLine = 0;
+        auto collect = [&]() {
+            if (!worker.valid()) {
+                return true;
+            }
+            if (!worker.get()) {
+                return false;
+            }
+            nodes.insert(nodes.end(), make_move_iterator(parsed.begin()), make_move_iterator(parsed.end()));
+            parsed.clear();
+            return true;
+        };
+
+        bool eof = false;
+        while (!eof) {
+            const size_t used = pending.size();
+            pending.resize(used + STREAM_BLOCK);
+            in.read(&pending[used], streamsize(STREAM_BLOCK));
+            pending.resize(used + size_t(in.gcount()));
+            eof = !in;
+            // конец последней полной записи: после каждой четвёртой строки
+            size_t cut = 0;
+            size_t lines = 0;
+            size_t cutLines = 0;
+            for (const char* p = pending.data(); (p = static_cast<const char*>(memchr(p, '\n', pending.data() + pending.size() - p))) != nullptr;) {
+                ++p;
+                if (++lines % 4 == 0) {
+                    cut = size_t(p - pending.data());
+                    cutLines = lines;
+                }
+            }
+            if (eof) {
+                cut = pending.size();
+                cutLines = lines;
+            }
+            if (cut == 0) {
+                continue;
+            }
+            if (!collect()) {
+                cerr << "Error reading node data at line " << errorLine << endl;
+                return false;
+            }
+            string rest = pending.substr(cut);
+            pending.resize(cut);
+            swap(parsing, pending);
+            pending = move(rest);
+            parsingLine = pendingLine;
+            pendingLine += cutLines;
+            parsed.reserve(cutLines / 4 + 1);
+            worker = async(launch::async, [&parsing, &parsed, &errorLine, threads, parsingLine]() {
+                return ParseRecords(parsing.data(), parsing.size(), threads, parsingLine, parsed, errorLine);
+            });
+        }
+        if (!collect()) {
+            cerr << "Error reading node data at line " << errorLine << endl;
+            return false;
+        }
+        if (in.bad()) {
+            cerr << "Error reading input stream" << endl;
+            return false;
+        }
+        return Finish(nodes, nodeCount, cluster);
+    }
+
+    static const size_t PARALLEL_THRESHOLD = 1 << 20;  // байт; меньшие тела разбираются в одном потоке
+    static const size_t STREAM_BLOCK = 8 << 20;
+
+private:
+    static size_t Threads(size_t threads) {
+        return threads != 0 ? threads : max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static bool ParseCount(string_view line, size_t& count) {
+        while (!line.empty() && IsSpace(line.back())) {
+            line.remove_suffix(1);
+        }
+        while (!line.empty() && IsSpace(line.front())) {
+            line.remove_prefix(1);
+        }
+        return ParseNumber(line, count);
+    }
+
+    template <typename T>
+    static bool ParseNumber(string_view text, T& value) {
+        const char* end = text.data() + text.size();
+        auto result = from_chars(text.data(), end, value);
+        return !text.empty() && result.ec == errc() && result.ptr == end;
+    }
+
+    // Строка "Имя n1 ... nk": k чисел справа, остальное - имя
+    static bool SplitLine(string_view line, string_view* numbers, size_t count, string_view& name) {
+        size_t end = line.size();
+        for (size_t i = count; i-- > 0;) {
+            while (end > 0 && IsSpace(line[end - 1])) {
+                --end;
+            }
+            size_t begin = end;
+            while (begin > 0 && !IsSpace(line[begin - 1])) {
+                --begin;
+            }
+            if (begin == end) {
+                return false;
+            }
+            numbers[i] = line.substr(begin, end - begin);
+            end = begin;
+        }
+        while (end > 0 && IsSpace(line[end - 1])) {
+            --end;
+        }
+        size_t begin = 0;
+        while (begin < end && IsSpace(line[begin])) {
+            ++begin;
+        }
+        name = line.substr(begin, end - begin);
+        return !name.empty();
+    }
+
+    // Узел собирается сразу из разобранных полей, без конструктора по умолчанию. from_chars
+    // принимает nan и inf, а Cluster::Import их отвергает - здесь так же
+    static bool ParseRecord(const string_view* lines, vector<ClusterNode>& out) {
+        string_view numbers[2], cpuName, gpuName, ramType, lanName;
+        int cpuCores, gpuMemory, gpuCores, ramSize;
+        double cpuFrequency, lanSpeed;
+        if (!SplitLine(lines[0], numbers, 2, cpuName) || !ParseNumber(numbers[0], cpuCores) || !ParseNumber(numbers[1], cpuFrequency) ||
+            !SplitLine(lines[1], numbers, 2, gpuName) || !ParseNumber(numbers[0], gpuMemory) || !ParseNumber(numbers[1], gpuCores) ||
+            !SplitLine(lines[2], numbers, 1, ramType) || !ParseNumber(numbers[0], ramSize) ||
+            !SplitLine(lines[3], numbers, 1, lanName) || !ParseNumber(numbers[0], lanSpeed) ||
+            !isfinite(cpuFrequency) || !isfinite(lanSpeed)) {
+            return false;
+        }
+        out.push_back(ClusterNode{CpuSpec(string(cpuName), cpuCores, cpuFrequency), GpuSpec(string(gpuName), gpuMemory, gpuCores),
+                                  RamSpec(string(ramType), ramSize), LanSpec(string(lanName), lanSpeed)});
+        return true;
+    }
+
+    static bool IsBlank(string_view line) {
+        return all_of(line.begin(), line.end(), IsSpace);
+    }
+
+    // Последовательный разбор [begin, end), begin стоит на начале записи. Пустые строки
+    // допускаются только в конце; firstLine - номер первой строки для сообщения об ошибке
+    static bool ParseChunk(const char* begin, const char* end, size_t firstLine, vector<ClusterNode>& out, size_t& errorLine) {
+        string_view lines[4];
+        size_t filled = 0;
+        size_t line = firstLine;
+        for (const char* p = begin; p < end; ++line) {
+            const char* newline = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+            const char* lineEnd = newline == nullptr ? end : newline;
+            lines[filled++] = string_view(p, size_t(lineEnd - p));
+            p = newline == nullptr ? end : newline + 1;
+            if (filled == 4) {
+                if (!ParseRecord(lines, out)) {
+                    errorLine = line - 3;
+                    return false;
+                }
+                filled = 0;
+            }
+        }
+        for (size_t i = 0; i < filled; ++i) {
+            if (!IsBlank(lines[i])) {
+                errorLine = line - filled;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Разбор тела, которое начинается на границе записи. Части делятся в три прохода:
+    // параллельный подсчёт строк, сдвиг каждой границы к началу ближайшей записи и
+    // параллельный разбор частей в собственные векторы
+    static bool ParseRecords(const char* data, size_t size, size_t threads, size_t firstLine, vector<ClusterNode>& out, size_t& errorLine) {
+        const size_t parts = size < PARALLEL_THRESHOLD ? 1 : min(threads, size / (PARALLEL_THRESHOLD / 4));
+        if (parts <= 1) {
+            return ParseChunk(data, data + size, firstLine, out, errorLine);
+        }
+        vector<size_t> lineCounts(parts);
+        {
+            vector<future<void>> counting;
+            for (size_t k = 0; k < parts; ++k) {
+                counting.push_back(async(launch::async, [&, k]() {
+                    const char* p = data + size * k / parts;
+                    const char* end = data + size * (k + 1) / parts;
+                    size_t count = 0;
+                    while ((p = static_cast<const char*>(memchr(p, '\n', size_t(end - p)))) != nullptr) {
+                        ++count;
+                        ++p;
+                    }
+                    lineCounts[k] = count;
+                }));
+            }
+            for (auto& part : counting) {
+                part.get();
+            }
+        }
+        auto nextLine = [&](size_t pos) {
+            const char* newline = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+            return newline == nullptr ? size : size_t(newline - data) + 1;
+        };
+        vector<size_t> starts(parts + 1, size), startLines(parts + 1, 0);
+        size_t linesBefore = 0;
+        for (size_t k = 0; k < parts; ++k) {
+            size_t pos = size * k / parts;
+            size_t line = linesBefore;
+            if (pos > 0 && data[pos - 1] != '\n') {
+                pos = nextLine(pos);
+                ++line;
+            }
+            while (line % 4 != 0 && pos < size) {
+                pos = nextLine(pos);
+                ++line;
+            }
+            starts[k] = pos;
+            startLines[k] = line;
+            linesBefore += lineCounts[k];
+        }
+
+        vector<vector<ClusterNode>> results(parts);
+        vector<size_t> errors(parts, 0);
+        vector<future<bool>> parsing;
+        for (size_t k = 0; k < parts; ++k) {
+            parsing.push_back(async(launch::async, [&, k]() {
+                results[k].reserve((lineCounts[k] + 4) / 4);
+                return ParseChunk(data + starts[k], data + starts[k + 1], firstLine + startLines[k], results[k], errors[k]);
+            }));
+        }
+        bool ok = true;
+        for (size_t k = 0; k < parts; ++k) {
+            if (!parsing[k].get() && ok) {
+                ok = false;
+                errorLine = errors[k];
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+        size_t total = out.size();
+        for (const auto& part : results) {
+            total += part.size();
+        }
+        out.reserve(total);
+        for (auto& part : results) {
+            out.insert(out.end(), make_move_iterator(part.begin()), make_move_iterator(part.end()));
+        }
+        return true;
+    }
+
+    // Как Cluster::Import: узлов меньше счётчика - ошибка, лишние игнорируются
+    static bool Finish(vector<ClusterNode>& nodes, size_t nodeCount, Cluster& cluster) {
+        if (nodes.size() < nodeCount) {
+            cerr << "Error reading node data: expected " << nodeCount << " nodes, found " << nodes.size() << endl;
+            return false;
+        }
+        nodes.erase(nodes.begin() + ptrdiff_t(nodeCount), nodes.end());
+        cluster.Nodes = move(nodes);
+        return true;
+    }
+};
@@ -0,0 +1,467 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include "cluster_columns.h"
+#include <unordered_map>
+
+// Поля с названиями моделей, по которым строится хеш-индекс
+enum class NameField {
+    CpuName,
+    GpuName,
+    RamType,
+    LanAdapter
+};
+
+// Условие на название: поле == значение
+struct NameCondition {
+    NameField Field;
+    string Value;
+};
+
+// Битовая карта узлов: бит i - узел с номером i
+class NodeBitmap {
+public:
+    vector<uint64_t> Words;
+
+    NodeBitmap() = default;
+    explicit NodeBitmap(size_t bits, bool value = false) : Words((bits + 63) / 64, value ? ~uint64_t(0) : 0) {
+        if (value && bits % 64 != 0) {
+            Words.back() = (uint64_t(1) << (bits % 64)) - 1;
+        }
+    }
+
+    void Set(size_t i) { Words[i / 64] |= uint64_t(1) << (i % 64); }
+    bool Test(size_t i) const { return (Words[i / 64] >> (i % 64)) & 1; }
+
+    // Пересечение и разность; слова за концом более короткой карты считаются нулями
+    void And(const NodeBitmap& other) {
+        const size_t common = min(Words.size(), other.Words.size());
+        for (size_t w = 0; w < common; ++w) {
+            Words[w] &= other.Words[w];
+        }
+        fill(Words.begin() + common, Words.end(), 0);
+    }
+
+    void AndNot(const NodeBitmap& other) {
+        const size_t common = min(Words.size(), other.Words.size());
+        for (size_t w = 0; w < common; ++w) {
+            Words[w] &= ~other.Words[w];
+        }
+    }
+
+    // Пересечение с upper без lower (lower == nullptr - пустая карта)
+    void AndRange(const NodeBitmap& upper, const NodeBitmap* lower) {
+        const size_t common = min(Words.size(), upper.Words.size());
+        for (size_t w = 0; w < common; ++w) {
+            const uint64_t below = lower != nullptr && w < lower->Words.size() ? lower->Words[w] : 0;
+            Words[w] &= upper.Words[w] & ~below;
+        }
+        fill(Words.begin() + common, Words.end(), 0);
+    }
+
+    void Clear() { fill(Words.begin(), Words.end(), 0); }
+
+    size_t Count() const {
+        size_t count = 0;
+        for (uint64_t word : Words) {
+            count += size_t(__builtin_popcountll(word));
+        }
+        return count;
+    }
+
+    vector<size_t> ToIndices() const {
+        vector<size_t> result;
+        for (size_t w = 0; w < Words.size(); ++w) {
+            for (uint64_t word = Words[w]; word != 0; word &= word - 1) {
+                result.push_back(w * 64 + size_t(__builtin_ctzll(word)));
+            }
+        }
+        return result;
+    }
+};
+
+// Индекс одного числового поля. Пока различных значений не больше BITMAP_LIMIT, индекс
+// битовый с диапазонным кодированием: AtMost[j] - узлы со значением <= Values[j], так что
+// любое сравнение стоит одного прохода по карте. При большем числе значений индекс
+// переходит в отсортированный массив пар (значение, узел) с небольшим несортированным
+// хвостом новых узлов, который вливается в массив при переполнении. Узлы со значением NaN
+// не входят ни в одну из этих структур (для них ложно любое сравнение) и хранятся в NaNs.
+class FieldIndex {
+public:
+    static const size_t BITMAP_LIMIT = 64;
+    static const size_t DELTA_LIMIT = 4096;
+
+    bool IsBitmap() const { return Bitmapped; }
+
+    // Построение сразу по всем значениям
+    void Build(const vector<double>& values) {
+        Size = values.size();
+        NaNs = NodeBitmap(Size);
+        vector<double> distinct;
+        distinct.reserve(Size);
+        for (size_t i = 0; i < Size; ++i) {
+            if (std::isnan(values[i])) {
+                NaNs.Set(i);
+            } else {
+                distinct.push_back(values[i]);
+            }
+        }
+        sort(distinct.begin(), distinct.end());
+        distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+        Values.clear();
+        AtMost.clear();
+        Sorted.clear();
+        Delta.clear();
+        Bitmapped = distinct.size() <= BITMAP_LIMIT;
+        if (Bitmapped) {
+            Values = distinct;
+            AtMost.assign(Values.size(), NodeBitmap(Size));
+            for (size_t i = 0; i < Size; ++i) {
+                if (!std::isnan(values[i])) {
+                    AtMost[Position(values[i])].Set(i);
+                }
+            }
+            // карты равенства превращаются в накопленные "<="
+            for (size_t j = 1; j < AtMost.size(); ++j) {
+                for (size_t w = 0; w < AtMost[j].Words.size(); ++w) {
+                    AtMost[j].Words[w] |= AtMost[j - 1].Words[w];
+                }
+            }
+        } else {
+            Sorted.reserve(Size);
+            for (size_t i = 0; i < Size; ++i) {
+                if (!std::isnan(values[i])) {
+                    Sorted.push_back({values[i], uint32_t(i)});
+                }
+            }
+            sort(Sorted.begin(), Sorted.end());
+        }
+    }
+
+    // Добавление узла с номером Size
+    void Add(double value) {
+        const size_t node = Size++;
+        if (node % 64 == 0) {
+            NaNs.Words.push_back(0);
+            if (Bitmapped) {
+                for (auto& bitmap : AtMost) {
+                    bitmap.Words.push_back(0);
+                }
+            }
+        }
+        if (std::isnan(value)) {
+            NaNs.Set(node);
+            return;
+        }
+        if (!Bitmapped) {
+            Delta.push_back({value, uint32_t(node)});
+            if (Delta.size() >= DELTA_LIMIT) {
+                MergeDelta();
+            }
+            return;
+        }
+        size_t j = size_t(lower_bound(Values.begin(), Values.end(), value) - Values.begin());
+        if (j == Values.size() || Values[j] != value) {
+            if (Values.size() == BITMAP_LIMIT) {
+                ConvertToSorted();
+                Delta.push_back({value, uint32_t(node)});
+                return;
+            }
+            // новая карта "<= value" совпадает с предыдущей накопленной
+            Values.insert(Values.begin() + ptrdiff_t(j), value);
+            AtMost.insert(AtMost.begin() + ptrdiff_t(j), j > 0 ? AtMost[j - 1] : NodeBitmap(Size));
+        }
+        for (size_t k = j; k < AtMost.size(); ++k) {
+            AtMost[k].Set(node);
+        }
+    }
+
+    // result &= узлы, для которых значение op value
+    void Restrict(Compare op, double value, NodeBitmap& result) const {
+        if (std::isnan(value)) {
+            // любое сравнение с NaN ложно, а двоичный поиск с ним вернул бы весь диапазон
+            result.Clear();
+            return;
+        }
+        if (Bitmapped) {
+            // карты узлов со значением < value и <= value (nullptr - таких узлов нет)
+            const size_t below = size_t(lower_bound(Values.begin(), Values.end(), value) - Values.begin());
+            const size_t upTo = size_t(upper_bound(Values.begin(), Values.end(), value) - Values.begin());
+            const NodeBitmap* less = below > 0 ? &AtMost[below - 1] : nullptr;
+            const NodeBitmap* lessEqual = upTo > 0 ? &AtMost[upTo - 1] : nullptr;
+            switch (op) {
+            case Compare::Less: Keep(less, result); break;
+            case Compare::LessEqual: Keep(lessEqual, result); break;
+            case Compare::Greater: if (lessEqual != nullptr) result.AndNot(*lessEqual); result.AndNot(NaNs); break;
+            case Compare::GreaterEqual: if (less != nullptr) result.AndNot(*less); result.AndNot(NaNs); break;
+            default:
+                if (below == upTo) {
+                    result.Clear();
+                } else {
+                    result.AndRange(*lessEqual, less);
+                }
+                break;
+            }
+            return;
+        }
+        NodeBitmap matches(result.Words.size() * 64);
+        auto lo = Sorted.begin(), hi = Sorted.end();
+        const pair<double, uint32_t> low(value, 0), high(value, numeric_limits<uint32_t>::max());
+        switch (op) {
+        case Compare::Less: hi = lower_bound(Sorted.begin(), Sorted.end(), low); break;
+        case Compare::LessEqual: hi = upper_bound(Sorted.begin(), Sorted.end(), high); break;
+        case Compare::Greater: lo = upper_bound(Sorted.begin(), Sorted.end(), high); break;
+        case Compare::GreaterEqual: lo = lower_bound(Sorted.begin(), Sorted.end(), low); break;
+        default:
+            lo = lower_bound(Sorted.begin(), Sorted.end(), low);
+            hi = upper_bound(Sorted.begin(), Sorted.end(), high);
+            break;
+        }
+        for (auto it = lo; it < hi; ++it) {
+            matches.Set(it->second);
+        }
+        for (const auto& entry : Delta) {
+            if (Matches(entry.first, op, value)) {
+                matches.Set(entry.second);
+            }
+        }
+        result.And(matches);
+    }
+
+    size_t MemoryBytes() const {
+        size_t bytes = Values.capacity() * sizeof(double) + NaNs.Words.capacity() * sizeof(uint64_t) + (Sorted.capacity() + Delta.capacity()) * sizeof(pair<double, uint32_t>);
+        for (const auto& bitmap : AtMost) {
+            bytes += bitmap.Words.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+
+private:
+    size_t Size = 0;
+    bool Bitmapped = true;
+    vector<double> Values;                    // различные значения по возрастанию
+    vector<NodeBitmap> AtMost;
+    vector<pair<double, uint32_t>> Sorted;
+    vector<pair<double, uint32_t>> Delta;     // новые узлы, ещё не влитые в Sorted
+    NodeBitmap NaNs;                          // узлы со значением NaN
+
+    size_t Position(double value) const {
+        return size_t(lower_bound(Values.begin(), Values.end(), value) - Values.begin());
+    }
+
+    static void Keep(const NodeBitmap* bitmap, NodeBitmap& result) {
+        if (bitmap == nullptr) {
+            result.Clear();
+        } else {
+            result.And(*bitmap);
+        }
+    }
+
+    static bool Matches(double x, Compare op, double value) {
+        switch (op) {
+        case Compare::Less: return x < value;
+        case Compare::LessEqual: return x <= value;
+        case Compare::Greater: return x > value;
+        case Compare::GreaterEqual: return x >= value;
+        default: return x == value;
+        }
+    }
+
+    void MergeDelta() {
+        const size_t middle = Sorted.size();
+        sort(Delta.begin(), Delta.end());
+        Sorted.insert(Sorted.end(), Delta.begin(), Delta.end());
+        inplace_merge(Sorted.begin(), Sorted.begin() + ptrdiff_t(middle), Sorted.end());
+        Delta.clear();
+    }
+
+    // Узлы со значением Values[j] - это AtMost[j] без AtMost[j - 1]
+    void ConvertToSorted() {
+        Sorted.clear();
+        Sorted.reserve(Size);
+        for (size_t j = 0; j < Values.size(); ++j) {
+            for (size_t w = 0; w < AtMost[j].Words.size(); ++w) {
+                uint64_t word = AtMost[j].Words[w] & ~(j > 0 ? AtMost[j - 1].Words[w] : 0);
+                for (; word != 0; word &= word - 1) {
+                    Sorted.push_back({Values[j], uint32_t(w * 64 + size_t(__builtin_ctzll(word)))});
+                }
+            }
+        }
+        sort(Sorted.begin(), Sorted.end());
+        Values.clear();
+        AtMost.clear();
+        Bitmapped = false;
+    }
+};
+
+// Вторичные индексы кластера: FieldIndex на каждое числовое поле и хеш-индекс
+// название -> номера узлов на каждое поле с названием модели. Многоусловный запрос
+// пересекает битовые карты условий
+class ClusterIndex {
+public:
+    ClusterIndex() = default;
+
+    explicit ClusterIndex(const Cluster& cluster) {
+        Build(cluster);
+    }
+
+    void Build(const Cluster& cluster) {
+        NodeCount = cluster.Nodes.size();
+        vector<double> values(NodeCount);
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            for (size_t i = 0; i < NodeCount; ++i) {
+                values[i] = Value(cluster.Nodes[i], NodeField(f));
+            }
+            Fields[f].Build(values);
+        }
+        for (auto& entries : Names) {
+            entries.clear();
+        }
+        for (size_t i = 0; i < NodeCount; ++i) {
+            AddNames(cluster.Nodes[i], i);
+        }
+    }
+
+    // Вызывается вместе с Cluster::AddNode для того же узла
+    void AddNode(const ClusterNode& node) {
+        for (size_t f = 0; f < FIELD_COUNT; ++f) {
+            Fields[f].Add(Value(node, NodeField(f)));
+        }
+        AddNames(node, NodeCount++);
+    }
+
+    size_t Size() const { return NodeCount; }
+
+    // Карта узлов, удовлетворяющих всем условиям
+    NodeBitmap Match(const vector<Condition>& where, const vector<NameCondition>& names = {}) const {
+        NodeBitmap result(NodeCount, true);
+        for (const auto& condition : names) {
+            const auto& entries = Names[size_t(condition.Field)];
+            auto found = entries.find(condition.Value);
+            if (found == entries.end()) {
+                result.Clear();
+            } else if (!found->second.Dense.Words.empty()) {
+                result.And(found->second.Dense);
+            } else {
+                NodeBitmap matches(NodeCount);
+                for (uint32_t node : found->second.Nodes) {
+                    matches.Set(node);
+                }
+                result.And(matches);
+            }
+        }
+        for (const auto& condition : where) {
+            Fields[size_t(condition.Field)].Restrict(condition.Op, condition.Value, result);
+        }
+        return result;
+    }
+
+    size_t Count(const vector<Condition>& where, const vector<NameCondition>& names = {}) const {
+        return Match(where, names).Count();
+    }
+
+    // Номера узлов по возрастанию
+    vector<size_t> Select(const vector<Condition>& where, const vector<NameCondition>& names = {}) const {
+        return Match(where, names).ToIndices();
+    }
+
+    // Номера узлов с данным названием по возрастанию; пустой список, если таких нет
+    const vector<uint32_t>& WithName(NameField field, const string& name) const {
+        static const vector<uint32_t> none;
+        const auto& entries = Names[size_t(field)];
+        auto found = entries.find(name);
+        return found == entries.end() ? none : found->second.Nodes;
+    }
+
+    const FieldIndex& Field(NodeField field) const { return Fields[size_t(field)]; }
+
+    size_t MemoryBytes() const {
+        size_t bytes = 0;
+        for (const auto& field : Fields) {
+            bytes += field.MemoryBytes();
+        }
+        for (const auto& entries : Names) {
+            for (const auto& entry : entries) {
+                bytes += entry.first.capacity() + entry.second.Nodes.capacity() * sizeof(uint32_t) +
+                         entry.second.Dense.Words.capacity() * sizeof(uint64_t);
+            }
+        }
+        return bytes;
+    }
+
+    static double Value(const ClusterNode& node, NodeField field) {
+        switch (field) {
+        case NodeField::CpuCores: return node.Cpu.Cores;
+        case NodeField::CpuFrequency: return node.Cpu.Frequency;
+        case NodeField::GpuMemory: return node.Gpu.Memory;
+        case NodeField::GpuCores: return node.Gpu.Cores;
+        case NodeField::RamSize: return node.Ram.Size;
+        default: return node.Lan.Speed;
+        }
+    }
+
+private:
+    static const size_t FIELD_COUNT = 6;
+    static const size_t NAME_FIELD_COUNT = 4;
+
+    // Список узлов с названием; у частых названий (не реже 1/DENSE_FRACTION узлов)
+    // ещё и битовая карта, чтобы пересечение не строило её заново
+    struct NameEntry {
+        vector<uint32_t> Nodes;
+        NodeBitmap Dense;
+    };
+    static const size_t DENSE_FRACTION = 32;
+
+    size_t NodeCount = 0;
+    FieldIndex Fields[FIELD_COUNT];
+    unordered_map<string, NameEntry> Names[NAME_FIELD_COUNT];
+
+    void AddName(NameField field, const string& name, size_t index) {
+        NameEntry& entry = Names[size_t(field)][name];
+        entry.Nodes.push_back(uint32_t(index));
+        if (!entry.Dense.Words.empty()) {
+            entry.Dense.Words.resize(index / 64 + 1, 0);
+            entry.Dense.Set(index);
+        } else if (entry.Nodes.size() * DENSE_FRACTION >= NodeCount && entry.Nodes.size() >= 64) {
+            entry.Dense = NodeBitmap(index + 1);
+            for (uint32_t node : entry.Nodes) {
+                entry.Dense.Set(node);
+            }
+        }
+    }
+
+    void AddNames(const ClusterNode& node, size_t index) {
+        AddName(NameField::CpuName, node.Cpu.Name, index);
+        AddName(NameField::GpuName, node.Gpu.Name, index);
+        AddName(NameField::RamType, node.Ram.Type, index);
+        AddName(NameField::LanAdapter, node.Lan.AdapterName, index);
+    }
+};
+
+// Кластер с поддерживаемыми индексами: AddNode обновляет узлы и индексы вместе
+class IndexedCluster {
+public:
+    IndexedCluster() = default;
+
+    explicit IndexedCluster(Cluster cluster) : Inventory(move(cluster)), Index(Inventory) {}
+
+    void AddNode(const ClusterNode& node) {
+        Inventory.AddNode(node);
+        Index.AddNode(node);
+    }
+
+    const Cluster& Nodes() const { return Inventory; }
+    const ClusterIndex& Indexes() const { return Index; }
+
+    size_t Count(const vector<Condition>& where, const vector<NameCondition>& names = {}) const {
+        return Index.Count(where, names);
+    }
+
+    vector<size_t> Select(const vector<Condition>& where, const vector<NameCondition>& names = {}) const {
+        return Index.Select(where, names);
+    }
+
+private:
+    Cluster Inventory;
+    ClusterIndex Index;
+};
@@ -0,0 +1,487 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include "cluster_snapshot.h"
+#include <array>
+#include <cstdio>
+#include <filesystem>
+
+// Журнал изменений кластера (write-ahead log) поверх бинарного снимка:
+//   base.snap - снимок поколения G (cluster_snapshot.h);
+//   base.wal  - изменения после этого снимка: заголовок "CLSTRWAL" + uint64 поколение G,
+//               затем записи [uint32 длина][uint32 CRC32][данные]. Данные: uint8 операция
+//               (1 - AddNode, 2 - UpdateNode, 3 - RemoveNode), uint64 номер узла (кроме
+//               AddNode), узел (кроме RemoveNode): 4 названия (uint32 длина + байты),
+//               4 int32 и 2 double в порядке байт машины.
+// Изменения копятся в памяти и дописываются в журнал с fsync пачками по SyncEvery записей
+// (или по Sync()), так что стоимость записи зависит от числа изменений, а не от размера
+// кластера. Когда записей в журнале больше, чем узлов (и не меньше CompactMinRecords),
+// журнал сворачивается в новый снимок поколения G + 1; ошибка такого автоматического
+// сворачивания не делает записанные изменения неудачными и лишь считается в
+// JournalStats::FailedCompactions: данные восстановимы, а если не удалось начать новый
+// журнал, он закрывается до повторного Open. Восстановление: снимок, затем
+// хвост журнала; оборванная или испорченная последняя запись отбрасывается. Журнал
+// старого поколения (сбой посреди сворачивания) уже учтён в снимке и пропускается.
+// Изменение сразу видно в Nodes(). Если пачку не удалось записать, все изменения после
+// последней успешной записи откатываются в памяти, а файл обрезается до прежней длины:
+// Nodes() совпадает с тем, что восстановит Open. Если обрезать файл не удалось, журнал
+// закрывается, и до повторного Open изменения не принимаются.
+struct JournalOptions {
+    size_t SyncEvery = 64;
+    size_t CompactMinRecords = 4096;
+};
+
+struct JournalStats {
+    size_t Replayed = 0;        // записей применено при открытии
+    size_t Records = 0;         // записей в текущем журнале
+    size_t Syncs = 0;
+    size_t BytesWritten = 0;
+    size_t Compactions = 0;
+    size_t FailedCompactions = 0;  // неудачных автоматических сворачиваний
+};
+
+class JournaledCluster {
+public:
+    explicit JournaledCluster(JournalOptions options = JournalOptions()) : Options(options) {}
+
+    JournaledCluster(const JournaledCluster&) = delete;
+    JournaledCluster& operator=(const JournaledCluster&) = delete;
+
+    ~JournaledCluster() {
+        Close();
+    }
+
+    // Загрузка base.snap и повтор base.wal; файлов может не быть - тогда кластер пуст
+    bool Open(const string& basePath) {
+        Close();
+        SnapshotPath = basePath + ".snap";
+        LogPath = basePath + ".wal";
+        Data = Cluster();
+        Counters = JournalStats();
+        Generation = 0;
+        error_code error;
+        if (filesystem::exists(SnapshotPath, error)) {
+            ClusterSnapshot snapshot;
+            if (!snapshot.Open(SnapshotPath)) {
+                return false;
+            }
+            Data = snapshot.ToCluster();
+            Generation = snapshot.Generation();
+        }
+
+        string log;
+        {
+            ifstream in(LogPath, ios::binary);
+            if (in.is_open()) {
+                log.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            }
+        }
+        bool replay = false;
+        if (log.size() >= HEADER_SIZE) {
+            uint64_t logGeneration;
+            memcpy(&logGeneration, log.data() + 8, sizeof(logGeneration));
+            if (memcmp(log.data(), LOG_MAGIC, 8) != 0) {
+                cerr << "Not a cluster change log: " << LogPath << endl;
+                return false;
+            }
+            if (logGeneration > Generation) {
+                cerr << "Change log is newer than snapshot: " << LogPath << endl;
+                return false;
+            }
+            replay = logGeneration == Generation;
+        }
+        size_t validEnd = HEADER_SIZE;
+        if (replay) {
+            validEnd = Replay(log);
+        }
+        if (!replay || validEnd < log.size()) {
+            if (replay) {
+                cerr << "Dropping " << log.size() - validEnd << " bytes of torn change log tail" << endl;
+            }
+            // журнал начинается заново или обрезается по последней целой записи
+            if (!replay ? !CreateLog() : !TruncateLog(validEnd)) {
+                return false;
+            }
+        }
+        LogBytes = replay ? validEnd : HEADER_SIZE;
+        return OpenLog();
+    }
+
+    bool IsOpen() const { return File != nullptr; }
+
+    const Cluster& Nodes() const { return Data; }
+    const JournalStats& Stats() const { return Counters; }
+
+    bool AddNode(const ClusterNode& node) {
+        if (!CheckOpen()) {
+            return false;
+        }
+        string record(1, char(OP_ADD));
+        PutNode(record, node);
+        Changes.push_back({OP_ADD, Data.Nodes.size(), ClusterNode()});
+        Data.AddNode(node);
+        return Append(record);
+    }
+
+    bool UpdateNode(size_t index, const ClusterNode& node) {
+        if (!CheckOpen() || !CheckIndex(index)) {
+            return false;
+        }
+        string record(1, char(OP_UPDATE));
+        Put(record, uint64_t(index));
+        PutNode(record, node);
+        Changes.push_back({OP_UPDATE, index, Data.Nodes[index]});
+        Data.Nodes[index] = node;
+        return Append(record);
+    }
+
+    // Удаление за O(1): на место удалённого узла переезжает последний
+    bool RemoveNode(size_t index) {
+        if (!CheckOpen() || !CheckIndex(index)) {
+            return false;
+        }
+        string record(1, char(OP_REMOVE));
+        Put(record, uint64_t(index));
+        Changes.push_back({OP_REMOVE, index, Data.Nodes[index]});
+        Remove(index);
+        return Append(record);
+    }
+
+    // Дописать накопленные изменения и дождаться их записи на диск. Результат - успех
+    // записи: изменения уже надёжны, даже если следующее за ней сворачивание не удалось
+    bool Sync() {
+        if (!Flush()) {
+            return false;
+        }
+        if (Counters.Records >= max(Options.CompactMinRecords, Data.Nodes.size()) && !Compact()) {
+            ++Counters.FailedCompactions;
+        }
+        return true;
+    }
+
+    // Свернуть журнал в снимок следующего поколения и начать пустой журнал
+    bool Compact() {
+        if (!CheckOpen() || !Flush()) {
+            return false;
+        }
+        const string temporary = SnapshotPath + ".tmp";
+        error_code error;
+        if (!WriteClusterSnapshot(Data, temporary, Generation + 1, true)) {
+            return false;
+        }
+        filesystem::rename(temporary, SnapshotPath, error);
+        if (error) {
+            cerr << "Error replacing snapshot: " << SnapshotPath << endl;
+            return false;
+        }
+        SyncPath(Directory());
+        // с этого момента старый журнал считается учтённым в снимке
+        ++Generation;
+        fclose(File);
+        File = nullptr;
+        if (!CreateLog() || !OpenLog()) {
+            return false;
+        }
+        ++Counters.Compactions;
+        return true;
+    }
+
+    void Close() {
+        if (File != nullptr) {
+            Flush();  // при ошибке Rollback мог уже закрыть журнал
+        }
+        if (File != nullptr) {
+            fclose(File);
+            File = nullptr;
+        }
+    }
+
+private:
+    enum Operation : uint8_t {
+        OP_ADD = 1,
+        OP_UPDATE = 2,
+        OP_REMOVE = 3
+    };
+    static constexpr char LOG_MAGIC[8] = {'C', 'L', 'S', 'T', 'R', 'W', 'A', 'L'};
+    static const size_t HEADER_SIZE = 16;
+
+    JournalOptions Options;
+    JournalStats Counters;
+    Cluster Data;
+    string SnapshotPath;
+    string LogPath;
+    uint64_t Generation = 0;
+    FILE* File = nullptr;
+    string Pending;              // записи, ещё не дописанные в файл
+    size_t PendingRecords = 0;
+    uint64_t LogBytes = 0;       // длина журнала на диске после последней успешной записи
+
+    // Отмена изменения из Pending: операция, номер узла и узел до изменения
+    struct Change {
+        Operation Op;
+        size_t Index;
+        ClusterNode Previous;
+    };
+    vector<Change> Changes;
+
+    bool CheckOpen() const {
+        if (File == nullptr) {
+            cerr << "Change log is not open" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool CheckIndex(size_t index) const {
+        if (index >= Data.Nodes.size()) {
+            cerr << "Node index out of range: " << index << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Дописывание без буфера stdio: пачку и так собирает Pending, а после ошибки записи в
+    // буфере не должно остаться данных, которые допишутся позже
+    bool OpenLog() {
+        File = fopen(LogPath.c_str(), "ab");
+        if (File == nullptr) {
+            cerr << "Error opening change log: " << LogPath << endl;
+            return false;
+        }
+        setvbuf(File, nullptr, _IONBF, 0);
+        return true;
+    }
+
+    void Remove(size_t index) {
+        if (index + 1 != Data.Nodes.size()) {
+            Data.Nodes[index] = move(Data.Nodes.back());
+        }
+        Data.Nodes.pop_back();
+    }
+
+    string Directory() const {
+        const filesystem::path parent = filesystem::path(LogPath).parent_path();
+        return parent.empty() ? "." : parent.string();
+    }
+
+    static uint32_t Crc32(const char* data, size_t size) {
+        static const auto table = []() {
+            array<uint32_t, 256> values{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                values[i] = c;
+            }
+            return values;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ uint8_t(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    template <typename T>
+    static void Put(string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void PutName(string& out, const string& name) {
+        Put(out, uint32_t(name.size()));
+        out += name;
+    }
+
+    static void PutNode(string& out, const ClusterNode& node) {
+        PutName(out, node.Cpu.Name);
+        PutName(out, node.Gpu.Name);
+        PutName(out, node.Ram.Type);
+        PutName(out, node.Lan.AdapterName);
+        Put(out, int32_t(node.Cpu.Cores));
+        Put(out, int32_t(node.Gpu.Memory));
+        Put(out, int32_t(node.Gpu.Cores));
+        Put(out, int32_t(node.Ram.Size));
+        Put(out, node.Cpu.Frequency);
+        Put(out, node.Lan.Speed);
+    }
+
+    // Чтение из [position, end) с проверкой границ
+    template <typename T>
+    static bool Get(const char*& position, const char* end, T& value) {
+        if (size_t(end - position) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, position, sizeof(value));
+        position += sizeof(value);
+        return true;
+    }
+
+    static bool GetName(const char*& position, const char* end, string& name) {
+        uint32_t size;
+        if (!Get(position, end, size) || size_t(end - position) < size) {
+            return false;
+        }
+        name.assign(position, size);
+        position += size;
+        return true;
+    }
+
+    static bool GetNode(const char*& position, const char* end, ClusterNode& node) {
+        int32_t cpuCores, gpuMemory, gpuCores, ramSize;
+        if (!GetName(position, end, node.Cpu.Name) || !GetName(position, end, node.Gpu.Name) ||
+            !GetName(position, end, node.Ram.Type) || !GetName(position, end, node.Lan.AdapterName) ||
+            !Get(position, end, cpuCores) || !Get(position, end, gpuMemory) || !Get(position, end, gpuCores) ||
+            !Get(position, end, ramSize) || !Get(position, end, node.Cpu.Frequency) || !Get(position, end, node.Lan.Speed)) {
+            return false;
+        }
+        node.Cpu.Cores = cpuCores;
+        node.Gpu.Memory = gpuMemory;
+        node.Gpu.Cores = gpuCores;
+        node.Ram.Size = ramSize;
+        return true;
+    }
+
+    // Применить одну запись; false - запись не разбирается или не подходит к кластеру
+    bool Apply(const char* position, const char* end) {
+        uint8_t op;
+        uint64_t index = 0;
+        ClusterNode node;
+        if (!Get(position, end, op)) {
+            return false;
+        }
+        if (op != OP_ADD && (!Get(position, end, index) || index >= Data.Nodes.size())) {
+            return false;
+        }
+        if (op != OP_REMOVE && !GetNode(position, end, node)) {
+            return false;
+        }
+        if (position != end) {
+            return false;
+        }
+        switch (op) {
+        case OP_ADD: Data.AddNode(node); return true;
+        case OP_UPDATE: Data.Nodes[size_t(index)] = move(node); return true;
+        case OP_REMOVE: Remove(size_t(index)); return true;
+        default: return false;
+        }
+    }
+
+    // Повтор записей журнала; возвращает конец последней применённой записи
+    size_t Replay(const string& log) {
+        size_t position = HEADER_SIZE;
+        while (log.size() - position >= 8) {
+            uint32_t size, crc;
+            memcpy(&size, log.data() + position, 4);
+            memcpy(&crc, log.data() + position + 4, 4);
+            const char* data = log.data() + position + 8;
+            if (log.size() - position - 8 < size || Crc32(data, size) != crc || !Apply(data, data + size)) {
+                break;
+            }
+            position += 8 + size;
+            ++Counters.Replayed;
+        }
+        Counters.Records = Counters.Replayed;
+        return position;
+    }
+
+    bool Append(const string& record) {
+        Put(Pending, uint32_t(record.size()));
+        Put(Pending, Crc32(record.data(), record.size()));
+        Pending += record;
+        if (++PendingRecords >= Options.SyncEvery) {
+            return Sync();
+        }
+        return true;
+    }
+
+    // Запись накопленного и fsync, без сворачивания
+    bool Flush() {
+        if (Pending.empty()) {
+            return true;
+        }
+        bool ok = fwrite(Pending.data(), 1, Pending.size(), File) == Pending.size() && fflush(File) == 0;
+#if defined(_WIN32)
+        ok = ok && _commit(_fileno(File)) == 0;
+#else
+        ok = ok && fsync(fileno(File)) == 0;
+#endif
+        if (!ok) {
+            cerr << "Error writing change log: " << LogPath << endl;
+            Rollback();
+            return false;
+        }
+        LogBytes += Pending.size();
+        Changes.clear();
+        Counters.BytesWritten += Pending.size();
+        Counters.Records += PendingRecords;
+        ++Counters.Syncs;
+        Pending.clear();
+        PendingRecords = 0;
+        return true;
+    }
+
+    // Отмена изменений Pending в обратном порядке и обрезка частично записанной пачки
+    void Rollback() {
+        for (size_t i = Changes.size(); i-- > 0;) {
+            Change& change = Changes[i];
+            switch (change.Op) {
+            case OP_ADD:
+                Data.Nodes.pop_back();
+                break;
+            case OP_UPDATE:
+                Data.Nodes[change.Index] = move(change.Previous);
+                break;
+            case OP_REMOVE:
+                // на место удалённого переехал последний узел: он возвращается в конец
+                if (change.Index == Data.Nodes.size()) {
+                    Data.Nodes.push_back(move(change.Previous));
+                } else {
+                    Data.Nodes.push_back(move(Data.Nodes[change.Index]));
+                    Data.Nodes[change.Index] = move(change.Previous);
+                }
+                break;
+            }
+        }
+        Changes.clear();
+        Pending.clear();
+        PendingRecords = 0;
+        if (!TruncateLog(LogBytes)) {
+            fclose(File);
+            File = nullptr;
+        }
+    }
+
+    // Пустой журнал текущего поколения: пишется во временный файл и подменяет старый
+    bool CreateLog() {
+        const string temporary = LogPath + ".tmp";
+        {
+            ofstream out(temporary, ios::binary | ios::trunc);
+            out.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+            out.write(reinterpret_cast<const char*>(&Generation), sizeof(Generation));
+            if (!out) {
+                cerr << "Error creating change log: " << temporary << endl;
+                return false;
+            }
+        }
+        error_code error;
+        if (!SyncPath(temporary) || (filesystem::rename(temporary, LogPath, error), error)) {
+            cerr << "Error creating change log: " << LogPath << endl;
+            return false;
+        }
+        SyncPath(Directory());
+        Counters.Records = 0;
+        LogBytes = HEADER_SIZE;
+        return true;
+    }
+
+    bool TruncateLog(size_t size) {
+        error_code error;
+        filesystem::resize_file(LogPath, size, error);
+        if (error || !SyncPath(LogPath)) {
+            cerr << "Error truncating change log: " << LogPath << endl;
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,416 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <tuple>
+
+// Требования задачи к узлу: ядра, RAM и память GPU в МБ, пропускная способность в Гбит/с
+struct JobDemand {
+    int Cores = 0;
+    int RamSize = 0;
+    int GpuMemory = 0;
+    double Bandwidth = 0;
+};
+
+// Эвристики многомерной упаковки:
+//   FirstFitDecreasing - первый подходящий узел, задачи пакета по убыванию размера;
+//   BestFit - узел с наименьшим остатком после размещения;
+//   DotProduct - узел, остаток которого лучше всего совпадает по направлению с задачей
+//   (максимум скалярного произведения нормированных векторов)
+enum class PlacementHeuristic {
+    FirstFitDecreasing,
+    BestFit,
+    DotProduct
+};
+
+// Загрузка занятых узлов (хотя бы с одной задачей): доля использованной ёмкости по измерениям
+struct PackingReport {
+    size_t NodesUsed = 0;
+    double CoreUtilization = 0;
+    double RamUtilization = 0;
+    double GpuUtilization = 0;
+    double BandwidthUtilization = 0;
+};
+
+// Остаток ёмкости узлов и размещение задач. Поиск идёт по дереву свободной ёмкости: в каждой
+// вершине - наибольший остаток поддерева по каждому измерению и наименьшая сумма нормированных
+// остатков, так что поддеревья, где задаче не хватает места, пропускаются целиком, а BestFit и
+// DotProduct отсекают поддеревья, оценка которых не лучше уже найденного узла. Листья упорядочены
+// по конфигурации (сеть, GPU, RAM, ядра): одинаковые узлы соседствуют и границы вершин точнее.
+// FirstFitDecreasing отсекает по наименьшему номеру узла в поддереве и по-прежнему выбирает
+// подходящий узел с наименьшим номером.
+// Place/PlaceBatch/Release можно вызывать из нескольких потоков: поиск читает остатки и
+// дерево без блокировок, а резервирование берёт спин-блокировку одного выбранного узла,
+// перепроверяет остаток и повторяет поиск, если узел успели занять
+class PlacementEngine {
+public:
+    explicit PlacementEngine(const Cluster& cluster) : NodeCount(cluster.Nodes.size()), Nodes(new NodeState[NodeCount]), Capacity(NodeCount) {
+        for (size_t i = 0; i < NodeCount; ++i) {
+            const ClusterNode& node = cluster.Nodes[i];
+            Capacity[i] = {node.Cpu.Cores, node.Ram.Size, node.Gpu.Memory, Megabits(node.Lan.Speed)};
+            for (size_t d = 0; d < DIMENSIONS; ++d) {
+                Nodes[i].Remaining[d].store(Capacity[i][d], memory_order_relaxed);
+                Scale[d] = max(Scale[d], double(Capacity[i][d]));
+            }
+        }
+        for (double& scale : Scale) {
+            scale = scale > 0 ? 1.0 / scale : 0;
+        }
+        Leaves = 1;
+        while (Leaves < NodeCount) {
+            Leaves *= 2;
+        }
+        Order.resize(NodeCount);
+        iota(Order.begin(), Order.end(), 0);
+        stable_sort(Order.begin(), Order.end(), [&](size_t a, size_t b) {
+            return make_tuple(Capacity[a][3], Capacity[a][2], Capacity[a][1], Capacity[a][0]) <
+                   make_tuple(Capacity[b][3], Capacity[b][2], Capacity[b][1], Capacity[b][0]);
+        });
+        Position.resize(NodeCount);
+        for (size_t k = 0; k < NodeCount; ++k) {
+            Position[Order[k]] = k;
+        }
+        Tree.reset(new Summary[2 * Leaves]);
+        for (size_t i = 0; i < Leaves; ++i) {
+            Store(Leaves + i, i < NodeCount ? LeafBounds(Order[i]) : Bounds::Empty());
+        }
+        FirstNode.assign(2 * Leaves, NodeCount);
+        for (size_t k = 0; k < NodeCount; ++k) {
+            FirstNode[Leaves + k] = Order[k];
+        }
+        for (size_t t = Leaves - 1; t > 0; --t) {
+            Store(t, Combine(Load(2 * t), Load(2 * t + 1)));
+            FirstNode[t] = min(FirstNode[2 * t], FirstNode[2 * t + 1]);
+        }
+    }
+
+    size_t Size() const { return NodeCount; }
+
+    // Номер узла или -1, если задача никуда не помещается или требования некорректны
+    // (отрицательные или не числа)
+    int Place(const JobDemand& job, PlacementHeuristic heuristic) {
+        if (!Valid(job)) {
+            return -1;
+        }
+        const Demand demand = ToDemand(job);
+        for (;;) {
+            const size_t node = Find(demand, heuristic);
+            if (node == NodeCount) {
+                return -1;
+            }
+            if (TryReserve(node, demand)) {
+                return int(node);
+            }
+        }
+    }
+
+    // Пакет размещается по убыванию размера задач; результат - узлы в порядке jobs
+    vector<int> PlaceBatch(const vector<JobDemand>& jobs, PlacementHeuristic heuristic) {
+        vector<size_t> order(jobs.size());
+        iota(order.begin(), order.end(), 0);
+        vector<double> sizes(jobs.size());
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            sizes[j] = JobSize(ToDemand(jobs[j]));
+        }
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+        vector<int> nodes(jobs.size(), -1);
+        for (size_t j : order) {
+            nodes[j] = Place(jobs[j], heuristic);
+        }
+        return nodes;
+    }
+
+    // Возврат ёмкости завершившейся задачи; false - нет такого узла, требования некорректны
+    // или остаток превысил бы ёмкость узла (задача не была на нём размещена)
+    bool Release(const JobDemand& job, size_t node) {
+        if (node >= NodeCount || !Valid(job)) {
+            return false;
+        }
+        const Demand demand = ToDemand(job);
+        NodeState& state = Nodes[node];
+        Lock(state);
+        bool fits = true;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            fits = fits && state.Remaining[d].load(memory_order_relaxed) <= Capacity[node][d] - demand[d];
+        }
+        if (fits) {
+            for (size_t d = 0; d < DIMENSIONS; ++d) {
+                state.Remaining[d].store(state.Remaining[d].load(memory_order_relaxed) + demand[d], memory_order_relaxed);
+            }
+            Store(Leaves + Position[node], LeafBounds(node));
+        }
+        state.Locked.store(false, memory_order_release);
+        if (fits) {
+            Propagate(node);
+        }
+        return fits;
+    }
+
+    // Остаток узла; для несуществующего узла - нули
+    JobDemand Remaining(size_t node) const {
+        if (node >= NodeCount) {
+            return JobDemand();
+        }
+        const NodeState& state = Nodes[node];
+        JobDemand remaining;
+        remaining.Cores = state.Remaining[0].load(memory_order_relaxed);
+        remaining.RamSize = state.Remaining[1].load(memory_order_relaxed);
+        remaining.GpuMemory = state.Remaining[2].load(memory_order_relaxed);
+        remaining.Bandwidth = state.Remaining[3].load(memory_order_relaxed) / 1000.0;
+        return remaining;
+    }
+
+    PackingReport Report() const {
+        PackingReport report;
+        double used[DIMENSIONS] = {}, total[DIMENSIONS] = {};
+        for (size_t i = 0; i < NodeCount; ++i) {
+            bool busy = false;
+            int remaining[DIMENSIONS];
+            for (size_t d = 0; d < DIMENSIONS; ++d) {
+                remaining[d] = Nodes[i].Remaining[d].load(memory_order_relaxed);
+                busy = busy || remaining[d] != Capacity[i][d];
+            }
+            if (!busy) {
+                continue;
+            }
+            ++report.NodesUsed;
+            for (size_t d = 0; d < DIMENSIONS; ++d) {
+                used[d] += Capacity[i][d] - remaining[d];
+                total[d] += Capacity[i][d];
+            }
+        }
+        auto ratio = [&](size_t d) { return total[d] > 0 ? used[d] / total[d] : 0; };
+        report.CoreUtilization = ratio(0);
+        report.RamUtilization = ratio(1);
+        report.GpuUtilization = ratio(2);
+        report.BandwidthUtilization = ratio(3);
+        return report;
+    }
+
+private:
+    // Измерения: ядра, RAM, память GPU, сеть в Мбит/с (целые, чтобы остатки были атомарными)
+    static const size_t DIMENSIONS = 4;
+    using Demand = array<int, DIMENSIONS>;
+
+    // Два узла на строку кэша
+    struct alignas(32) NodeState {
+        atomic<int> Remaining[DIMENSIONS];
+        atomic<bool> Locked{false};
+    };
+
+    // Значения вершины дерева: наибольший остаток поддерева по измерениям (-1 - узлов нет)
+    // и наименьшая сумма нормированных остатков (по ней BestFit выбирает узел)
+    struct Bounds {
+        int Most[DIMENSIONS];
+        double Slack;
+
+        static Bounds Empty() {
+            Bounds bounds;
+            fill(begin(bounds.Most), end(bounds.Most), -1);
+            bounds.Slack = HUGE_VAL;
+            return bounds;
+        }
+
+        bool operator==(const Bounds& other) const {
+            return equal(begin(Most), end(Most), begin(other.Most)) && Slack == other.Slack;
+        }
+    };
+
+    struct alignas(32) Summary {
+        atomic<int> Most[DIMENSIONS];
+        atomic<double> Slack;
+    };
+
+    size_t NodeCount;
+    unique_ptr<NodeState[]> Nodes;
+    vector<Demand> Capacity;
+    double Scale[DIMENSIONS] = {};     // 1 / наибольшая ёмкость по измерению
+    size_t Leaves = 1;                 // лист узла i - вершина Leaves + Position[i], корень - 1
+    unique_ptr<Summary[]> Tree;
+    vector<size_t> Order;              // узлы в порядке листьев
+    vector<size_t> Position;           // место узла среди листьев
+    vector<size_t> FirstNode;          // наименьший номер узла в поддереве (NodeCount - узлов нет)
+
+    static int Megabits(double gigabits) {
+        return int(lround(gigabits * 1000));
+    }
+
+    static bool Valid(const JobDemand& job) {
+        return job.Cores >= 0 && job.RamSize >= 0 && job.GpuMemory >= 0 && job.Bandwidth >= 0 &&
+               job.Bandwidth <= numeric_limits<int>::max() / 1000.0;
+    }
+
+    Bounds Load(size_t t) const {
+        Bounds bounds;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            bounds.Most[d] = Tree[t].Most[d].load();
+        }
+        bounds.Slack = Tree[t].Slack.load();
+        return bounds;
+    }
+
+    void Store(size_t t, const Bounds& bounds) {
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            Tree[t].Most[d].store(bounds.Most[d]);
+        }
+        Tree[t].Slack.store(bounds.Slack);
+    }
+
+    static Bounds Combine(const Bounds& a, const Bounds& b) {
+        Bounds bounds;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            bounds.Most[d] = max(a.Most[d], b.Most[d]);
+        }
+        bounds.Slack = min(a.Slack, b.Slack);
+        return bounds;
+    }
+
+    double Slack(const int* remaining) const {
+        double slack = 0;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            slack += remaining[d] * Scale[d];
+        }
+        return slack;
+    }
+
+    // Значения листа по текущему остатку узла; вызывается под блокировкой узла
+    Bounds LeafBounds(size_t node) const {
+        Bounds bounds;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            bounds.Most[d] = Nodes[node].Remaining[d].load(memory_order_relaxed);
+        }
+        bounds.Slack = Slack(bounds.Most);
+        return bounds;
+    }
+
+    // Пересчёт предков листа. Вершина записывается заново, пока не совпадёт с пересчётом по
+    // детям: так запись по устаревшим детям, сделанная параллельно с обновлением соседнего
+    // листа, исправляется её же автором, и дерево не остаётся заниженным
+    void Propagate(size_t node) {
+        for (size_t t = (Leaves + Position[node]) / 2; t > 0; t /= 2) {
+            Bounds value = Combine(Load(2 * t), Load(2 * t + 1));
+            for (;;) {
+                Store(t, value);
+                const Bounds again = Combine(Load(2 * t), Load(2 * t + 1));
+                if (again == value) {
+                    break;
+                }
+                value = again;
+            }
+        }
+    }
+
+    static bool Fits(const Bounds& bounds, const Demand& demand) {
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            if (bounds.Most[d] < demand[d]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static Demand ToDemand(const JobDemand& job) {
+        return {job.Cores, job.RamSize, job.GpuMemory, Megabits(job.Bandwidth)};
+    }
+
+    // Размер задачи для сортировки пакета: сумма нормированных требований
+    double JobSize(const Demand& demand) const {
+        double size = 0;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            size += demand[d] * Scale[d];
+        }
+        return size;
+    }
+
+    static void Lock(NodeState& state) {
+        while (state.Locked.exchange(true, memory_order_acquire)) {
+            while (state.Locked.load(memory_order_relaxed)) {
+                this_thread::yield();
+            }
+        }
+    }
+
+    bool TryReserve(size_t node, const Demand& demand) {
+        NodeState& state = Nodes[node];
+        Lock(state);
+        bool fits = true;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            fits = fits && state.Remaining[d].load(memory_order_relaxed) >= demand[d];
+        }
+        if (fits) {
+            for (size_t d = 0; d < DIMENSIONS; ++d) {
+                state.Remaining[d].store(state.Remaining[d].load(memory_order_relaxed) - demand[d], memory_order_relaxed);
+            }
+            Store(Leaves + Position[node], LeafBounds(node));
+        }
+        state.Locked.store(false, memory_order_release);
+        if (fits) {
+            Propagate(node);
+        }
+        return fits;
+    }
+
+    // Выбор узла по снимку остатков без блокировок; NodeCount - подходящего узла нет
+    size_t Find(const Demand& demand, PlacementHeuristic heuristic) const {
+        // DotProduct: скалярное произведение нормированных требований и остатка
+        double weight[DIMENSIONS];
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            weight[d] = demand[d] * Scale[d] * Scale[d];
+        }
+        size_t best = NodeCount;
+        double bestScore = 0;
+        const Bounds root = Load(1);
+        if (Fits(root, demand)) {
+            Search(1, Bound(1, root, heuristic, weight), demand, heuristic, weight, best, bestScore);
+        }
+        return best;
+    }
+
+    // Оценка сверху для узлов поддерева; у листа совпадает со счётом узла
+    double Bound(size_t t, const Bounds& bounds, PlacementHeuristic heuristic, const double* weight) const {
+        if (heuristic == PlacementHeuristic::FirstFitDecreasing) {
+            return -double(FirstNode[t]);
+        }
+        if (heuristic == PlacementHeuristic::BestFit) {
+            return -bounds.Slack;  // наименьший остаток после размещения - наибольший счёт
+        }
+        double bound = 0;
+        for (size_t d = 0; d < DIMENSIONS; ++d) {
+            bound += weight[d] * bounds.Most[d];
+        }
+        return bound;
+    }
+
+    // Обход поддерева t, в котором по каждому измерению есть остаток под задачу, с оценкой bound:
+    // сначала в поддерево с лучшей оценкой, поддеревья с оценкой не лучше найденного узла
+    // пропускаются. Лист читается из дерева (он пишется под блокировкой узла), остаток узла
+    // перепроверяет TryReserve
+    void Search(size_t t, double bound, const Demand& demand, PlacementHeuristic heuristic, const double* weight,
+                size_t& best, double& bestScore) const {
+        if (t >= Leaves) {
+            best = Order[t - Leaves];  // пустые листья (Most = -1) сюда не попадают
+            bestScore = bound;
+            return;
+        }
+        const Bounds left = Load(2 * t), right = Load(2 * t + 1);
+        const bool leftFits = Fits(left, demand), rightFits = Fits(right, demand);
+        const double leftBound = leftFits ? Bound(2 * t, left, heuristic, weight) : -HUGE_VAL;
+        const double rightBound = rightFits ? Bound(2 * t + 1, right, heuristic, weight) : -HUGE_VAL;
+        const bool leftFirst = leftBound >= rightBound;
+        const size_t order[2] = {leftFirst ? 2 * t : 2 * t + 1, leftFirst ? 2 * t + 1 : 2 * t};
+        const bool fits[2] = {leftFirst ? leftFits : rightFits, leftFirst ? rightFits : leftFits};
+        const double bounds[2] = {max(leftBound, rightBound), min(leftBound, rightBound)};
+        for (int k = 0; k < 2; ++k) {
+            if (fits[k] && (best == NodeCount || bounds[k] > bestScore)) {
+                Search(order[k], bounds[k], demand, heuristic, weight, best, bestScore);
+            }
+        }
+    }
+};
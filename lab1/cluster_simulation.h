@@ -0,0 +1,430 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Задача для моделирования: момент поступления (с), объём вычислений в гигациклах,
+// делящийся поровну между Cores ядрами одного узла, и входные данные в ГБ, которые
+// передаются на узел по его сети перед запуском
+struct SimJob {
+    double Arrival = 0;
+    double Work = 0;
+    int Cores = 1;
+    double InputSize = 0;
+};
+
+enum class SimEventType : uint8_t {
+    TransferDone,
+    Finish
+};
+
+struct SimEvent {
+    double Time;
+    uint32_t Job;
+    SimEventType Type;
+};
+
+// Очередь событий - календарная очередь (calendar queue, Brown 1988): время делится на
+// слоты ширины Width, слот s попадает в ведро s mod Buckets, в ведре - список событий по
+// возрастанию времени. Извлечение идёт по ведрам подряд, так что Push и Pop в среднем O(1),
+// а обращения к памяти почти последовательные (двоичная и парная кучи на сотнях тысяч
+// событий упираются в промахи кэша). Число вёдер удваивается и уменьшается вдвое вслед за
+// числом событий, ширина слота пересчитывается по плотности ближайших событий. Узлы списков
+// лежат в заранее выделенном пуле: после создания память не выделяется. Как и в любой
+// дискретно-событийной модели, новое событие не должно быть раньше последнего извлечённого
+class EventQueue {
+public:
+    explicit EventQueue(size_t capacity) : Pool(capacity) {
+        for (size_t i = 0; i < capacity; ++i) {
+            Pool[i].Next = i + 1 < capacity ? uint32_t(i + 1) : NONE;
+        }
+        FreeList = capacity > 0 ? 0 : NONE;
+        size_t limit = MIN_BUCKETS;
+        while (limit * 2 < capacity) {
+            limit *= 2;
+        }
+        Heads.assign(limit, NONE);
+    }
+
+    bool Empty() const { return Count == 0; }
+    size_t Size() const { return Count; }
+
+    // Ближайшее событие; очередь не должна быть пуста
+    const SimEvent& Top() {
+        return Pool[Heads[Locate()]].Event;
+    }
+
+    // false, если пул исчерпан
+    bool Push(const SimEvent& event) {
+        if (FreeList == NONE) {
+            return false;
+        }
+        const uint32_t node = FreeList;
+        FreeList = Pool[node].Next;
+        Pool[node].Event = event;
+        Insert(node);
+        ++Count;
+        if (Count > 2 * Buckets && Buckets < Heads.size()) {
+            Resize(Buckets * 2);
+        }
+        return true;
+    }
+
+    SimEvent Pop() {
+        const size_t bucket = Locate();
+        const uint32_t node = Heads[bucket];
+        const SimEvent event = Pool[node].Event;
+        Heads[bucket] = Pool[node].Next;
+        Pool[node].Next = FreeList;
+        FreeList = node;
+        --Count;
+        if (Count < Buckets / 2 && Buckets > MIN_BUCKETS) {
+            Resize(Buckets / 2);
+        }
+        return event;
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static const size_t MIN_BUCKETS = 16;
+    static const size_t SAMPLE_SIZE = 1024;
+
+    struct Node {
+        SimEvent Event;
+        int64_t Slot;
+        uint32_t Next;        // следующий узел в ведре или в списке свободных
+    };
+
+    vector<Node> Pool;
+    vector<uint32_t> Heads;   // используются первые Buckets
+    size_t Buckets = MIN_BUCKETS;
+    double Width = 1;
+    int64_t Current = 0;      // слот, с которого ищется ближайшее событие
+    uint32_t FreeList = NONE;
+    size_t Count = 0;
+    array<double, SAMPLE_SIZE> Sample;
+
+    size_t BucketOf(int64_t slot) const {
+        return size_t(uint64_t(slot) & (Buckets - 1));
+    }
+
+    // Вставка в ведро после событий с тем же временем (равные события - в порядке поступления)
+    void Insert(uint32_t node) {
+        Node& item = Pool[node];
+        item.Slot = int64_t(floor(item.Event.Time / Width));
+        if (item.Slot < Current) {
+            // Top() уже мог пройти вперёд по пустым слотам
+            Current = item.Slot;
+        }
+        uint32_t* link = &Heads[BucketOf(item.Slot)];
+        while (*link != NONE && Pool[*link].Event.Time <= item.Event.Time) {
+            link = &Pool[*link].Next;
+        }
+        item.Next = *link;
+        *link = node;
+    }
+
+    // Ведро с ближайшим событием: обход слотов одного круга, затем прямой поиск минимума
+    size_t Locate() {
+        for (size_t k = 0; k < Buckets; ++k, ++Current) {
+            const uint32_t head = Heads[BucketOf(Current)];
+            if (head != NONE && Pool[head].Slot == Current) {
+                return BucketOf(Current);
+            }
+        }
+        uint32_t best = NONE;
+        for (size_t b = 0; b < Buckets; ++b) {
+            const uint32_t head = Heads[b];
+            if (head != NONE && (best == NONE || Pool[head].Event.Time < Pool[best].Event.Time)) {
+                best = head;
+            }
+        }
+        Current = Pool[best].Slot;
+        return BucketOf(Current);
+    }
+
+    // Ширина слота - три средних промежутка между событиями в ближайшей восьмой части очереди
+    // (по равномерной выборке); затем все события раскладываются по новым вёдрам
+    void Resize(size_t buckets) {
+        uint32_t all = NONE;
+        size_t sampled = 0, seen = 0;
+        const size_t stride = Count / SAMPLE_SIZE + 1;
+        for (size_t b = 0; b < Buckets; ++b) {
+            for (uint32_t node = Heads[b]; node != NONE;) {
+                const uint32_t next = Pool[node].Next;
+                if (seen++ % stride == 0 && sampled < SAMPLE_SIZE) {
+                    Sample[sampled++] = Pool[node].Event.Time;
+                }
+                Pool[node].Next = all;
+                all = node;
+                node = next;
+            }
+            Heads[b] = NONE;
+        }
+        if (sampled >= 16) {
+            const size_t front = sampled / 8;
+            nth_element(Sample.begin(), Sample.begin() + ptrdiff_t(front), Sample.begin() + ptrdiff_t(sampled));
+            const double edge = Sample[front];
+            const double first = *min_element(Sample.begin(), Sample.begin() + ptrdiff_t(front));
+            if (edge > first) {
+                Width = 3 * (edge - first) / double(front * stride);
+            }
+        }
+        Buckets = buckets;
+        Current = INT64_MAX;
+        while (all != NONE) {
+            const uint32_t next = Pool[all].Next;
+            Insert(all);
+            all = next;
+        }
+        if (Count == 0) {
+            Current = 0;
+        }
+    }
+};
+
+struct SimulationOptions {
+    // Сколько задач от начала очереди рассматривается при каждом освобождении ядер:
+    // 1 - строгий FIFO, больше - меньшие задачи обходят ждущую большую
+    size_t BackfillWindow = 16;
+};
+
+// Время моделирования - секунды от первого поступления задачи
+struct SimulationReport {
+    size_t Jobs = 0;
+    size_t Completed = 0;
+    size_t Rejected = 0;        // не помещаются ни на один узел
+    size_t Events = 0;
+    double Makespan = 0;        // от первого поступления до последнего завершения
+    double Throughput = 0;      // завершённых задач в секунду
+    double MeanWait = 0;        // ожидание в очереди
+    double P95Wait = 0;
+    double MaxWait = 0;
+    double MeanTransfer = 0;
+    double CoreUtilization = 0; // доля ядер кластера, занятых задачами (с передачей данных), за Makespan
+};
+
+// Дискретно-событийная модель кластера. Задача занимает Cores ядер одного узла: сначала
+// получает входные данные со скоростью Lan.Speed, затем считает Work / (Cores * Cpu.Frequency)
+// секунд. Узел выбирается по остатку ядер (best fit): узлы лежат в списках по числу
+// свободных ядер, непустые списки отмечены битами, так что выбор и возврат ядер - O(1)
+// при любом числе узлов. Узлы без ядер не используются; неизвестная частота или скорость
+// сети (0) считается равной 1 ГГц и 1 Гбит/с
+class ClusterSimulator {
+public:
+    explicit ClusterSimulator(const Cluster& cluster) {
+        const size_t n = cluster.Nodes.size();
+        Cores.resize(n);
+        Frequency.resize(n);
+        LanSpeed.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const ClusterNode& node = cluster.Nodes[i];
+            Cores[i] = max(0, node.Cpu.Cores);
+            Frequency[i] = node.Cpu.Frequency > 0 ? node.Cpu.Frequency : 1.0;
+            LanSpeed[i] = node.Lan.Speed > 0 ? node.Lan.Speed : 1.0;
+            MaxCores = max(MaxCores, Cores[i]);
+            TotalCores += Cores[i];
+        }
+        Head.assign(size_t(MaxCores) + 1, NONE);
+        NonEmpty.assign(size_t(MaxCores) / 64 + 1, 0);
+        Free.resize(n);
+        Next.resize(n);
+        Prev.resize(n);
+    }
+
+    size_t Size() const { return Cores.size(); }
+
+    // Моделирование до завершения всех задач; jobs могут идти в любом порядке
+    SimulationReport Run(const vector<SimJob>& jobs, SimulationOptions options = SimulationOptions()) {
+        SimulationReport report;
+        report.Jobs = jobs.size();
+        Reset();
+        const size_t count = jobs.size();
+        vector<uint32_t> order(count);
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return jobs[a].Arrival < jobs[b].Arrival; });
+        // всё выделяется до начала: у задачи не больше одного события в очереди
+        EventQueue events(count);
+        vector<uint32_t> node(count);
+        vector<double> waits;
+        waits.reserve(count);
+        Waiting.assign(max<size_t>(count, 1), 0);
+        WaitHead = WaitCount = 0;
+        const size_t window = max<size_t>(1, options.BackfillWindow);
+
+        const double start = count > 0 ? jobs[order[0]].Arrival : 0;
+        double now = start, end = start, busyCoreSeconds = 0, transferSum = 0;
+
+        auto launch = [&](uint32_t j, uint32_t target) {
+            const SimJob& job = jobs[j];
+            Take(target, job.Cores);
+            node[j] = target;
+            waits.push_back(now - job.Arrival);
+            const double transfer = job.InputSize * 8 / LanSpeed[target];
+            const double compute = job.Work / (job.Cores * Frequency[target]);
+            transferSum += transfer;
+            busyCoreSeconds += job.Cores * (transfer + compute);
+            if (transfer > 0) {
+                events.Push({now + transfer, j, SimEventType::TransferDone});
+            } else {
+                events.Push({now + compute, j, SimEventType::Finish});
+            }
+        };
+        // Запуск ждущих задач из окна начала очереди, пока для них есть узлы
+        auto dispatch = [&]() {
+            int failed = INT_MAX;   // задачи не меньше этой уже не поместились
+            size_t k = 0;
+            while (k < min(window, WaitCount)) {
+                const uint32_t j = Waiting[(WaitHead + k) % Waiting.size()];
+                const int cores = jobs[j].Cores;
+                const uint32_t target = cores < failed ? FindNode(cores) : NONE;
+                if (target == NONE) {
+                    failed = min(failed, cores);
+                    ++k;
+                    continue;
+                }
+                // удаление k-й задачи: сдвиг предыдущих на одну позицию
+                for (size_t m = k; m > 0; --m) {
+                    Waiting[(WaitHead + m) % Waiting.size()] = Waiting[(WaitHead + m - 1) % Waiting.size()];
+                }
+                WaitHead = (WaitHead + 1) % Waiting.size();
+                --WaitCount;
+                launch(j, target);
+            }
+        };
+
+        size_t arrival = 0;
+        while (arrival < count || !events.Empty()) {
+            ++report.Events;
+            if (arrival < count && (events.Empty() || jobs[order[arrival]].Arrival <= events.Top().Time)) {
+                const uint32_t j = order[arrival++];
+                now = jobs[j].Arrival;
+                if (jobs[j].Cores <= 0 || jobs[j].Cores > MaxCores) {
+                    ++report.Rejected;
+                    continue;
+                }
+                Waiting[(WaitHead + WaitCount) % Waiting.size()] = j;
+                ++WaitCount;
+                if (WaitCount <= window) {
+                    dispatch();
+                }
+                continue;
+            }
+            const SimEvent event = events.Pop();
+            now = event.Time;
+            const SimJob& job = jobs[event.Job];
+            if (event.Type == SimEventType::TransferDone) {
+                events.Push({now + job.Work / (job.Cores * Frequency[node[event.Job]]), event.Job, SimEventType::Finish});
+                continue;
+            }
+            Release(node[event.Job], job.Cores);
+            ++report.Completed;
+            end = now;
+            dispatch();
+        }
+
+        report.Makespan = end - start;
+        if (report.Makespan > 0) {
+            report.Throughput = report.Completed / report.Makespan;
+            report.CoreUtilization = TotalCores > 0 ? busyCoreSeconds / (double(TotalCores) * report.Makespan) : 0;
+        }
+        if (!waits.empty()) {
+            report.MeanWait = accumulate(waits.begin(), waits.end(), 0.0) / waits.size();
+            report.MaxWait = *max_element(waits.begin(), waits.end());
+            auto p95 = waits.begin() + ptrdiff_t((waits.size() - 1) * 95 / 100);
+            nth_element(waits.begin(), p95, waits.end());
+            report.P95Wait = *p95;
+            report.MeanTransfer = transferSum / waits.size();
+        }
+        return report;
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    vector<int> Cores;
+    vector<double> Frequency;
+    vector<double> LanSpeed;
+    int MaxCores = 0;
+    long long TotalCores = 0;
+
+    // Списки узлов по числу свободных ядер: Head[f], Next/Prev; бит f в NonEmpty - список не пуст
+    vector<int> Free;
+    vector<uint32_t> Head;
+    vector<uint32_t> Next;
+    vector<uint32_t> Prev;
+    vector<uint64_t> NonEmpty;
+
+    // Кольцевая очередь ждущих задач
+    vector<uint32_t> Waiting;
+    size_t WaitHead = 0;
+    size_t WaitCount = 0;
+
+    void Reset() {
+        fill(Head.begin(), Head.end(), NONE);
+        fill(NonEmpty.begin(), NonEmpty.end(), 0);
+        for (size_t i = 0; i < Cores.size(); ++i) {
+            if (Cores[i] > 0) {
+                Free[i] = Cores[i];
+                Link(uint32_t(i));
+            }
+        }
+    }
+
+    void Link(uint32_t node) {
+        const int f = Free[node];
+        Prev[node] = NONE;
+        Next[node] = Head[f];
+        if (Head[f] != NONE) {
+            Prev[Head[f]] = node;
+        }
+        Head[f] = node;
+        NonEmpty[f / 64] |= uint64_t(1) << (f % 64);
+    }
+
+    void Unlink(uint32_t node) {
+        const int f = Free[node];
+        if (Prev[node] != NONE) {
+            Next[Prev[node]] = Next[node];
+        } else {
+            Head[f] = Next[node];
+        }
+        if (Next[node] != NONE) {
+            Prev[Next[node]] = Prev[node];
+        }
+        if (Head[f] == NONE) {
+            NonEmpty[f / 64] &= ~(uint64_t(1) << (f % 64));
+        }
+    }
+
+    void Take(uint32_t node, int cores) {
+        Unlink(node);
+        Free[node] -= cores;
+        Link(node);
+    }
+
+    void Release(uint32_t node, int cores) {
+        Unlink(node);
+        Free[node] += cores;
+        Link(node);
+    }
+
+    // Узел с наименьшим числом свободных ядер, не меньшим cores; NONE - такого нет
+    uint32_t FindNode(int cores) const {
+        for (size_t w = size_t(cores) / 64; w < NonEmpty.size(); ++w) {
+            uint64_t bits = NonEmpty[w];
+            if (w == size_t(cores) / 64) {
+                bits &= ~uint64_t(0) << (cores % 64);
+            }
+            if (bits != 0) {
+                return Head[w * 64 + size_t(__builtin_ctzll(bits))];
+            }
+        }
+        return NONE;
+    }
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include "cluster_columns.h"
+#include "../lab2/MappedFile.cpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Бинарный снимок кластера (версия 1):
+//   [заголовок 64 байта]
+//   [каталог секций: SnapshotSection на секцию]
+//   [секции, каждая с выравниванием на 64 байта]
+// Числовые поля лежат столбцами фиксированной ширины (int32 или double на узел), имена -
+// номерами uint32 в общей таблице строк: смещения uint64[count + 1] и байты без
+// разделителей, так что имена могут содержать пробелы. Файл открывается через mmap за O(1),
+// столбцы читаются прямо из страниц файла.
+// Совместимость: новые секции добавляются с новыми Id без смены версии - старые читатели их
+// пропускают. Version меняется, только если меняется смысл или формат существующих секций.
+// Числа хранятся в порядке байт машины; EndianMark позволяет обнаружить чужой порядок.
+
+struct SnapshotHeader {
+    char Magic[8];            // "CLSTRSNP"
+    uint32_t Version;
+    uint32_t EndianMark;
+    uint64_t NodeCount;
+    uint64_t DirectoryOffset;
+    uint32_t SectionCount;
+    uint32_t Reserved;
+    uint64_t Generation;      // поколение журнала изменений (cluster_journal.h), 0 - без журнала
+    uint8_t Padding[16];
+};
+static_assert(sizeof(SnapshotHeader) == 64, "SnapshotHeader must be 64 bytes");
+
+struct SnapshotSection {
+    uint32_t Id;              // SnapshotSectionId
+    uint32_t ElemSize;        // размер элемента столбца; 1 для байтов строк
+    uint64_t Offset;
+    uint64_t Size;            // в байтах
+};
+static_assert(sizeof(SnapshotSection) == 24, "SnapshotSection must be 24 bytes");
+
+enum class SnapshotSectionId : uint32_t {
+    CpuCores = 1,
+    CpuFrequency = 2,
+    GpuMemory = 3,
+    GpuCores = 4,
+    RamSize = 5,
+    LanSpeed = 6,
+    CpuName = 7,              // uint32 номер строки на узел
+    GpuName = 8,
+    RamType = 9,
+    LanAdapter = 10,
+    StringOffsets = 11,       // uint64[count + 1]
+    StringData = 12
+};
+
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_ENDIAN_MARK = 0x01020304;
+const uint64_t SNAPSHOT_ALIGNMENT = 64;
+const char SNAPSHOT_MAGIC[8] = {'C', 'L', 'S', 'T', 'R', 'S', 'N', 'P'};
+
+// Сброс файла на диск (fsync). Для каталога - сохранение переименований в нём; в Windows
+// каталоги не сбрасываются
+inline bool SyncPath(const string& path) {
+#if defined(_WIN32)
+    const int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) {
+        return true;
+    }
+    const bool ok = _commit(fd) == 0;
+    _close(fd);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = fsync(fd) == 0;
+    close(fd);
+#endif
+    return ok;
+}
+
+// Запись снимка из столбцов (ColumnarCluster или другого снимка): столбцы пишутся как есть,
+// таблица строк - из columns.Names. false и сообщение в cerr при ошибке. sync - дождаться
+// записи на диск
+inline bool WriteClusterSnapshot(const NodeColumns& columns, const string& filename, uint64_t generation = 0, bool sync = false) {
+    const size_t n = columns.Size;
+    vector<uint64_t> stringOffsets(columns.NameCount + 1, 0);
+    string stringData;
+    for (size_t i = 0; i < columns.NameCount; ++i) {
+        stringData.append(columns.Names[i].data(), columns.Names[i].size());
+        stringOffsets[i + 1] = stringData.size();
+    }
+
+    struct Source {
+        SnapshotSectionId Id;
+        uint32_t ElemSize;
+        const void* Data;
+        uint64_t Size;
+    };
+    const Source sources[] = {
+        {SnapshotSectionId::CpuCores, 4, columns.CpuCores, 4 * n},
+        {SnapshotSectionId::CpuFrequency, 8, columns.CpuFrequency, 8 * n},
+        {SnapshotSectionId::GpuMemory, 4, columns.GpuMemory, 4 * n},
+        {SnapshotSectionId::GpuCores, 4, columns.GpuCores, 4 * n},
+        {SnapshotSectionId::RamSize, 4, columns.RamSize, 4 * n},
+        {SnapshotSectionId::LanSpeed, 8, columns.LanSpeed, 8 * n},
+        {SnapshotSectionId::CpuName, 4, columns.CpuName, 4 * n},
+        {SnapshotSectionId::GpuName, 4, columns.GpuName, 4 * n},
+        {SnapshotSectionId::RamType, 4, columns.RamType, 4 * n},
+        {SnapshotSectionId::LanAdapter, 4, columns.LanAdapter, 4 * n},
+        {SnapshotSectionId::StringOffsets, 8, stringOffsets.data(), 8 * stringOffsets.size()},
+        {SnapshotSectionId::StringData, 1, stringData.data(), stringData.size()},
+    };
+    const uint32_t sectionCount = uint32_t(sizeof(sources) / sizeof(sources[0]));
+    auto alignUp = [](uint64_t value) { return (value + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT; };
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, SNAPSHOT_MAGIC, sizeof(header.Magic));
+    header.Version = SNAPSHOT_VERSION;
+    header.EndianMark = SNAPSHOT_ENDIAN_MARK;
+    header.NodeCount = n;
+    header.DirectoryOffset = sizeof(header);
+    header.SectionCount = sectionCount;
+    header.Generation = generation;
+    vector<SnapshotSection> directory(sectionCount);
+    uint64_t position = alignUp(sizeof(header) + sizeof(SnapshotSection) * sectionCount);
+    for (uint32_t s = 0; s < sectionCount; ++s) {
+        directory[s] = {uint32_t(sources[s].Id), sources[s].ElemSize, position, sources[s].Size};
+        position = alignUp(position + sources[s].Size);
+    }
+
+    ofstream out(filename, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Error opening file for export!" << endl;
+        return false;
+    }
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(directory.data()), streamsize(sizeof(SnapshotSection) * sectionCount));
+    position = sizeof(header) + sizeof(SnapshotSection) * sectionCount;
+    for (uint32_t s = 0; s < sectionCount; ++s) {
+        out.write(zeros, streamsize(directory[s].Offset - position));
+        out.write(static_cast<const char*>(sources[s].Data), streamsize(sources[s].Size));
+        position = directory[s].Offset + sources[s].Size;
+    }
+    out.close();
+    if (!out || (sync && !SyncPath(filename))) {
+        cerr << "Error writing snapshot: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+// Запись снимка кластера: узлы переводятся в записи ColumnarCluster (названия - один раз в пуле)
+inline bool WriteClusterSnapshot(const Cluster& cluster, const string& filename, uint64_t generation = 0, bool sync = false) {
+    const ColumnarCluster columns(cluster);
+    return WriteClusterSnapshot(columns.Columns(), filename, generation, sync);
+}
+
+// Открытый снимок: столбцы и имена читаются прямо из отображённого файла (те же NodeColumns,
+// что у ColumnarCluster), запросы NodeQuery выполняются без загрузки
+class ClusterSnapshot {
+private:
+    shared_ptr<MappedFile> File;
+    shared_ptr<vector<string_view>> Names;  // таблица строк файла; общая у копий снимка
+    NodeColumns Data;
+    uint64_t SnapshotGeneration = 0;
+
+    bool Fail(const string& message, const string& filename) {
+        cerr << message << ": " << filename << endl;
+        File.reset();
+        Names.reset();
+        Data = NodeColumns();
+        return false;
+    }
+
+public:
+    // Проверяет заголовок и каталог и запоминает указатели на секции; данные не читаются
+    bool Open(const string& filename) {
+        try {
+            File = make_shared<MappedFile>(filename);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return false;
+        }
+        const char* base = File->data();
+        const uint64_t fileSize = File->size();
+        if (fileSize < sizeof(SnapshotHeader)) {
+            return Fail("File is too small for cluster snapshot", filename);
+        }
+        const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(base);
+        if (memcmp(header.Magic, SNAPSHOT_MAGIC, sizeof(header.Magic)) != 0) {
+            return Fail("Not a cluster snapshot", filename);
+        }
+        if (header.EndianMark != SNAPSHOT_ENDIAN_MARK) {
+            return Fail("Byte order mismatch in snapshot", filename);
+        }
+        if (header.Version != SNAPSHOT_VERSION) {
+            return Fail("Unsupported snapshot version " + to_string(header.Version), filename);
+        }
+        // сравнения через деление: смещения и размеры из файла могут переполнить сумму и произведение
+        if (header.DirectoryOffset % alignof(SnapshotSection) != 0 || header.DirectoryOffset > fileSize
+            || header.SectionCount > (fileSize - header.DirectoryOffset) / sizeof(SnapshotSection)) {
+            return Fail("Invalid snapshot directory", filename);
+        }
+        const uint64_t n = header.NodeCount;
+        const SnapshotSection* directory = reinterpret_cast<const SnapshotSection*>(base + header.DirectoryOffset);
+        const void* sections[13] = {};
+        uint64_t sizes[13] = {};
+        for (uint32_t s = 0; s < header.SectionCount; ++s) {
+            const SnapshotSection& section = directory[s];
+            if (section.Offset % SNAPSHOT_ALIGNMENT != 0 || section.Offset > fileSize || section.Size > fileSize - section.Offset) {
+                return Fail("Invalid snapshot section", filename);
+            }
+            if (section.Id == 0 || section.Id > 12) {
+                continue;  // секция более новой версии формата
+            }
+            sections[section.Id] = base + section.Offset;
+            sizes[section.Id] = section.Size;
+        }
+        // столбцы: 4 или 8 байт на узел
+        for (uint32_t id = 1; id <= 10; ++id) {
+            const uint64_t width = id == 2 || id == 6 ? 8 : 4;
+            if (sections[id] == nullptr || sizes[id] % width != 0 || sizes[id] / width != n) {
+                return Fail("Missing or truncated snapshot section " + to_string(id), filename);
+            }
+        }
+        if (sections[11] == nullptr || sizes[11] < 8 || sizes[11] % 8 != 0 || sections[12] == nullptr) {
+            return Fail("Missing snapshot string table", filename);
+        }
+        // таблица строк: string_view на байты файла, по одному на название
+        const uint64_t* stringOffsets = static_cast<const uint64_t*>(sections[11]);
+        const char* stringData = static_cast<const char*>(sections[12]);
+        const uint64_t stringCount = sizes[11] / 8 - 1;
+        Names = make_shared<vector<string_view>>();
+        Names->reserve(size_t(stringCount));
+        for (uint64_t i = 0; i < stringCount; ++i) {
+            if (stringOffsets[i] > stringOffsets[i + 1] || stringOffsets[i + 1] > sizes[12]) {
+                return Fail("Invalid snapshot string table", filename);
+            }
+            Names->emplace_back(stringData + stringOffsets[i], size_t(stringOffsets[i + 1] - stringOffsets[i]));
+        }
+        Data.Size = size_t(n);
+        Data.CpuCores = static_cast<const int*>(sections[1]);
+        Data.CpuFrequency = static_cast<const double*>(sections[2]);
+        Data.GpuMemory = static_cast<const int*>(sections[3]);
+        Data.GpuCores = static_cast<const int*>(sections[4]);
+        Data.RamSize = static_cast<const int*>(sections[5]);
+        Data.LanSpeed = static_cast<const double*>(sections[6]);
+        Data.CpuName = static_cast<const uint32_t*>(sections[7]);
+        Data.GpuName = static_cast<const uint32_t*>(sections[8]);
+        Data.RamType = static_cast<const uint32_t*>(sections[9]);
+        Data.LanAdapter = static_cast<const uint32_t*>(sections[10]);
+        Data.Names = Names->data();
+        Data.NameCount = Names->size();
+        SnapshotGeneration = header.Generation;
+        return true;
+    }
+
+    size_t Size() const { return Data.Size; }
+
+    uint64_t Generation() const { return SnapshotGeneration; }
+
+    const NodeColumns& Columns() const { return Data; }
+
+    // Доступ к узлу index без копирования, пока снимок открыт
+    NodeRef Node(size_t index) const { return NodeRef(Data, index); }
+
+    Aggregate Query(NodeField target, const vector<Condition>& where, size_t threads = 0) const {
+        return NodeQuery::Query(Data, target, where, threads);
+    }
+
+    vector<size_t> Select(const vector<Condition>& where) const {
+        return NodeQuery::Select(Data, where);
+    }
+
+    Cluster ToCluster() const {
+        Cluster cluster;
+        cluster.Nodes.reserve(Size());
+        for (size_t i = 0; i < Size(); ++i) {
+            cluster.Nodes.push_back(Node(i).ToNode());
+        }
+        return cluster;
+    }
+};
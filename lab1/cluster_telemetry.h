@@ -0,0 +1,303 @@
+#pragma once
+
+#include "cluster_classes.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+// Измеряемые величины узла: загрузка CPU (0..1), занятая память (МБ), сетевой трафик (Гбит/с)
+enum class TelemetryMetric {
+    CpuLoad,
+    MemoryUsed,
+    NetworkThroughput
+};
+
+const size_t TELEMETRY_METRICS = 3;
+
+// Один замер; Time - метка времени (например, микросекунды), не убывает для узла
+struct TelemetrySample {
+    int64_t Time = 0;
+    float Values[TELEMETRY_METRICS] = {};
+};
+
+// Сводка по окну замеров одной величины (NaN и бесконечности пропускаются); процентили -
+// точные (ближайший ранг)
+struct TelemetryStats {
+    size_t Count = 0;
+    int64_t From = 0;       // метки времени первого и последнего замера окна
+    int64_t To = 0;
+    double Average = 0;
+    float Min = 0;
+    float Max = 0;
+    float P50 = 0;
+    float P95 = 0;
+    float P99 = 0;
+};
+
+struct NodeTelemetry {
+    TelemetryStats Metrics[TELEMETRY_METRICS];
+};
+
+// Хранилище телеметрии узлов кластера: у каждого узла кольцевой буфер последних Capacity()
+// замеров, все буферы - в одной заранее выделенной области. Писатель у узла один (в каждый
+// момент), читателей сколько угодно; блокировок нет. Каждая ячейка кольца - seqlock: номер
+// записи в ней обнуляется на время записи и ставится после, читатель проверяет номер до и
+// после чтения и пропускает ячейки, которые писатель успел перезаписать. Сводки считаются
+// прямо по кольцу без копирования: среднее и экстремумы за один проход, процентили -
+// уточнением по гистограмме (каждый проход сужает диапазон значений в 256 раз), пока в
+// искомом интервале не останется несколько десятков значений
+class TelemetryStore {
+public:
+    TelemetryStore(size_t nodeCount, size_t capacityPerNode) : NodeCount(nodeCount) {
+        RingSize = 2;
+        while (RingSize < capacityPerNode) {
+            RingSize *= 2;
+        }
+        Mask = RingSize - 1;
+        Rings.reset(new Ring[NodeCount]);
+        Slots.reset(new Slot[NodeCount * RingSize]);
+    }
+
+    // Кольца выделяются на узлы, которые есть в кластере сейчас: узлы, добавленные в cluster
+    // позже, в хранилище не попадают (номер узла должен быть меньше Size())
+    TelemetryStore(const Cluster& cluster, size_t capacityPerNode) : TelemetryStore(cluster.Nodes.size(), capacityPerNode) {}
+
+    size_t Size() const { return NodeCount; }
+    size_t Capacity() const { return RingSize; }
+
+    size_t MemoryBytes() const {
+        return NodeCount * (sizeof(Ring) + RingSize * sizeof(Slot));
+    }
+
+    // Замер узла; вызывать из одного потока на узел. node < Size() (проверяется в отладочной сборке)
+    void Record(size_t node, const TelemetrySample& sample) {
+        assert(node < NodeCount);
+        Ring& ring = Rings[node];
+        const uint64_t index = ring.Head.load(memory_order_relaxed);
+        Slot& slot = Slots[node * RingSize + (index & Mask)];
+        slot.Sequence.store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.Time.store(sample.Time, memory_order_relaxed);
+        for (size_t m = 0; m < TELEMETRY_METRICS; ++m) {
+            slot.Values[m].store(sample.Values[m], memory_order_relaxed);
+        }
+        slot.Sequence.store(index + 1, memory_order_release);
+        ring.Head.store(index + 1, memory_order_release);
+    }
+
+    // Сколько замеров узла записано за всё время
+    uint64_t Written(size_t node) const {
+        assert(node < NodeCount);
+        return Rings[node].Head.load(memory_order_acquire);
+    }
+
+    // Сводка по последним count замерам узла
+    TelemetryStats Last(size_t node, TelemetryMetric metric, size_t count) const {
+        for (int attempt = 0;; ++attempt) {
+            const uint64_t head = Written(node);
+            uint64_t from = head - min<uint64_t>(head, min<uint64_t>(count, RingSize));
+            TelemetryStats stats;
+            if (Summarize(node, size_t(metric), from, head, stats) || attempt == MAX_ATTEMPTS) {
+                return stats;
+            }
+        }
+    }
+
+    // Сводка по замерам узла с меткой времени не раньше from (из тех, что ещё в кольце)
+    TelemetryStats Since(size_t node, TelemetryMetric metric, int64_t from) const {
+        for (int attempt = 0;; ++attempt) {
+            const uint64_t head = Written(node);
+            TelemetryStats stats;
+            if (Summarize(node, size_t(metric), FirstAt(node, from, head), head, stats) || attempt == MAX_ATTEMPTS) {
+                return stats;
+            }
+        }
+    }
+
+    // Копия последних count замеров узла, от старых к новым; возвращает число скопированных
+    size_t Recent(size_t node, size_t count, vector<TelemetrySample>& out) const {
+        const uint64_t head = Written(node);
+        const uint64_t from = head - min<uint64_t>(head, min<uint64_t>(count, RingSize));
+        out.clear();
+        out.reserve(size_t(head - from));
+        TelemetrySample sample;
+        for (uint64_t i = from; i < head; ++i) {
+            if (Read(node, i, sample)) {
+                out.push_back(sample);
+            }
+        }
+        return out.size();
+    }
+
+    // Сводка по последним window замерам всех узлов и величин
+    vector<NodeTelemetry> Snapshot(size_t window) const {
+        vector<NodeTelemetry> snapshot(NodeCount);
+        for (size_t node = 0; node < NodeCount; ++node) {
+            for (size_t m = 0; m < TELEMETRY_METRICS; ++m) {
+                snapshot[node].Metrics[m] = Last(node, TelemetryMetric(m), window);
+            }
+        }
+        return snapshot;
+    }
+
+private:
+    static const int MAX_ATTEMPTS = 4;
+    static const size_t BINS = 256;
+    static const size_t SELECT_LIMIT = 64;
+
+    // Отдельная строка кэша на счётчик, чтобы писатели разных узлов не мешали друг другу
+    struct alignas(64) Ring {
+        atomic<uint64_t> Head{0};
+    };
+
+    // Sequence = номер записи + 1; 0 - ячейка пуста или пишется
+    struct alignas(32) Slot {
+        atomic<uint64_t> Sequence{0};
+        atomic<int64_t> Time{0};
+        atomic<float> Values[TELEMETRY_METRICS] = {};
+    };
+
+    size_t NodeCount;
+    size_t RingSize;
+    uint64_t Mask;
+    unique_ptr<Ring[]> Rings;
+    unique_ptr<Slot[]> Slots;
+
+    // Согласованное чтение записи index; false - ещё не записана или уже перезаписана
+    bool Read(size_t node, uint64_t index, TelemetrySample& sample) const {
+        const Slot& slot = Slots[node * RingSize + (index & Mask)];
+        if (slot.Sequence.load(memory_order_acquire) != index + 1) {
+            return false;
+        }
+        sample.Time = slot.Time.load(memory_order_relaxed);
+        for (size_t m = 0; m < TELEMETRY_METRICS; ++m) {
+            sample.Values[m] = slot.Values[m].load(memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        return slot.Sequence.load(memory_order_relaxed) == index + 1;
+    }
+
+    // Обход значений величины в записях [from, to); пропущенные ячейки, NaN и бесконечности не
+    // учитываются (гистограмма процентилей строится по конечному диапазону)
+    template <typename Func>
+    void Visit(size_t node, size_t metric, uint64_t from, uint64_t to, Func f) const {
+        const Slot* ring = &Slots[node * RingSize];
+        for (uint64_t i = from; i < to; ++i) {
+            const Slot& slot = ring[i & Mask];
+            if (slot.Sequence.load(memory_order_acquire) != i + 1) {
+                continue;
+            }
+            const float value = slot.Values[metric].load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.Sequence.load(memory_order_relaxed) == i + 1 && std::isfinite(value)) {
+                f(value);
+            }
+        }
+    }
+
+    // Первая запись с меткой времени >= time среди ещё не перезаписанных (двоичный поиск)
+    uint64_t FirstAt(size_t node, int64_t time, uint64_t head) const {
+        uint64_t low = head - min<uint64_t>(head, RingSize), high = head;
+        TelemetrySample sample;
+        while (low < high) {
+            const uint64_t middle = low + (high - low) / 2;
+            // перезаписанная ячейка старше всех оставшихся
+            if (!Read(node, middle, sample) || sample.Time < time) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    // false - писатель перезаписал часть окна между проходами, сводку стоит пересчитать
+    bool Summarize(size_t node, size_t metric, uint64_t from, uint64_t to, TelemetryStats& stats) const {
+        double sum = 0;
+        float low = INFINITY, high = -INFINITY;
+        size_t count = 0;
+        Visit(node, metric, from, to, [&](float value) {
+            sum += value;
+            low = min(low, value);
+            high = max(high, value);
+            ++count;
+        });
+        if (count == 0) {
+            return true;
+        }
+        TelemetrySample sample;
+        uint64_t first = from;
+        while (first < to && !Read(node, first, sample)) {
+            ++first;
+        }
+        stats.From = first < to ? sample.Time : 0;
+        stats.To = Read(node, to - 1, sample) ? sample.Time : stats.From;
+        stats.Count = count;
+        stats.Average = sum / double(count);
+        stats.Min = low;
+        stats.Max = high;
+        bool consistent = true;
+        stats.P50 = Percentile(node, metric, from, to, 0.50, low, high, count, consistent);
+        stats.P95 = Percentile(node, metric, from, to, 0.95, low, high, count, consistent);
+        stats.P99 = Percentile(node, metric, from, to, 0.99, low, high, count, consistent);
+        return consistent;
+    }
+
+    float Percentile(size_t node, size_t metric, uint64_t from, uint64_t to, double p, float low, float high, size_t count,
+                     bool& consistent) const {
+        const size_t rank = size_t(max(1.0, ceil(p * double(count)))) - 1;
+        // [low, high] содержит искомое значение, below - сколько значений меньше low
+        while (low < high) {
+            uint32_t bins[BINS] = {};
+            float binLow[BINS], binHigh[BINS];
+            size_t below = 0, total = 0;
+            const double scale = BINS / (double(high) - double(low));
+            Visit(node, metric, from, to, [&](float value) {
+                ++total;
+                if (value < low) {
+                    ++below;
+                } else if (value <= high) {
+                    const size_t bin = min(BINS - 1, size_t((double(value) - double(low)) * scale));
+                    binLow[bin] = bins[bin] == 0 ? value : min(binLow[bin], value);
+                    binHigh[bin] = bins[bin] == 0 ? value : max(binHigh[bin], value);
+                    ++bins[bin];
+                }
+            });
+            if (total != count) {
+                consistent = false;
+            }
+            size_t bin = 0, seen = below;
+            while (bin < BINS - 1 && seen + bins[bin] <= rank) {
+                seen += bins[bin++];
+            }
+            if (bins[bin] == 0 || seen > rank) {
+                // окно изменилось между проходами
+                consistent = false;
+                return low;
+            }
+            low = binLow[bin];
+            high = binHigh[bin];
+            if (bins[bin] <= SELECT_LIMIT && low < high) {
+                // в интервале осталось немного значений: точный выбор среди них
+                float values[SELECT_LIMIT];
+                size_t n = 0;
+                Visit(node, metric, from, to, [&](float value) {
+                    if (value >= low && value <= high && n < SELECT_LIMIT) {
+                        values[n++] = value;
+                    }
+                });
+                const size_t k = rank - seen;
+                if (k >= n) {
+                    consistent = false;
+                    return high;
+                }
+                nth_element(values, values + k, values + n);
+                return values[k];
+            }
+        }
+        return low;
+    }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Арена для блоков MatrixBlock: тайлы одного размера лежат подряд в больших
+// выровненных слэбах, каждый тайл начинается с границы кэш-линии.
+// Освобождённые тайлы возвращаются в список свободных и переиспользуются.
+template <typename T>
+class BlockArena {
+private:
+    static const size_t ALIGNMENT = 64;
+
+    size_t _tileElems;   // элементов в тайле (blockSize * blockSize)
+    size_t _tileStride;  // шаг между тайлами в элементах, с выравниванием до кэш-линии
+    std::vector<T*> _slabs;
+    std::vector<T*> _free;
+    T* _cursor = nullptr; // следующий нетронутый тайл текущего слэба
+    size_t _cursorLeft = 0;
+    size_t _nextSlabTiles = 8;
+    std::mutex _mutex;
+
+    void addSlab(size_t tiles) {
+        T* slab = static_cast<T*>(::operator new(tiles * _tileStride * sizeof(T), std::align_val_t(ALIGNMENT)));
+        _slabs.push_back(slab);
+        _cursor = slab;
+        _cursorLeft = tiles;
+        _nextSlabTiles = tiles * 2;
+    }
+
+public:
+    explicit BlockArena(size_t tileElems) : _tileElems(tileElems) {
+        size_t bytes = (tileElems * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        _tileStride = bytes / sizeof(T);
+    }
+
+    BlockArena(const BlockArena&) = delete;
+    BlockArena& operator=(const BlockArena&) = delete;
+
+    ~BlockArena() {
+        for (T* slab : _slabs) {
+            ::operator delete(slab, std::align_val_t(ALIGNMENT));
+        }
+    }
+
+    size_t tileElems() const { return _tileElems; }
+
+    // Заранее выделяет слэб под tiles тайлов, чтобы загружаемые блоки легли подряд
+    void reserve(size_t tiles) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_free.size() + _cursorLeft < tiles) {
+            addSlab(tiles);
+        }
+    }
+
+    // Тайл, заполненный нулями
+    T* allocate() {
+        T* tile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_free.empty()) {
+                tile = _free.back();
+                _free.pop_back();
+            } else {
+                if (_cursorLeft == 0) addSlab(_nextSlabTiles);
+                tile = _cursor;
+                _cursor += _tileStride;
+                --_cursorLeft;
+            }
+        }
+        for (size_t i = 0; i < _tileElems; ++i) tile[i] = 0;
+        return tile;
+    }
+
+    void release(T* tile) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(tile);
+    }
+};
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "GemmKernel.cpp"
+#include "ThreadPool.cpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Блочные LU (с частичным выбором главного элемента) и Холецкий для непрерывных массивов
+// с шагом строки ld, а также прямая и обратная подстановки. Разложения правосторонние:
+// после панели шириной block остаток матрицы обновляется одним умножением gemm_kernel,
+// на которое приходится почти вся арифметика.
+namespace factorization {
+
+struct Params {
+    size_t block = 64;  // ширина панели
+};
+
+inline Params& params() {
+    static Params current;
+    return current;
+}
+
+// Столбцов правой части (или обновляемой части строки) на одну задачу пула
+const size_t COLUMNS_PER_TASK = 256;
+
+template <typename T>
+inline T dot(const T* a, const T* b, size_t n) {
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+template <typename T>
+inline void axpy(T alpha, const T* x, T* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+// f(begin, end) для отрезков [0, count) шириной COLUMNS_PER_TASK, отрезки раздаются пулу
+template <typename Func>
+void forColumns(size_t count, Func f) {
+    const size_t tasks = (count + COLUMNS_PER_TASK - 1) / COLUMNS_PER_TASK;
+    if (tasks <= 1) {
+        if (count > 0) f(0, count);
+        return;
+    }
+    ThreadPool::global().parallelFor(tasks, [&](size_t t) {
+        f(t * COLUMNS_PER_TASK, std::min(count, (t + 1) * COLUMNS_PER_TASK));
+    });
+}
+
+// ---- LU ----
+
+// Разложение панели rows x cols (rows >= cols) на месте; строки переставляются только в пределах
+// панели. pivots[j] - номер строки панели, поменянной со строкой j. false - если матрица вырождена.
+template <typename T>
+bool panelLU(T* P, size_t ld, size_t rows, size_t cols, unsigned* pivots) {
+    bool regular = true;
+    for (size_t j = 0; j < cols; ++j) {
+        size_t p = j;
+        T best = std::abs(P[j * ld + j]);
+        for (size_t i = j + 1; i < rows; ++i) {
+            const T value = std::abs(P[i * ld + j]);
+            if (value > best) {
+                best = value;
+                p = i;
+            }
+        }
+        pivots[j] = static_cast<unsigned>(p);
+        if (p != j) std::swap_ranges(P + j * ld, P + j * ld + cols, P + p * ld);
+        const T* pivotRow = P + j * ld;
+        if (pivotRow[j] == T(0)) {
+            regular = false;
+            continue;
+        }
+        const T inverse = T(1) / pivotRow[j];
+        for (size_t i = j + 1; i < rows; ++i) {
+            T* row = P + i * ld;
+            row[j] *= inverse;
+            axpy(-row[j], pivotRow + j + 1, row + j + 1, cols - j - 1);
+        }
+    }
+    return regular;
+}
+
+// Перестановки строк r <-> pivots[r] для r из [first, last) в столбцах [colBegin, colEnd)
+template <typename T>
+void swapRows(T* A, size_t lda, const unsigned* pivots, size_t first, size_t last, size_t colBegin, size_t colEnd) {
+    for (size_t r = first; r < last; ++r) {
+        const size_t p = pivots[r];
+        if (p != r) std::swap_ranges(A + r * lda + colBegin, A + r * lda + colEnd, A + p * lda + colBegin);
+    }
+}
+
+// B (n x cols) := L^{-1} B для нижнетреугольной L; unit - единицы на диагонали не хранятся
+template <typename T>
+void solveLowerRows(const T* L, size_t ldl, size_t n, T* B, size_t ldb, size_t cols, bool unit) {
+    for (size_t i = 0; i < n; ++i) {
+        T* bi = B + i * ldb;
+        const T* li = L + i * ldl;
+        for (size_t p = 0; p < i; ++p) {
+            if (li[p] != T(0)) axpy(-li[p], B + p * ldb, bi, cols);
+        }
+        if (!unit) {
+            const T inverse = T(1) / li[i];
+            for (size_t c = 0; c < cols; ++c) bi[c] *= inverse;
+        }
+    }
+}
+
+// Блочное LU на месте: P A = L U, n x n. pivots - n номеров строк (в порядке LAPACK).
+template <typename T>
+bool luFactor(T* A, size_t n, size_t lda, unsigned* pivots) {
+    const size_t nb = std::max<size_t>(1, params().block);
+    std::vector<T> negL;
+    bool regular = true;
+    for (size_t k = 0; k < n; k += nb) {
+        const size_t kb = std::min(nb, n - k);
+        if (!panelLU(A + k * lda + k, lda, n - k, kb, pivots + k)) regular = false;
+        for (size_t j = 0; j < kb; ++j) pivots[k + j] += static_cast<unsigned>(k);
+
+        // Перестановки панели переносятся на столбцы слева и справа; справа сразу U12 = L11^{-1} A12
+        const size_t right = k + kb;
+        const size_t rest = n - right;
+        forColumns(k + rest, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ) {
+                const size_t colBegin = c < k ? c : right + (c - k);
+                const size_t width = c < k ? std::min(end, k) - c : end - c;
+                swapRows(A, lda, pivots, k, k + kb, colBegin, colBegin + width);
+                if (c >= k) solveLowerRows(A + k * lda + k, lda, kb, A + k * lda + colBegin, lda, width, true);
+                c += width;
+            }
+        });
+        if (rest == 0) continue;
+
+        // A22 -= L21 * U12: L21 копируется с обратным знаком, и вычитание становится накоплением gemm
+        negL.resize(rest * kb);
+        for (size_t i = 0; i < rest; ++i) {
+            const T* row = A + (right + i) * lda + k;
+            for (size_t q = 0; q < kb; ++q) negL[i * kb + q] = -row[q];
+        }
+        gemm_kernel::multiply(negL.data(), kb, A + k * lda + right, lda, A + right * lda + right, lda,
+                              rest, rest, kb, true);
+    }
+    return regular;
+}
+
+// ---- Холецкий ----
+
+// Неблочный Холецкий квадратного блока n x n (нижний треугольник); false - не положительно определена
+template <typename T>
+bool choleskyBlock(T* A, size_t lda, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        T* rj = A + j * lda;
+        const T d = rj[j] - dot(rj, rj, j);
+        if (!(d > T(0))) return false;
+        rj[j] = std::sqrt(d);
+        const T inverse = T(1) / rj[j];
+        for (size_t i = j + 1; i < n; ++i) {
+            T* ri = A + i * lda;
+            ri[j] = (ri[j] - dot(ri, rj, j)) * inverse;
+        }
+    }
+    return true;
+}
+
+// Строки [rowBegin, rowEnd) матрицы B (ширина n) := B * L^{-T}: каждая строка решается независимо
+template <typename T>
+void solveRowsLowerTransposed(const T* L, size_t ldl, size_t n, T* B, size_t ldb, size_t rowBegin, size_t rowEnd) {
+    for (size_t r = rowBegin; r < rowEnd; ++r) {
+        T* row = B + r * ldb;
+        for (size_t j = 0; j < n; ++j) {
+            const T* lj = L + j * ldl;
+            row[j] = (row[j] - dot(row, lj, j)) / lj[j];
+        }
+    }
+}
+
+// Блочный Холецкий на месте: A = L L^T. Читается только нижний треугольник,
+// верхний после разложения не определён
+template <typename T>
+bool choleskyFactor(T* A, size_t n, size_t lda) {
+    const size_t nb = std::max<size_t>(1, params().block);
+    std::vector<T> negL, transposedL;
+    for (size_t k = 0; k < n; k += nb) {
+        const size_t kb = std::min(nb, n - k);
+        T* A11 = A + k * lda + k;
+        if (!choleskyBlock(A11, lda, kb)) return false;
+        const size_t right = k + kb;
+        const size_t rest = n - right;
+        if (rest == 0) break;
+
+        // L21 = A21 * L11^{-T}, строки делятся между потоками
+        T* A21 = A + right * lda + k;
+        const size_t rowsPerTask = std::max<size_t>(1, COLUMNS_PER_TASK * COLUMNS_PER_TASK / (kb * kb));
+        const size_t rowTasks = (rest + rowsPerTask - 1) / rowsPerTask;
+        ThreadPool::global().parallelFor(rowTasks, [&](size_t t) {
+            solveRowsLowerTransposed(A11, lda, kb, A21, lda, t * rowsPerTask, std::min(rest, (t + 1) * rowsPerTask));
+        });
+
+        // A22 -= L21 * L21^T только в нижнем треугольнике: полосы по nb строк до диагонали включительно
+        negL.resize(rest * kb);
+        transposedL.resize(kb * rest);
+        for (size_t i = 0; i < rest; ++i) {
+            for (size_t q = 0; q < kb; ++q) {
+                negL[i * kb + q] = -A21[i * lda + q];
+                transposedL[q * rest + i] = A21[i * lda + q];
+            }
+        }
+        T* A22 = A + right * lda + right;
+        const size_t strips = (rest + nb - 1) / nb;
+        ThreadPool::global().parallelFor(strips, [&](size_t t) {
+            const size_t strip = strips - 1 - t; // длинные полосы первыми
+            const size_t rowBegin = strip * nb;
+            const size_t rowEnd = std::min(rest, rowBegin + nb);
+            gemm_kernel::multiplySequential(negL.data() + rowBegin * kb, kb, transposedL.data(), rest,
+                                            A22 + rowBegin * lda, lda, rowEnd - rowBegin, rowEnd, kb, true);
+        });
+    }
+    return true;
+}
+
+// ---- Подстановки для правых частей B (n x nrhs, шаг ldb) ----
+
+template <typename T>
+void applyPivots(T* B, size_t ldb, size_t n, size_t nrhs, const unsigned* pivots) {
+    swapRows(B, ldb, pivots, 0, n, 0, nrhs);
+}
+
+// Прямая подстановка L X = B; столбцы B делятся между потоками, для одного вектора - скалярные произведения
+template <typename T>
+void solveLower(const T* L, size_t ldl, size_t n, T* B, size_t ldb, size_t nrhs, bool unit) {
+    if (nrhs == 1 && ldb == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            const T* li = L + i * ldl;
+            B[i] -= dot(li, B, i);
+            if (!unit) B[i] /= li[i];
+        }
+        return;
+    }
+    forColumns(nrhs, [&](size_t begin, size_t end) {
+        solveLowerRows(L, ldl, n, B + begin, ldb, end - begin, unit);
+    });
+}
+
+// Обратная подстановка U X = B для верхнетреугольной U с диагональю
+template <typename T>
+void solveUpper(const T* U, size_t ldu, size_t n, T* B, size_t ldb, size_t nrhs) {
+    forColumns(nrhs, [&](size_t begin, size_t end) {
+        const size_t width = end - begin;
+        for (size_t i = n; i-- > 0; ) {
+            const T* ui = U + i * ldu;
+            T* bi = B + i * ldb + begin;
+            if (width == 1 && ldb == 1) {
+                bi[0] -= dot(ui + i + 1, B + i + 1, n - i - 1);
+            } else {
+                for (size_t p = i + 1; p < n; ++p) {
+                    if (ui[p] != T(0)) axpy(-ui[p], B + p * ldb + begin, bi, width);
+                }
+            }
+            const T inverse = T(1) / ui[i];
+            for (size_t c = 0; c < width; ++c) bi[c] *= inverse;
+        }
+    });
+}
+
+// L^T X = B по нижнетреугольной L: после решения строки i она вычитается из строк выше,
+// так L читается по строкам, а не по столбцам
+template <typename T>
+void solveLowerTransposed(const T* L, size_t ldl, size_t n, T* B, size_t ldb, size_t nrhs) {
+    forColumns(nrhs, [&](size_t begin, size_t end) {
+        const size_t width = end - begin;
+        for (size_t i = n; i-- > 0; ) {
+            const T* li = L + i * ldl;
+            T* bi = B + i * ldb + begin;
+            const T inverse = T(1) / li[i];
+            for (size_t c = 0; c < width; ++c) bi[c] *= inverse;
+            if (width == 1 && ldb == 1) {
+                axpy(-bi[0], li, B, i);
+            } else {
+                for (size_t p = 0; p < i; ++p) {
+                    if (li[p] != T(0)) axpy(-li[p], bi, B + p * ldb + begin, width);
+                }
+            }
+        }
+    });
+}
+
+} // namespace factorization
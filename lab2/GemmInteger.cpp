@@ -0,0 +1,271 @@
+#pragma once
+
+#include "ThreadPool.cpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Целочисленное умножение C = A * B (или C += A * B) с накоплением в более широком типе:
+// int8 и int16 - в int32, int32 - в int64, поэтому сумма k произведений не переполняется
+// (для int16 - пока k * max|a| * max|b| < 2^31, как у инструкций VNNI).
+// int8/int16: панель B упаковывается парами строк (b[q][j], b[q+1][j]), и одна инструкция
+// pmaddwd (или vpdpwssd при AVX-VNNI / AVX512-VNNI) даёт a[q] * b[q][j] + a[q+1] * b[q+1][j]
+// сразу для 8 столбцов (для 4 - pmaddwd из SSE2). Без SIMD тот же упакованный цикл
+// считается скалярно.
+// int32 и прочие типы: блочный цикл как в gemm_kernel с умножением в типе накопления.
+namespace gemm_integer {
+
+template <typename T> struct Accumulator { using type = T; };
+template <> struct Accumulator<int8_t>  { using type = int32_t; };
+template <> struct Accumulator<int16_t> { using type = int32_t; };
+template <> struct Accumulator<int32_t> { using type = int64_t; };
+
+template <typename T>
+using AccumulatorT = typename Accumulator<T>::type;
+
+// Типы, которые считаются парами через pmaddwd
+template <typename T, typename Acc>
+struct UsesPairs {
+    static const bool value = (std::is_same<T, int8_t>::value || std::is_same<T, int16_t>::value) &&
+                              std::is_same<Acc, int32_t>::value;
+};
+
+const size_t MC = 64;    // строк C в одной задаче
+const size_t KC = 512;   // глубина панели (чётная)
+const size_t NC = 1024;  // ширина панели B
+const size_t PARALLEL_THRESHOLD = size_t(64) * 64 * 64;
+
+// Панель B [k0, k1) x [j0, j1) парами строк: packed[(p * width + j) * 2 + {0, 1}];
+// при нечётной глубине вторая строка последней пары - нули
+template <typename T>
+void packPairs(const T* B, size_t ldb, size_t k0, size_t k1, size_t j0, size_t j1, int16_t* packed) {
+    const size_t width = j1 - j0;
+    for (size_t q = k0, p = 0; q < k1; q += 2, ++p) {
+        const T* b0 = B + q * ldb + j0;
+        const T* b1 = q + 1 < k1 ? b0 + ldb : nullptr;
+        int16_t* out = packed + p * width * 2;
+        for (size_t j = 0; j < width; ++j) {
+            out[2 * j] = b0[j];
+            out[2 * j + 1] = b1 != nullptr ? b1[j] : 0;
+        }
+    }
+}
+
+// Пара (a[q], a[q+1]) одним 32-битным словом - как её читает pmaddwd
+template <typename T>
+inline int32_t pairWord(const T* a, size_t q, size_t k1) {
+    const uint16_t lo = static_cast<uint16_t>(int16_t(a[q]));
+    const uint16_t hi = q + 1 < k1 ? static_cast<uint16_t>(int16_t(a[q + 1])) : 0;
+    return static_cast<int32_t>(uint32_t(lo) | (uint32_t(hi) << 16));
+}
+
+#if defined(__AVX2__)
+inline __m256i multiplyAddPairs(__m256i acc, __m256i a, __m256i b) {
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    return _mm256_dpwssd_epi32(acc, a, b);
+#elif defined(__AVXVNNI__)
+    return _mm256_dpwssd_avx_epi32(acc, a, b);
+#else
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+#endif
+}
+
+// R строк x 16 столбцов: 2R аккумуляторов в регистрах на всю глубину панели
+template <size_t R>
+inline void pairKernel(const int32_t* aWords, size_t pairs, const int16_t* packed, size_t width,
+                       int32_t* C, size_t ldc) {
+    __m256i acc[R][2];
+    for (size_t r = 0; r < R; ++r) acc[r][0] = acc[r][1] = _mm256_setzero_si256();
+    for (size_t p = 0; p < pairs; ++p) {
+        const int16_t* b = packed + p * width * 2;
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16));
+        for (size_t r = 0; r < R; ++r) {
+            const __m256i a = _mm256_set1_epi32(aWords[r * pairs + p]);
+            acc[r][0] = multiplyAddPairs(acc[r][0], a, b0);
+            acc[r][1] = multiplyAddPairs(acc[r][1], a, b1);
+        }
+    }
+    for (size_t r = 0; r < R; ++r) {
+        __m256i* c = reinterpret_cast<__m256i*>(C + r * ldc);
+        _mm256_storeu_si256(c, _mm256_add_epi32(_mm256_loadu_si256(c), acc[r][0]));
+        _mm256_storeu_si256(c + 1, _mm256_add_epi32(_mm256_loadu_si256(c + 1), acc[r][1]));
+    }
+}
+
+const size_t KERNEL_COLS = 16;
+#elif defined(__SSE2__)
+// То же на 128-битных регистрах: R строк x 8 столбцов
+template <size_t R>
+inline void pairKernel(const int32_t* aWords, size_t pairs, const int16_t* packed, size_t width,
+                       int32_t* C, size_t ldc) {
+    __m128i acc[R][2];
+    for (size_t r = 0; r < R; ++r) acc[r][0] = acc[r][1] = _mm_setzero_si128();
+    for (size_t p = 0; p < pairs; ++p) {
+        const int16_t* b = packed + p * width * 2;
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 8));
+        for (size_t r = 0; r < R; ++r) {
+            const __m128i a = _mm_set1_epi32(aWords[r * pairs + p]);
+            acc[r][0] = _mm_add_epi32(acc[r][0], _mm_madd_epi16(a, b0));
+            acc[r][1] = _mm_add_epi32(acc[r][1], _mm_madd_epi16(a, b1));
+        }
+    }
+    for (size_t r = 0; r < R; ++r) {
+        __m128i* c = reinterpret_cast<__m128i*>(C + r * ldc);
+        _mm_storeu_si128(c, _mm_add_epi32(_mm_loadu_si128(c), acc[r][0]));
+        _mm_storeu_si128(c + 1, _mm_add_epi32(_mm_loadu_si128(c + 1), acc[r][1]));
+    }
+}
+
+const size_t KERNEL_COLS = 8;
+#endif
+
+// Строки [0, rows) одной панели: aWords - пары A по строкам (rows x pairs), C уже сдвинут на j0
+inline void pairPanel(const int32_t* aWords, size_t rows, size_t pairs, const int16_t* packed, size_t width,
+                      int32_t* C, size_t ldc) {
+    size_t j = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; j + KERNEL_COLS <= width; j += KERNEL_COLS) {
+        size_t i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            pairKernel<4>(aWords + i * pairs, pairs, packed + 2 * j, width, C + i * ldc + j, ldc);
+        }
+        for (; i < rows; ++i) {
+            pairKernel<1>(aWords + i * pairs, pairs, packed + 2 * j, width, C + i * ldc + j, ldc);
+        }
+    }
+#endif
+    if (j == width) return;
+    for (size_t i = 0; i < rows; ++i) {
+        int32_t* c = C + i * ldc;
+        for (size_t p = 0; p < pairs; ++p) {
+            const int32_t word = aWords[i * pairs + p];
+            const int32_t a0 = int16_t(word & 0xFFFF), a1 = int16_t(uint32_t(word) >> 16);
+            const int16_t* b = packed + p * width * 2;
+            for (size_t jj = j; jj < width; ++jj) {
+                c[jj] += a0 * b[2 * jj] + a1 * b[2 * jj + 1];
+            }
+        }
+    }
+}
+
+// Блочный цикл с умножением в типе накопления; 4 строки C за раз, как в gemm_kernel
+template <typename T, typename Acc>
+void wideRows(const T* A, size_t lda, const T* B, size_t ldb, Acc* C, size_t ldc,
+              size_t rowBegin, size_t rowEnd, size_t k0, size_t k1, size_t j0, size_t j1) {
+    size_t i = rowBegin;
+    for (; i + 4 <= rowEnd; i += 4) {
+        Acc* c0 = C + i * ldc;
+        Acc* c1 = c0 + ldc;
+        Acc* c2 = c1 + ldc;
+        Acc* c3 = c2 + ldc;
+        for (size_t q = k0; q < k1; ++q) {
+            const Acc a0 = A[i * lda + q];
+            const Acc a1 = A[(i + 1) * lda + q];
+            const Acc a2 = A[(i + 2) * lda + q];
+            const Acc a3 = A[(i + 3) * lda + q];
+            const T* b = B + q * ldb;
+            for (size_t j = j0; j < j1; ++j) {
+                const Acc bj = b[j];
+                c0[j] += a0 * bj;
+                c1[j] += a1 * bj;
+                c2[j] += a2 * bj;
+                c3[j] += a3 * bj;
+            }
+        }
+    }
+    for (; i < rowEnd; ++i) {
+        Acc* c = C + i * ldc;
+        for (size_t q = k0; q < k1; ++q) {
+            const Acc a = A[i * lda + q];
+            const T* b = B + q * ldb;
+            for (size_t j = j0; j < j1; ++j) c[j] += a * Acc(b[j]);
+        }
+    }
+}
+
+// C (m x n, тип накопления) = A (m x k) * B (k x n); при accumulate результат прибавляется к C.
+// parallel = false - всё в вызывающем потоке (для вызова из задач пула).
+template <typename T, typename Acc = AccumulatorT<T>>
+void multiply(const T* A, size_t lda, const T* B, size_t ldb, Acc* C, size_t ldc,
+              size_t m, size_t n, size_t k, bool accumulate, bool parallel = true) {
+    static_assert(std::is_integral<T>::value && std::is_integral<Acc>::value, "Integer GEMM expects integer types.");
+    if (!accumulate) {
+        for (size_t i = 0; i < m; ++i) std::fill(C + i * ldc, C + i * ldc + n, Acc(0));
+    }
+    const size_t panels = (m + MC - 1) / MC;
+    const bool useThreads = parallel && panels > 1 && m * n * k >= PARALLEL_THRESHOLD;
+    auto forPanels = [&](auto f) {
+        if (useThreads) {
+            ThreadPool::global().parallelFor(panels, [&](size_t panel) {
+                f(panel * MC, std::min(m, (panel + 1) * MC));
+            });
+        } else {
+            f(size_t(0), m);
+        }
+    };
+
+    if constexpr (UsesPairs<T, Acc>::value) {
+        std::vector<int16_t> packed;
+        for (size_t k0 = 0; k0 < k; k0 += KC) {
+            const size_t k1 = std::min(k0 + KC, k);
+            const size_t pairs = (k1 - k0 + 1) / 2;
+            for (size_t j0 = 0; j0 < n; j0 += NC) {
+                const size_t j1 = std::min(j0 + NC, n);
+                packed.resize(pairs * (j1 - j0) * 2);
+                packPairs(B, ldb, k0, k1, j0, j1, packed.data());
+                forPanels([&](size_t rowBegin, size_t rowEnd) {
+                    thread_local std::vector<int32_t> aWords;
+                    aWords.resize((rowEnd - rowBegin) * pairs);
+                    for (size_t i = rowBegin; i < rowEnd; ++i) {
+                        for (size_t p = 0; p < pairs; ++p) {
+                            aWords[(i - rowBegin) * pairs + p] = pairWord(A + i * lda, k0 + 2 * p, k1);
+                        }
+                    }
+                    pairPanel(aWords.data(), rowEnd - rowBegin, pairs, packed.data(), j1 - j0,
+                              C + rowBegin * ldc + j0, ldc);
+                });
+            }
+        }
+    } else {
+        forPanels([&](size_t rowBegin, size_t rowEnd) {
+            for (size_t k0 = 0; k0 < k; k0 += KC) {
+                for (size_t j0 = 0; j0 < n; j0 += NC) {
+                    wideRows(A, lda, B, ldb, C, ldc, rowBegin, rowEnd, k0, std::min(k0 + KC, k), j0, std::min(j0 + NC, n));
+                }
+            }
+        });
+    }
+}
+
+// Результат в исходном типе T: произведение считается точно в типе накопления
+// и только в конце приводится к T (как при умножении с накоплением в T без переполнений)
+template <typename T>
+void multiplyNarrow(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+                    size_t m, size_t n, size_t k, bool accumulate, bool parallel = true) {
+    using Acc = AccumulatorT<T>;
+    thread_local std::vector<Acc> wide;
+    wide.resize(m * n);
+    // Буфер потока забирается на время вызова: вложенный вызов в этом же потоке получит свой
+    std::vector<Acc> local;
+    local.swap(wide);
+    multiply(A, lda, B, ldb, local.data(), n, m, n, k, false, parallel);
+    for (size_t i = 0; i < m; ++i) {
+        T* c = C + i * ldc;
+        const Acc* w = local.data() + i * n;
+        for (size_t j = 0; j < n; ++j) {
+            c[j] = accumulate ? static_cast<T>(Acc(c[j]) + w[j]) : static_cast<T>(w[j]);
+        }
+    }
+    local.swap(wide);
+}
+
+} // namespace gemm_integer
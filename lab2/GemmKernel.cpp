@@ -0,0 +1,177 @@
+#pragma once
+
+#include "GemmInteger.cpp"
+#include "ThreadPool.cpp"
+#include "TransposeKernel.cpp"
+#include "TuningProfile.cpp"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Блочное умножение C = A * B (или C += A * B) для непрерывных массивов с шагом строки ld.
+// Панель B размером kc x nc держится в L2, строки C обновляются по 4 за раз, чтобы каждую
+// загруженную строку B использовать четырежды; внутренний цикл по j векторизуется компилятором.
+// int8/int16/int32 считаются ядром gemm_integer с накоплением в более широком типе.
+namespace gemm_kernel {
+
+struct Params {
+    size_t mc = 64;      // строк C в одной задаче
+    size_t kc = 256;     // глубина панели
+    size_t nc = 1024;    // ширина панели B
+    size_t threads = 0;  // 1 - в вызывающем потоке, иначе все потоки общего пула
+};
+
+// Начальные значения - из профиля автонастройки этой машины, если он есть
+inline Params& params() {
+    static Params current = []() {
+        const tuning_profile::Profile& profile = tuning_profile::current();
+        Params loaded;
+        loaded.mc = profile.mc;
+        loaded.kc = profile.kc;
+        loaded.nc = profile.nc;
+        loaded.threads = profile.threads;
+        return loaded;
+    }();
+    return current;
+}
+
+// Произведения меньше этого объёма (m*n*k) считаются в вызывающем потоке
+const size_t PARALLEL_THRESHOLD = size_t(64) * 64 * 64;
+
+// Строки [rowBegin, rowEnd) результата, без распараллеливания
+template <typename T>
+void multiplyRows(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+                  size_t rowBegin, size_t rowEnd, size_t n, size_t k, const Params& p) {
+    for (size_t kk = 0; kk < k; kk += p.kc) {
+        const size_t kEnd = std::min(kk + p.kc, k);
+        for (size_t jj = 0; jj < n; jj += p.nc) {
+            const size_t jEnd = std::min(jj + p.nc, n);
+            size_t i = rowBegin;
+            for (; i + 4 <= rowEnd; i += 4) {
+                T* c0 = C + i * ldc;
+                T* c1 = c0 + ldc;
+                T* c2 = c1 + ldc;
+                T* c3 = c2 + ldc;
+                for (size_t q = kk; q < kEnd; ++q) {
+                    const T a0 = A[i * lda + q];
+                    const T a1 = A[(i + 1) * lda + q];
+                    const T a2 = A[(i + 2) * lda + q];
+                    const T a3 = A[(i + 3) * lda + q];
+                    const T* b = B + q * ldb;
+                    for (size_t j = jj; j < jEnd; ++j) {
+                        const T bj = b[j];
+                        c0[j] += a0 * bj;
+                        c1[j] += a1 * bj;
+                        c2[j] += a2 * bj;
+                        c3[j] += a3 * bj;
+                    }
+                }
+            }
+            for (; i < rowEnd; ++i) {
+                T* c = C + i * ldc;
+                for (size_t q = kk; q < kEnd; ++q) {
+                    const T a = A[i * lda + q];
+                    const T* b = B + q * ldb;
+                    for (size_t j = jj; j < jEnd; ++j) {
+                        c[j] += a * b[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// C (m x n) = A (m x k) * B (k x n); при accumulate результат прибавляется к C
+template <typename T>
+void multiplySequential(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+                        size_t m, size_t n, size_t k, bool accumulate) {
+    if constexpr (!std::is_same<T, gemm_integer::AccumulatorT<T>>::value) {
+        gemm_integer::multiplyNarrow(A, lda, B, ldb, C, ldc, m, n, k, accumulate, false);
+        return;
+    }
+    if (!accumulate) {
+        for (size_t i = 0; i < m; ++i) std::fill(C + i * ldc, C + i * ldc + n, T(0));
+    }
+    multiplyRows(A, lda, B, ldb, C, ldc, 0, m, n, k, params());
+}
+
+// То же, но панели строк по mc раздаются потокам общего пула. epilogue(rowBegin, rowEnd)
+// вызывается для каждой готовой полосы строк C, пока она ещё в кэше: так поэлементные
+// операции над результатом (C + D и т.п.) сливаются с умножением без отдельного прохода.
+template <typename T, typename Epilogue>
+void multiply(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+              size_t m, size_t n, size_t k, bool accumulate, Epilogue epilogue) {
+    if constexpr (!std::is_same<T, gemm_integer::AccumulatorT<T>>::value) {
+        gemm_integer::multiplyNarrow(A, lda, B, ldb, C, ldc, m, n, k, accumulate, params().threads != 1);
+        epilogue(size_t(0), m);
+        return;
+    }
+    const Params p = params();
+    const size_t panels = (m + p.mc - 1) / p.mc;
+    auto panel = [&](size_t index) {
+        const size_t rowBegin = index * p.mc;
+        const size_t rowEnd = std::min(rowBegin + p.mc, m);
+        if (!accumulate) {
+            for (size_t i = rowBegin; i < rowEnd; ++i) std::fill(C + i * ldc, C + i * ldc + n, T(0));
+        }
+        multiplyRows(A, lda, B, ldb, C, ldc, rowBegin, rowEnd, n, k, p);
+        epilogue(rowBegin, rowEnd);
+    };
+    if (m * n * k < PARALLEL_THRESHOLD || p.threads == 1) {
+        for (size_t index = 0; index < panels; ++index) panel(index);
+        return;
+    }
+    ThreadPool::global().parallelFor(panels, panel);
+}
+
+template <typename T>
+void multiply(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+              size_t m, size_t n, size_t k, bool accumulate) {
+    multiply(A, lda, B, ldb, C, ldc, m, n, k, accumulate, [](size_t, size_t) {});
+}
+
+// C (m x n) = A (m x k) * B^T, где B (n x k) лежит по строкам с шагом ldb. B^T не создаётся:
+// панель kc x nc упаковывается транспонированием прямо из строк B (упаковка всё равно
+// копирует панель, так что чтение поперёк ничего не добавляет) и дальше считается тем же
+// multiplyRows. parallel - раздавать полосы строк по mc потокам пула
+template <typename T>
+void multiplyTransposed(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+                        size_t m, size_t n, size_t k, bool accumulate, bool parallel = true) {
+    if constexpr (!std::is_same<T, gemm_integer::AccumulatorT<T>>::value) {
+        // узкие целые считает gemm_integer, ему нужна B^T целиком
+        std::vector<T> transposed(n * k);
+        transpose_kernel::transposeRecursive(B, ldb, transposed.data(), n, n, k);
+        gemm_integer::multiplyNarrow(A, lda, transposed.data(), n, C, ldc, m, n, k, accumulate,
+                                     parallel && params().threads != 1);
+        return;
+    }
+    const Params p = params();
+    if (!accumulate) {
+        for (size_t i = 0; i < m; ++i) std::fill(C + i * ldc, C + i * ldc + n, T(0));
+    }
+    thread_local std::vector<T> packed;
+    packed.resize(std::min(p.kc, k) * std::min(p.nc, n));
+    const size_t panels = (m + p.mc - 1) / p.mc;
+    const bool useThreads = parallel && p.threads != 1 && m * n * k >= PARALLEL_THRESHOLD;
+    for (size_t kk = 0; kk < k; kk += p.kc) {
+        const size_t kb = std::min(p.kc, k - kk);
+        for (size_t jj = 0; jj < n; jj += p.nc) {
+            const size_t nb = std::min(p.nc, n - jj);
+            // строки jj.. B, столбцы kk.. -> панель kb x nb с шагом nb
+            transpose_kernel::transposeRecursive(B + jj * ldb + kk, ldb, packed.data(), nb, nb, kb);
+            const T* panel = packed.data();
+            auto rows = [&](size_t index) {
+                const size_t rowBegin = index * p.mc;
+                multiplyRows(A + kk, lda, panel, nb, C + jj, ldc, rowBegin, std::min(rowBegin + p.mc, m), nb, kb, p);
+            };
+            if (useThreads) {
+                ThreadPool::global().parallelFor(panels, rows);
+            } else {
+                for (size_t index = 0; index < panels; ++index) rows(index);
+            }
+        }
+    }
+}
+
+} // namespace gemm_kernel
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "GemmKernel.cpp"
+#include "MatrixBlock.cpp"
+#include "MatrixDense.cpp"
+#include "ThreadPool.cpp"
+#include "TuningProfile.cpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Автонастройка умножения под локальную машину: перебор параметров блочного ядра
+// (глубина kc и ширина nc панели B, высота mc полосы строк - она же единица работы
+// потока, и число потоков), затем размера блока MatrixBlock. Кандидаты kc x nc
+// отбираются по размеру L2, параметры подбираются по очереди (координатный спуск) на
+// умножении n x n. Победители применяются сразу и сохраняются в профиль, который
+// gemm_kernel::params() и MatrixBlock::fromDense читают при следующем запуске.
+namespace gemm_tuner {
+
+struct Options {
+    size_t n = 512;         // размер тестового умножения
+    size_t repeats = 3;     // лучший из повторов
+    bool verbose = true;
+};
+
+struct Result {
+    tuning_profile::Profile profile;
+    double defaultMs = 0;   // умножение n x n с параметрами по умолчанию
+    double tunedMs = 0;     // с найденными
+    double blockMs = 0;     // MatrixBlock n x n с найденным размером блока
+};
+
+inline gemm_kernel::Params toParams(const tuning_profile::Profile& profile) {
+    gemm_kernel::Params p;
+    p.mc = profile.mc;
+    p.kc = profile.kc;
+    p.nc = profile.nc;
+    p.threads = profile.threads;
+    return p;
+}
+
+template <typename Func>
+double bestMs(size_t repeats, Func f) {
+    double best = std::numeric_limits<double>::max();
+    for (size_t r = 0; r < std::max<size_t>(repeats, 1); ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// Пары (kc, nc), для которых панель B double помещается в L2 (хотя бы одна остаётся)
+inline std::vector<std::pair<size_t, size_t>> panelCandidates(const tuning_profile::CacheSizes& caches) {
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t kc : {64, 128, 256, 512}) {
+        for (size_t nc : {256, 512, 1024, 2048}) {
+            if (kc * nc * sizeof(double) <= caches.l2) candidates.push_back({kc, nc});
+        }
+    }
+    if (candidates.empty()) candidates.push_back({64, 256});
+    return candidates;
+}
+
+inline Result tune(const Options& options = Options()) {
+    const size_t n = options.n;
+    MatrixDense<double> a(static_cast<unsigned>(n), static_cast<unsigned>(n));
+    MatrixDense<double> b(static_cast<unsigned>(n), static_cast<unsigned>(n));
+    std::mt19937 gen(38);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (size_t e = 0; e < n * n; ++e) {
+        a.getData()[e] = dist(gen);
+        b.getData()[e] = dist(gen);
+    }
+    std::vector<double> c(n * n);
+
+    const gemm_kernel::Params saved = gemm_kernel::params();
+    auto measure = [&](const tuning_profile::Profile& candidate) {
+        gemm_kernel::params() = toParams(candidate);
+        const double ms = bestMs(options.repeats, [&]() {
+            gemm_kernel::multiply(a.getData(), n, b.getData(), n, c.data(), n, n, n, n, false);
+        });
+        if (options.verbose) {
+            std::cout << "  mc " << candidate.mc << ", kc " << candidate.kc << ", nc " << candidate.nc << ", threads "
+                      << (candidate.threads == 1 ? "1" : "all") << ": " << ms << "ms\n";
+        }
+        return ms;
+    };
+
+    Result result;
+    tuning_profile::Profile best = tuning_profile::defaults();
+    best.machine = tuning_profile::machineSignature();
+    if (options.verbose) std::cout << "Tuning GEMM on " << best.machine << "\n";
+    result.defaultMs = measure(best);
+    double bestTime = result.defaultMs;
+    auto consider = [&](const tuning_profile::Profile& candidate) {
+        const double ms = measure(candidate);
+        if (ms < bestTime) {
+            bestTime = ms;
+            best = candidate;
+        }
+    };
+
+    for (const auto& panel : panelCandidates(tuning_profile::cacheSizes())) {
+        tuning_profile::Profile candidate = best;
+        candidate.kc = panel.first;
+        candidate.nc = panel.second;
+        if (candidate.kc != best.kc || candidate.nc != best.nc) consider(candidate);
+    }
+    const tuning_profile::Profile afterPanels = best;
+    for (size_t mc : {16, 32, 64, 128, 256}) {
+        if (mc == afterPanels.mc || mc > n) continue;
+        tuning_profile::Profile candidate = afterPanels;
+        candidate.mc = mc;
+        consider(candidate);
+    }
+    if (ThreadPool::global().size() > 0) {
+        tuning_profile::Profile candidate = best;
+        candidate.threads = best.threads == 1 ? 0 : 1;
+        consider(candidate);
+    }
+    result.tunedMs = bestTime;
+    gemm_kernel::params() = toParams(best);
+
+    // Размер блока MatrixBlock - на том же произведении с уже найденными параметрами ядра
+    double bestBlockTime = std::numeric_limits<double>::max();
+    for (unsigned blockSize : {16u, 32u, 64u, 128u, 256u}) {
+        if (blockSize > n) continue;
+        std::unique_ptr<MatrixBlock<double>> x(MatrixBlock<double>::fromDense(a, blockSize));
+        std::unique_ptr<MatrixBlock<double>> y(MatrixBlock<double>::fromDense(b, blockSize));
+        const Matrix<double>& right = *y;
+        const double ms = bestMs(options.repeats, [&]() {
+            Matrix<double>* product = (*x) * right;
+            delete product;
+        });
+        if (options.verbose) std::cout << "  MatrixBlock block " << blockSize << ": " << ms << "ms\n";
+        if (ms < bestBlockTime) {
+            bestBlockTime = ms;
+            best.blockSize = blockSize;
+        }
+    }
+    result.blockMs = bestBlockTime;
+    best.loaded = true;
+    result.profile = best;
+    gemm_kernel::params() = saved;
+    return result;
+}
+
+// Настройка, применение найденных параметров в этом процессе и запись профиля
+inline Result tuneAndSave(const std::string& filename = tuning_profile::defaultPath(), const Options& options = Options()) {
+    Result result = tune(options);
+    tuning_profile::write(filename, result.profile);
+    tuning_profile::current() = result.profile;
+    gemm_kernel::params() = toParams(result.profile);
+    return result;
+}
+
+} // namespace gemm_tuner
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// Описание локальной машины: процессор и топология (ядра, SMT, сокеты, NUMA) из
+// /proc/cpuinfo и /sys/devices/system, кэши из sysfs, память из /proc/meminfo, сетевые
+// интерфейсы из /sys/class/net. Читается один раз (local()); по нему выбираются значения
+// по умолчанию: число потоков пула, панели GEMM, разбиение Vector на части. Если файлов
+// нет (не Linux, урезанный контейнер), остаются типичные значения.
+namespace hardware_info {
+
+struct Cache {
+    unsigned level = 0;
+    std::string type;       // Data, Instruction, Unified
+    size_t size = 0;        // байт
+    size_t lineSize = 64;
+    unsigned sharedBy = 1;  // логических процессоров на один экземпляр кэша
+};
+
+struct NetworkInterface {
+    std::string name;
+    double speedGbps = 0;   // 0 - скорость неизвестна (виртуальный интерфейс, нет линка)
+};
+
+struct Info {
+    std::string cpuModel = "unknown";
+    double frequencyGhz = 0;     // максимальная, если известна, иначе текущая
+    unsigned logicalCpus = 1;    // включённые логические процессоры
+    unsigned usableCpus = 1;     // доступные процессу (маска привязки, cgroup cpuset)
+    unsigned physicalCores = 1;
+    unsigned threadsPerCore = 1; // SMT
+    unsigned sockets = 1;
+    unsigned numaNodes = 1;
+    std::vector<Cache> caches;   // кэши первого процессора
+    size_t l1d = 32 * 1024;      // сводка по caches
+    size_t l2 = 256 * 1024;
+    size_t l3 = 8 * 1024 * 1024;
+    size_t cacheLine = 64;
+    size_t memoryBytes = 0;
+    size_t availableMemoryBytes = 0;
+    std::vector<NetworkInterface> network;
+
+    // Потоков для задач, упирающихся в вычисления: SMT-соседи делят одно ядро
+    unsigned computeThreads() const { return std::max(1u, usableCpus / threadsPerCore); }
+    // Потоков для задач, упирающихся в память: все доступные логические процессоры
+    unsigned memoryThreads() const { return std::max(1u, usableCpus); }
+};
+
+inline bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::getline(file, text);
+    return !file.bad() && !text.empty();
+}
+
+inline bool readNumber(const std::string& path, long long& value) {
+    std::string text;
+    if (!readText(path, text)) return false;
+    std::istringstream in(text);
+    return bool(in >> value);
+}
+
+// "48K", "2048K", "300M" -> байты
+inline size_t parseSize(const std::string& text) {
+    std::istringstream in(text);
+    size_t value = 0;
+    char unit = 0;
+    in >> value >> unit;
+    switch (unit) {
+    case 'K': case 'k': return value * 1024;
+    case 'M': case 'm': return value * 1024 * 1024;
+    case 'G': case 'g': return value * 1024 * 1024 * 1024;
+    default: return value;
+    }
+}
+
+// Список процессоров "0-3,8,10-11" -> номера
+inline std::vector<unsigned> parseCpuList(const std::string& text) {
+    std::vector<unsigned> cpus;
+    std::istringstream in(text);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty()) continue;
+        const size_t dash = range.find('-');
+        try {
+            const unsigned first = unsigned(std::stoul(range.substr(0, dash)));
+            const unsigned last = dash == std::string::npos ? first : unsigned(std::stoul(range.substr(dash + 1)));
+            for (unsigned cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+inline std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> names;
+#if defined(__linux__)
+    if (DIR* dir = opendir(path.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..") names.push_back(name);
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+#else
+    (void)path;
+#endif
+    return names;
+}
+
+// root - префикс для /proc и /sys, чтобы разбирать сохранённую копию чужой машины
+inline Info discover(const std::string& root = "") {
+    Info info;
+    const unsigned reported = std::thread::hardware_concurrency();
+    info.logicalCpus = info.usableCpus = info.physicalCores = reported == 0 ? 1 : reported;
+
+    // /proc/cpuinfo: модель, частота и пары (сокет, ядро) на случай, если sysfs нет
+    std::set<std::pair<long, long>> cpuinfoCores;
+    std::set<long> cpuinfoSockets;
+    {
+        std::ifstream cpuinfo(root + "/proc/cpuinfo");
+        std::string line;
+        long socket = 0;
+        bool modelFound = false;
+        double mhz = 0;
+        while (std::getline(cpuinfo, line)) {
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string key = line.substr(0, colon);
+            key.erase(key.find_last_not_of(" \t") + 1);
+            const size_t start = line.find_first_not_of(" \t", colon + 1);
+            const std::string value = start == std::string::npos ? "" : line.substr(start);
+            try {
+                if (key == "model name" && !modelFound) {
+                    info.cpuModel = value;
+                    modelFound = true;
+                } else if (key == "cpu MHz" && mhz == 0) {
+                    mhz = std::stod(value);
+                } else if (key == "physical id") {
+                    socket = std::stol(value);
+                    cpuinfoSockets.insert(socket);
+                } else if (key == "core id") {
+                    cpuinfoCores.insert({socket, std::stol(value)});
+                }
+            } catch (const std::exception&) {
+                // нечисловое значение - поле пропускается
+            }
+        }
+        info.frequencyGhz = mhz / 1000;
+    }
+
+    // Топология из sysfs: включённые процессоры, их ядра и сокеты
+    const std::string cpuRoot = root + "/sys/devices/system/cpu/";
+    std::string text;
+    std::vector<unsigned> online;
+    if (readText(cpuRoot + "online", text)) online = parseCpuList(text);
+    std::set<std::pair<long long, long long>> cores;
+    std::set<long long> sockets;
+    for (unsigned cpu : online) {
+        const std::string topology = cpuRoot + "cpu" + std::to_string(cpu) + "/topology/";
+        long long package = 0, core = 0;
+        if (readNumber(topology + "physical_package_id", package) && readNumber(topology + "core_id", core)) {
+            cores.insert({package, core});
+            sockets.insert(package);
+        }
+    }
+    if (!online.empty()) info.logicalCpus = unsigned(online.size());
+    if (!cores.empty()) {
+        info.physicalCores = unsigned(cores.size());
+        info.sockets = unsigned(sockets.size());
+    } else if (!cpuinfoCores.empty()) {
+        info.physicalCores = unsigned(cpuinfoCores.size());
+        info.sockets = unsigned(std::max<size_t>(1, cpuinfoSockets.size()));
+    }
+    info.physicalCores = std::min(info.physicalCores, info.logicalCpus);
+    info.threadsPerCore = std::max(1u, info.logicalCpus / std::max(1u, info.physicalCores));
+    long long khz = 0;
+    if (readNumber(cpuRoot + "cpu0/cpufreq/cpuinfo_max_freq", khz) && khz > 0) info.frequencyGhz = khz / 1e6;
+
+    info.usableCpus = info.logicalCpus;
+#if defined(__linux__)
+    if (root.empty()) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0 && CPU_COUNT(&mask) > 0) info.usableCpus = unsigned(CPU_COUNT(&mask));
+    }
+#endif
+
+    // Кэши первого процессора
+    for (const std::string& index : listDirectory(cpuRoot + "cpu0/cache")) {
+        if (index.compare(0, 5, "index") != 0) continue;
+        const std::string path = cpuRoot + "cpu0/cache/" + index + "/";
+        Cache cache;
+        long long level = 0, line = 0;
+        if (!readNumber(path + "level", level) || !readText(path + "type", cache.type) || !readText(path + "size", text)) continue;
+        cache.level = unsigned(level);
+        cache.size = parseSize(text);
+        if (readNumber(path + "coherency_line_size", line) && line > 0) cache.lineSize = size_t(line);
+        if (readText(path + "shared_cpu_list", text)) cache.sharedBy = unsigned(std::max<size_t>(1, parseCpuList(text).size()));
+        info.caches.push_back(cache);
+        if (cache.type == "Instruction" || cache.size == 0) continue;
+        if (cache.level == 1) info.l1d = cache.size;
+        else if (cache.level == 2) info.l2 = cache.size;
+        else if (cache.level == 3) info.l3 = cache.size;
+        if (cache.level == 1) info.cacheLine = cache.lineSize;
+    }
+
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    // без sysfs размеры кэшей может сообщить libc
+    if (info.caches.empty() && root.empty()) {
+        const long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        const long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (l1 > 0) info.l1d = size_t(l1);
+        if (l2 > 0) info.l2 = size_t(l2);
+        if (l3 > 0) info.l3 = size_t(l3);
+    }
+#endif
+
+    if (readText(root + "/sys/devices/system/node/online", text)) {
+        info.numaNodes = unsigned(std::max<size_t>(1, parseCpuList(text).size()));
+    }
+
+    {
+        std::ifstream meminfo(root + "/proc/meminfo");
+        std::string key;
+        size_t kilobytes;
+        std::string unit;
+        while (meminfo >> key >> kilobytes) {
+            std::getline(meminfo, unit);
+            if (key == "MemTotal:") info.memoryBytes = kilobytes * 1024;
+            else if (key == "MemAvailable:") info.availableMemoryBytes = kilobytes * 1024;
+        }
+    }
+
+    // Сетевые интерфейсы, кроме loopback; speed в Мбит/с, -1 или ошибка чтения - неизвестна
+    const std::string netRoot = root + "/sys/class/net/";
+    for (const std::string& name : listDirectory(netRoot)) {
+        if (name == "lo") continue;
+        NetworkInterface nic;
+        nic.name = name;
+        long long mbps = 0;
+        if (readNumber(netRoot + name + "/speed", mbps) && mbps > 0) nic.speedGbps = mbps / 1000.0;
+        info.network.push_back(nic);
+    }
+    return info;
+}
+
+// Описание этой машины, читается при первом обращении
+inline const Info& local() {
+    static const Info info = discover();
+    return info;
+}
+
+} // namespace hardware_info
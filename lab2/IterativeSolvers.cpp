@@ -0,0 +1,309 @@
+#pragma once
+
+#include "MatrixVector.cpp"
+#include "ThreadPool.cpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// Итерационные методы Крылова над любой Matrix<T>: сопряжённые градиенты (CG/PCG) для
+// симметричных положительно определённых систем и BiCGSTAB для несимметричных.
+// Предобусловливатель Якоби - MatrixDiagonal с диагональю A. Векторные операции одной
+// итерации слиты в несколько параллельных проходов по памяти, а все рабочие векторы
+// выделяются один раз в KrylovSolver и переиспользуются между решениями.
+namespace iterative {
+
+struct Params {
+    size_t maxIterations = 1000;
+    double tolerance = 1e-10;  // по относительной невязке ||b - A x|| / ||b||
+};
+
+struct Report {
+    size_t iterations = 0;
+    double residual = 0;       // относительная невязка на выходе
+    bool converged = false;
+    double totalMs = 0;
+    double msPerIteration = 0;
+};
+
+// Элементов векторов на одну задачу пула в проходе
+const size_t SWEEP_CHUNK = 1 << 14;
+
+// Параллельный проход по [0, n): f(begin, end) обновляет свой отрезок и возвращает K частичных
+// сумм. Суммы складываются в порядке отрезков, поэтому результат не зависит от числа потоков.
+template <size_t K, typename Func>
+std::array<double, K> sweep(size_t n, Func f) {
+    const size_t chunks = (n + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    std::vector<std::array<double, K>> partial(chunks);
+    auto run = [&](size_t c) { partial[c] = f(c * SWEEP_CHUNK, std::min(n, (c + 1) * SWEEP_CHUNK)); };
+    if (chunks <= 1) {
+        if (chunks == 1) run(0);
+    } else {
+        ThreadPool::global().parallelFor(chunks, run);
+    }
+    std::array<double, K> total{};
+    for (const auto& sums : partial)
+        for (size_t k = 0; k < K; ++k) total[k] += sums[k];
+    return total;
+}
+
+// Диагональ A как предобусловливатель Якоби
+template <typename T>
+MatrixDiagonal<T>* jacobiPreconditioner(const Matrix<T>& A) {
+    const size_t n = matrix_vector::rows(A);
+    MatrixDiagonal<T>* diagonal = new MatrixDiagonal<T>(static_cast<unsigned>(n));
+    for (unsigned i = 0; i < n; ++i) {
+        diagonal->getData()[i] = A(i, i);
+    }
+    return diagonal;
+}
+
+template <typename T>
+class KrylovSolver {
+private:
+    size_t _n;
+    std::vector<T> _inverseDiagonal;  // M^{-1} предобусловливателя Якоби (единицы без него)
+    // CG использует r, p, q; BiCGSTAB - все (q служит вектором v = A y)
+    Vector<T> _r, _p, _q, _rhat, _y, _z, _t;
+
+    static Vector<T> zeros(size_t n) {
+        Vector<T> v(n);
+        v.initialize(T(0));
+        return v;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    static double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Проверка размеров, M^{-1} и r = b - A x. Возвращает ||b||.
+    double prepare(const Matrix<T>& A, const Vector<T>& b, Vector<T>& x, const MatrixDiagonal<T>* preconditioner) {
+        b.check_initialization();
+        x.check_initialization();
+        if (b.size() != _n || x.size() != _n || matrix_vector::rows(A) != _n) {
+            throw std::invalid_argument("System size does not match the solver.");
+        }
+        if (preconditioner != nullptr) {
+            if (preconditioner->getSize() != _n) {
+                throw std::invalid_argument("Preconditioner size does not match the system.");
+            }
+            const T* d = preconditioner->getData();
+            for (size_t i = 0; i < _n; ++i) {
+                if (d[i] == T(0)) {
+                    throw std::invalid_argument("Jacobi preconditioner has a zero diagonal entry.");
+                }
+                _inverseDiagonal[i] = T(1) / d[i];
+            }
+        } else {
+            std::fill(_inverseDiagonal.begin(), _inverseDiagonal.end(), T(1));
+        }
+        std::copy(b.data_ptr(), b.data_ptr() + _n, _r.data_ptr());
+        matrix_vector::gemv(A, x, _r, T(-1), T(1));
+        const T* bd = b.data_ptr();
+        return std::sqrt(sweep<1>(_n, [&](size_t begin, size_t end) {
+            double bb = 0;
+            for (size_t i = begin; i < end; ++i) bb += double(bd[i]) * bd[i];
+            return std::array<double, 1>{bb};
+        })[0]);
+    }
+
+    static void finish(Report& report, double rr, double normB, Clock::time_point start, double tolerance) {
+        report.residual = std::sqrt(rr) / normB;
+        report.converged = report.residual <= tolerance;
+        report.totalMs = elapsedMs(start);
+        report.msPerIteration = report.iterations > 0 ? report.totalMs / report.iterations : 0;
+    }
+
+public:
+    explicit KrylovSolver(size_t n)
+        : _n(n), _inverseDiagonal(n, T(1)), _r(zeros(n)), _p(zeros(n)), _q(zeros(n)), _rhat(zeros(n)),
+          _y(zeros(n)), _z(zeros(n)), _t(zeros(n)) {}
+
+    size_t size() const { return _n; }
+
+    // (P)CG для симметричной положительно определённой A; x - начальное приближение и результат.
+    // На итерацию: умножение q = A p и три прохода по векторам -
+    //   (p, q);  x += a p, r -= a q, (r, M^{-1} r), (r, r);  p = M^{-1} r + b p.
+    // z = M^{-1} r не хранится: он вычисляется на лету в обоих проходах, где нужен.
+    Report conjugateGradient(const Matrix<T>& A, const Vector<T>& b, Vector<T>& x,
+                             const MatrixDiagonal<T>* preconditioner = nullptr, const Params& params = Params()) {
+        const auto start = Clock::now();
+        Report report;
+        const double normB = prepare(A, b, x, preconditioner);
+        T* xd = x.data_ptr();
+        T* r = _r.data_ptr();
+        T* p = _p.data_ptr();
+        T* q = _q.data_ptr();
+        const T* m = _inverseDiagonal.data();
+        if (normB == 0) {
+            std::fill(xd, xd + _n, T(0));
+            report.converged = true;
+            report.totalMs = elapsedMs(start);
+            return report;
+        }
+
+        auto init = sweep<2>(_n, [&](size_t begin, size_t end) {
+            double rz = 0, rr = 0;
+            for (size_t i = begin; i < end; ++i) {
+                p[i] = m[i] * r[i];
+                rz += double(r[i]) * p[i];
+                rr += double(r[i]) * r[i];
+            }
+            return std::array<double, 2>{rz, rr};
+        });
+        double rz = init[0], rr = init[1];
+
+        while (report.iterations < params.maxIterations && std::sqrt(rr) / normB > params.tolerance) {
+            matrix_vector::gemv(A, _p, _q);
+            const double pq = sweep<1>(_n, [&](size_t begin, size_t end) {
+                double sum = 0;
+                for (size_t i = begin; i < end; ++i) sum += double(p[i]) * q[i];
+                return std::array<double, 1>{sum};
+            })[0];
+            if (pq == 0) break; // A не положительно определена или вырождение направления
+            const T alpha = T(rz / pq);
+
+            auto sums = sweep<2>(_n, [&](size_t begin, size_t end) {
+                double rzNew = 0, rrNew = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    xd[i] += alpha * p[i];
+                    r[i] -= alpha * q[i];
+                    rzNew += double(r[i]) * m[i] * r[i];
+                    rrNew += double(r[i]) * r[i];
+                }
+                return std::array<double, 2>{rzNew, rrNew};
+            });
+            const T beta = T(sums[0] / rz);
+            rz = sums[0];
+            rr = sums[1];
+
+            sweep<0>(_n, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) p[i] = m[i] * r[i] + beta * p[i];
+                return std::array<double, 0>{};
+            });
+            ++report.iterations;
+        }
+        finish(report, rr, normB, start, params.tolerance);
+        return report;
+    }
+
+    // BiCGSTAB с правым предобусловливанием Якоби для несимметричных систем.
+    // На итерацию: два умножения на A и пять проходов по векторам.
+    Report biCGStab(const Matrix<T>& A, const Vector<T>& b, Vector<T>& x,
+                    const MatrixDiagonal<T>* preconditioner = nullptr, const Params& params = Params()) {
+        const auto start = Clock::now();
+        Report report;
+        const double normB = prepare(A, b, x, preconditioner);
+        T* xd = x.data_ptr();
+        T* r = _r.data_ptr();
+        T* rhat = _rhat.data_ptr();
+        T* p = _p.data_ptr();
+        T* v = _q.data_ptr();
+        T* y = _y.data_ptr();
+        T* z = _z.data_ptr();
+        const T* t = _t.data_ptr();
+        const T* m = _inverseDiagonal.data();
+        if (normB == 0) {
+            std::fill(xd, xd + _n, T(0));
+            report.converged = true;
+            report.totalMs = elapsedMs(start);
+            return report;
+        }
+
+        double rr = sweep<1>(_n, [&](size_t begin, size_t end) {
+            double sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                rhat[i] = r[i];
+                p[i] = 0;
+                v[i] = 0;
+                sum += double(r[i]) * r[i];
+            }
+            return std::array<double, 1>{sum};
+        })[0];
+        double rho = rr, rhoPrevious = 1, alpha = 1, omega = 1;
+
+        while (report.iterations < params.maxIterations && std::sqrt(rr) / normB > params.tolerance) {
+            if (rho == 0 || omega == 0) break; // вырождение метода
+            const T beta = T((rho / rhoPrevious) * (alpha / omega));
+            const T w = T(omega);
+            sweep<0>(_n, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    p[i] = r[i] + beta * (p[i] - w * v[i]);
+                    y[i] = m[i] * p[i];
+                }
+                return std::array<double, 0>{};
+            });
+            matrix_vector::gemv(A, _y, _q);
+            const double rv = sweep<1>(_n, [&](size_t begin, size_t end) {
+                double sum = 0;
+                for (size_t i = begin; i < end; ++i) sum += double(rhat[i]) * v[i];
+                return std::array<double, 1>{sum};
+            })[0];
+            if (rv == 0) break;
+            alpha = rho / rv;
+            const T a = T(alpha);
+
+            // s = r - a v записывается на место r
+            const double ss = sweep<1>(_n, [&](size_t begin, size_t end) {
+                double sum = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    r[i] -= a * v[i];
+                    z[i] = m[i] * r[i];
+                    sum += double(r[i]) * r[i];
+                }
+                return std::array<double, 1>{sum};
+            })[0];
+            ++report.iterations;
+            // Половинный шаг x += a y: невязка после него - s
+            auto halfStep = [&]() {
+                sweep<0>(_n, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) xd[i] += a * y[i];
+                    return std::array<double, 0>{};
+                });
+                rr = ss;
+            };
+            if (std::sqrt(ss) / normB <= params.tolerance) {
+                halfStep();
+                break;
+            }
+
+            matrix_vector::gemv(A, _z, _t);
+            auto tsums = sweep<2>(_n, [&](size_t begin, size_t end) {
+                double ts = 0, tt = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    ts += double(t[i]) * r[i];
+                    tt += double(t[i]) * t[i];
+                }
+                return std::array<double, 2>{ts, tt};
+            });
+            if (tsums[1] == 0) {
+                halfStep();
+                break;
+            }
+            omega = tsums[0] / tsums[1];
+            const T o = T(omega);
+
+            auto sums = sweep<2>(_n, [&](size_t begin, size_t end) {
+                double rhoNew = 0, rrNew = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    xd[i] += a * y[i] + o * z[i];
+                    r[i] -= o * t[i];
+                    rhoNew += double(rhat[i]) * r[i];
+                    rrNew += double(r[i]) * r[i];
+                }
+                return std::array<double, 2>{rhoNew, rrNew};
+            });
+            rhoPrevious = rho;
+            rho = sums[0];
+            rr = sums[1];
+        }
+        finish(report, rr, normB, start, params.tolerance);
+        return report;
+    }
+};
+
+} // namespace iterative
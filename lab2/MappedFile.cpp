@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Отображение файла в память. Страницы открываются в режиме копирования при записи:
+// данные можно менять в памяти, а файл на диске остаётся нетронутым.
+class MappedFile {
+private:
+    char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+        _file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        LARGE_INTEGER size;
+        GetFileSizeEx(_file, &size);
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0) {
+            CloseHandle(_file);
+            throw std::runtime_error("File is empty: " + filename);
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (_mapping != nullptr) {
+            _data = static_cast<char*>(MapViewOfFile(_mapping, FILE_MAP_COPY, 0, 0, 0));
+        }
+        if (_data == nullptr) {
+            if (_mapping != nullptr) CloseHandle(_mapping);
+            CloseHandle(_file);
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("File is empty: " + filename);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        void* ptr = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd); // отображение остаётся действительным и без дескриптора
+        if (ptr == MAP_FAILED) {
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+        _data = static_cast<char*>(ptr);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+#else
+        munmap(_data, _size);
+#endif
+    }
+
+    char* data() const { return _data; }
+    size_t size() const { return _size; }
+};
@@ -0,0 +1,412 @@
+#pragma once
+
+#include "Matrix.h"
+#include "ThreadPool.cpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Ленточная матрица n x n: ненулевые элементы только на диагоналях со смещением j - i
+// от -lower до upper. Каждая диагональ хранится отдельным непрерывным массивом длины n,
+// проиндексированным номером строки (элементы вне матрицы - нули), поэтому матвектор и
+// произведения лент - это короткие векторизуемые проходы по массивам. При lower = upper = 1
+// (трёхдиагональная матрица) матвектор идёт одним слитым проходом, а система решается
+// прогонкой (алгоритм Томаса) или параллельной циклической редукцией.
+template <typename T = double>
+class MatrixBanded : public Matrix<T> {
+private:
+    unsigned _size;
+    unsigned _lower;        // число поддиагоналей
+    unsigned _upper;        // число наддиагоналей
+    std::vector<T> _data;   // диагональ со смещением d начинается с (d + _lower) * _size
+
+    // Строк на одну задачу пула в произведениях и циклической редукции
+    static const size_t ROWS_PER_TASK = 1 << 14;
+
+    template <typename Func>
+    static void forRows(size_t n, Func f) {
+        const size_t tasks = (n + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+        if (tasks <= 1) {
+            f(size_t(0), n);
+            return;
+        }
+        ThreadPool::global().parallelFor(tasks, [&](size_t t) {
+            f(t * ROWS_PER_TASK, std::min(n, (t + 1) * ROWS_PER_TASK));
+        });
+    }
+
+    // Строки i, в которых диагональ d лежит внутри матрицы
+    static size_t firstRow(size_t n, long d) { return d < 0 ? std::min<size_t>(n, size_t(-d)) : 0; }
+    static size_t lastRow(size_t n, long d) { return d > 0 ? n - std::min<size_t>(n, size_t(d)) : n; }
+
+    const MatrixBanded& castOther(const Matrix<T>& other, const char* message) const {
+        const MatrixBanded* otherBanded = dynamic_cast<const MatrixBanded*>(&other);
+        if (!otherBanded) {
+            throw std::invalid_argument(message);
+        }
+        if (_size != otherBanded->_size) {
+            throw std::invalid_argument("Matrix dimensions must be equal.");
+        }
+        return *otherBanded;
+    }
+
+    // Сумма или разность лент; лента результата - объединение лент слагаемых
+    MatrixBanded* combine(const MatrixBanded& other, T sign) const {
+        MatrixBanded* result = new MatrixBanded(_size, std::max(_lower, other._lower), std::max(_upper, other._upper));
+        for (long d = -long(_lower); d <= long(_upper); ++d) {
+            std::copy(diagonal(d), diagonal(d) + _size, result->diagonal(d));
+        }
+        for (long d = -long(other._lower); d <= long(other._upper); ++d) {
+            const T* source = other.diagonal(d);
+            T* target = result->diagonal(d);
+            for (size_t i = 0; i < _size; ++i) target[i] += sign * source[i];
+        }
+        return result;
+    }
+
+    void checkTridiagonal() const {
+        if (_lower > 1 || _upper > 1) {
+            throw std::invalid_argument("Matrix is not tridiagonal.");
+        }
+    }
+
+    // Один уровень циклической редукции: система A x = d из m уравнений (a - под главной,
+    // b - главная, c - над главной; a[0] и c[m - 1] не читаются), d заменяется решением
+    static void reduceLevel(const T* a, const T* b, const T* c, T* d, size_t m, size_t nrhs, std::atomic<bool>& singular) {
+        if (m == 1) {
+            if (b[0] == T(0)) {
+                singular = true;
+                return;
+            }
+            for (size_t k = 0; k < nrhs; ++k) d[k] /= b[0];
+            return;
+        }
+        // уравнение j системы вдвое меньше - бывшее уравнение i = 2j + 1
+        const size_t half = m / 2;
+        std::vector<T> a2(half), b2(half), c2(half), d2(half * nrhs);
+        forRows(half, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                const size_t i = 2 * j + 1;
+                const bool hasNext = i + 1 < m;
+                if (b[i - 1] == T(0) || (hasNext && b[i + 1] == T(0))) {
+                    singular = true;
+                    continue;
+                }
+                const T k1 = a[i] / b[i - 1];
+                const T k2 = hasNext ? c[i] / b[i + 1] : T(0);
+                a2[j] = i > 1 ? -a[i - 1] * k1 : T(0);
+                c2[j] = i + 2 < m ? -c[i + 1] * k2 : T(0);
+                b2[j] = b[i] - c[i - 1] * k1 - (hasNext ? a[i + 1] * k2 : T(0));
+                const T* previous = d + (i - 1) * nrhs;
+                const T* row = previous + nrhs;
+                T* out = d2.data() + j * nrhs;
+                for (size_t k = 0; k < nrhs; ++k) out[k] = row[k] - k1 * previous[k];
+                if (hasNext) {
+                    const T* next = row + nrhs;
+                    for (size_t k = 0; k < nrhs; ++k) out[k] -= k2 * next[k];
+                }
+            }
+        });
+        if (singular) {
+            return;
+        }
+        reduceLevel(a2.data(), b2.data(), c2.data(), d2.data(), half, nrhs, singular);
+        if (singular) {
+            return;
+        }
+        // чётное уравнение i = 2j выражает x_i через найденные x_{i-1} = d2[j - 1] и x_{i+1} = d2[j]
+        forRows((m + 1) / 2, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                const size_t i = 2 * j;
+                if (b[i] == T(0)) {
+                    singular = true;
+                    continue;
+                }
+                T* row = d + i * nrhs;
+                if (i > 0) {
+                    const T* previous = d2.data() + (j - 1) * nrhs;
+                    for (size_t k = 0; k < nrhs; ++k) row[k] -= a[i] * previous[k];
+                }
+                if (i + 1 < m) {
+                    const T* next = d2.data() + j * nrhs;
+                    for (size_t k = 0; k < nrhs; ++k) row[k + nrhs] = next[k];
+                    for (size_t k = 0; k < nrhs; ++k) row[k] -= c[i] * next[k];
+                }
+                for (size_t k = 0; k < nrhs; ++k) row[k] /= b[i];
+            }
+        });
+    }
+
+public:
+    MatrixBanded(unsigned size, unsigned lower, unsigned upper)
+        : _size(size), _lower(lower), _upper(upper) {
+        if (size == 0) {
+            throw std::invalid_argument("Matrix size must be positive.");
+        }
+        if (lower >= size || upper >= size) {
+            throw std::invalid_argument("Bandwidth must be less than matrix size.");
+        }
+        _data.assign(size_t(lower + upper + 1) * size, T(0));
+    }
+
+    // Трёхдиагональная матрица
+    explicit MatrixBanded(unsigned size) : MatrixBanded(size, size > 1 ? 1 : 0, size > 1 ? 1 : 0) {}
+
+    T& operator()(unsigned i, unsigned j) override {
+        if (i >= _size || j >= _size) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        const long d = long(j) - long(i);
+        if (d < -long(_lower) || d > long(_upper)) {
+            static T zero = 0;
+            return zero;
+        }
+        return diagonal(d)[i];
+    }
+
+    const T& operator()(unsigned i, unsigned j) const override {
+        if (i >= _size || j >= _size) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        const long d = long(j) - long(i);
+        if (d < -long(_lower) || d > long(_upper)) {
+            static const T zero = 0;
+            return zero;
+        }
+        return diagonal(d)[i];
+    }
+
+    unsigned getSize() const { return _size; }
+    unsigned getRows() const { return _size; }
+    unsigned getCols() const { return _size; }
+    unsigned getLower() const { return _lower; }
+    unsigned getUpper() const { return _upper; }
+    bool isTridiagonal() const { return _lower <= 1 && _upper <= 1; }
+
+    // Диагональ со смещением d = j - i, элемент строки i - diagonal(d)[i]
+    T* diagonal(long d) {
+        return _data.data() + size_t(d + long(_lower)) * _size;
+    }
+
+    const T* diagonal(long d) const {
+        return _data.data() + size_t(d + long(_lower)) * _size;
+    }
+
+    Matrix<T>* operator+(const Matrix<T>& other) const override {
+        return combine(castOther(other, "Incompatible matrix types for addition."), T(1));
+    }
+
+    Matrix<T>* operator-(const Matrix<T>& other) const override {
+        return combine(castOther(other, "Incompatible matrix types for substraction."), T(-1));
+    }
+
+    // Лента произведения - сумма лент: C_{d1+d2}[i] += A_{d1}[i] * B_{d2}[i + d1].
+    // Потоки делят строки, каждая пара диагоналей - один непрерывный проход
+    Matrix<T>* operator*(const Matrix<T>& other) const override {
+        const MatrixBanded& b = castOther(other, "Incompatible matrix types for multiplication.");
+        const unsigned lower = std::min(_size - 1, _lower + b._lower);
+        const unsigned upper = std::min(_size - 1, _upper + b._upper);
+        MatrixBanded* result = new MatrixBanded(_size, lower, upper);
+        const size_t n = _size;
+        forRows(n, [&](size_t begin, size_t end) {
+            for (long d1 = -long(_lower); d1 <= long(_upper); ++d1) {
+                const T* a = diagonal(d1);
+                for (long d2 = -long(b._lower); d2 <= long(b._upper); ++d2) {
+                    const long d = d1 + d2;
+                    if (d < -long(lower) || d > long(upper)) continue;
+                    const size_t from = std::max({begin, firstRow(n, d1), firstRow(n, d)});
+                    const size_t to = std::min({end, lastRow(n, d1), lastRow(n, d)});
+                    const T* bd = b.diagonal(d2);
+                    T* c = result->diagonal(d);
+                    for (size_t i = from; i < to; ++i) c[i] += a[i] * bd[i + d1];
+                }
+            }
+        });
+        return result;
+    }
+
+    Matrix<T>* elementWiseMultiplication(const Matrix<T>& other) const override {
+        const MatrixBanded& b = castOther(other, "Incompatible matrix types for element-wise multiplication.");
+        MatrixBanded* result = new MatrixBanded(_size, std::min(_lower, b._lower), std::min(_upper, b._upper));
+        for (long d = -long(result->_lower); d <= long(result->_upper); ++d) {
+            const T* x = diagonal(d);
+            const T* y = b.diagonal(d);
+            T* target = result->diagonal(d);
+            for (size_t i = 0; i < _size; ++i) target[i] = x[i] * y[i];
+        }
+        return result;
+    }
+
+    // Диагональ d переходит в -d со сдвигом: A^T_{-d}[i + d] = A_d[i]
+    Matrix<T>* transpose() const override {
+        MatrixBanded* result = new MatrixBanded(_size, _upper, _lower);
+        for (long d = -long(_lower); d <= long(_upper); ++d) {
+            const T* source = diagonal(d);
+            T* target = result->diagonal(-d);
+            for (size_t i = firstRow(_size, d); i < lastRow(_size, d); ++i) target[i + d] = source[i];
+        }
+        return result;
+    }
+
+    // y = alpha * A * x + beta * y для строк [begin, end); при beta == 0 y не читается
+    void multiplyRows(const T* x, T* y, size_t begin, size_t end, T alpha, T beta) const {
+        const size_t n = _size;
+        if (_lower == 1 && _upper == 1) {
+            // Трёхдиагональная: один проход, граничные строки отдельно
+            const T* a = diagonal(-1);
+            const T* b = diagonal(0);
+            const T* c = diagonal(1);
+            auto row = [&](size_t i) {
+                T sum = b[i] * x[i];
+                if (i > 0) sum += a[i] * x[i - 1];
+                if (i + 1 < n) sum += c[i] * x[i + 1];
+                return sum;
+            };
+            const size_t from = std::max<size_t>(begin, 1), to = std::min(end, n - 1);
+            if (begin < from) y[begin] = alpha * row(begin) + (beta == T(0) ? T(0) : beta * y[begin]);
+            for (size_t i = from; i < to; ++i) {
+                const T sum = alpha * (a[i] * x[i - 1] + b[i] * x[i] + c[i] * x[i + 1]);
+                y[i] = beta == T(0) ? sum : sum + beta * y[i];
+            }
+            if (to < end && to >= from) y[to] = alpha * row(to) + (beta == T(0) ? T(0) : beta * y[to]);
+            return;
+        }
+        if (beta == T(0)) {
+            std::fill(y + begin, y + end, T(0));
+        } else if (beta != T(1)) {
+            for (size_t i = begin; i < end; ++i) y[i] *= beta;
+        }
+        for (long d = -long(_lower); d <= long(_upper); ++d) {
+            const T* a = diagonal(d);
+            const size_t from = std::max(begin, firstRow(n, d)), to = std::min(end, lastRow(n, d));
+            for (size_t i = from; i < to; ++i) y[i] += alpha * a[i] * x[i + d];
+        }
+    }
+
+    // y = alpha * A^T * x + beta * y для элементов y [begin, end): A^T_{-d}[j] = A_d[j - d]
+    void multiplyRowsTransposed(const T* x, T* y, size_t begin, size_t end, T alpha, T beta) const {
+        const size_t n = _size;
+        if (beta == T(0)) {
+            std::fill(y + begin, y + end, T(0));
+        } else if (beta != T(1)) {
+            for (size_t j = begin; j < end; ++j) y[j] *= beta;
+        }
+        for (long d = -long(_lower); d <= long(_upper); ++d) {
+            const T* a = diagonal(d);
+            const size_t from = std::max(begin, firstRow(n, -d)), to = std::min(end, lastRow(n, -d));
+            for (size_t j = from; j < to; ++j) y[j] += alpha * a[j - d] * x[j - d];
+        }
+    }
+
+    // Прогонка (алгоритм Томаса) для трёхдиагональной A за O(n): B - n x nrhs по строкам,
+    // заменяется решением. Без выбора ведущего элемента - устойчива для матриц с
+    // диагональным преобладанием и симметричных положительно определённых.
+    void thomasSolveInPlace(T* b, size_t nrhs) const {
+        checkTridiagonal();
+        const size_t n = _size;
+        const T* main = diagonal(0);
+        const T* sub = _lower == 1 ? diagonal(-1) : nullptr;
+        const T* super = _upper == 1 ? diagonal(1) : nullptr;
+        std::vector<T> c(n);
+        T pivot = main[0];
+        for (size_t i = 0;; ++i) {
+            if (pivot == T(0)) {
+                throw std::runtime_error("Matrix is singular.");
+            }
+            c[i] = super != nullptr && i + 1 < n ? super[i] / pivot : T(0);
+            T* row = b + i * nrhs;
+            for (size_t k = 0; k < nrhs; ++k) row[k] /= pivot;
+            if (i + 1 == n) break;
+            const T l = sub != nullptr ? sub[i + 1] : T(0);
+            T* next = row + nrhs;
+            for (size_t k = 0; k < nrhs; ++k) next[k] -= l * row[k];
+            pivot = main[i + 1] - l * c[i];
+        }
+        for (size_t i = n - 1; i-- > 0;) {
+            T* row = b + i * nrhs;
+            const T* next = row + nrhs;
+            for (size_t k = 0; k < nrhs; ++k) row[k] -= c[i] * next[k];
+        }
+    }
+
+    // Циклическая редукция (чёт-нечёт) для трёхдиагональной A: уравнения с нечётными
+    // номерами исключают соседей и образуют систему вдвое меньше, и так до одного
+    // уравнения; затем обратным ходом по уровням находятся чётные неизвестные. Работа O(n)
+    // (около 2.5 прогонок по числу операций), временная память - уровни размером n/2,
+    // n/4, ... Уравнения одного уровня независимы и считаются параллельно. Та же оговорка
+    // об устойчивости, что и у прогонки.
+    void cyclicReductionSolveInPlace(T* rhs, size_t nrhs) const {
+        checkTridiagonal();
+        const size_t n = _size;
+        std::vector<T> zeros(_lower == 1 && _upper == 1 ? 0 : n, T(0));
+        const T* sub = _lower == 1 ? diagonal(-1) : zeros.data();
+        const T* super = _upper == 1 ? diagonal(1) : zeros.data();
+        // Задачи пула не бросают исключений: нулевой ведущий элемент отмечается флагом
+        std::atomic<bool> singular{false};
+        reduceLevel(sub, diagonal(0), super, rhs, n, nrhs, singular);
+        if (singular) {
+            throw std::runtime_error("Matrix is singular.");
+        }
+    }
+
+    // Формат: тип, размер и ширины ленты, затем диагонали от нижней к верхней,
+    // каждая - n чисел (элементы вне матрицы записываются нулями)
+    void importFromFile(const std::string& filename) override {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+
+        std::string matrixType;
+        file >> matrixType;
+        if (matrixType != "MatrixBanded") {
+            throw std::runtime_error("Invalid matrix type in file: " + filename);
+        }
+
+        unsigned size, lower, upper;
+        file >> size >> lower >> upper;
+        if (file.fail() || size == 0 || lower >= size || upper >= size) {
+            throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
+        }
+        std::vector<T> data(size_t(lower + upper + 1) * size);
+        for (T& value : data) {
+            if (!(file >> value)) {
+                throw std::runtime_error("Error reading matrix data from file: " + filename);
+            }
+        }
+        _size = size;
+        _lower = lower;
+        _upper = upper;
+        _data.swap(data);
+    }
+
+    void exportToFile(const std::string& filename) const override {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+
+        file << "MatrixBanded\n";
+        file << _size << " " << _lower << " " << _upper << "\n";
+        for (long d = -long(_lower); d <= long(_upper); ++d) {
+            const T* values = diagonal(d);
+            for (unsigned i = 0; i < _size; ++i) {
+                file << values[i] << " ";
+            }
+            file << "\n";
+        }
+    }
+
+    void print() const override {
+        for (unsigned i = 0; i < _size; ++i) {
+            for (unsigned j = 0; j < _size; ++j) {
+                std::cout << std::setw(10) << (*this)(i, j) << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "MappedFile.cpp"
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+// Бинарный контейнер матриц (версия 1):
+//   [заголовок 64 байта]
+//   [таблица смещений блоков, только для MatrixBlock: uint64 на блок, 0 - нулевой блок]
+//   [данные с выравниванием на 64 байта; у MatrixBlock каждый блок выровнен отдельно]
+// Числа хранятся в порядке байт машины; метка endianMark позволяет обнаружить чужой порядок.
+
+enum class MatrixFileType : uint32_t {
+    Dense = 1,
+    Diagonal = 2,
+    Block = 3
+};
+
+// Код типа элемента; для неподдерживаемых типов специализации нет - ошибка компиляции
+template <typename T> struct MatrixDType;
+template <> struct MatrixDType<float>   { static const uint32_t code = 1; };
+template <> struct MatrixDType<double>  { static const uint32_t code = 2; };
+template <> struct MatrixDType<int8_t>  { static const uint32_t code = 3; };
+template <> struct MatrixDType<int16_t> { static const uint32_t code = 4; };
+template <> struct MatrixDType<int32_t> { static const uint32_t code = 5; };
+template <> struct MatrixDType<int64_t> { static const uint32_t code = 6; };
+
+struct MatrixFileHeader {
+    char magic[8];        // "MATRXBIN"
+    uint32_t version;
+    uint32_t typeTag;     // MatrixFileType
+    uint32_t dtype;       // MatrixDType<T>::code
+    uint32_t elemSize;
+    uint64_t rows;
+    uint64_t cols;
+    uint32_t blockRows;   // для Dense/Diagonal - 0
+    uint32_t blockCols;
+    uint32_t blockSize;
+    uint32_t endianMark;
+    uint64_t dataOffset;  // начало данных (кратно 64)
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "MatrixFileHeader must be 64 bytes");
+
+namespace matrix_binary {
+
+const uint32_t VERSION = 1;
+const uint32_t ENDIAN_MARK = 0x01020304;
+const uint64_t ALIGNMENT = 64;
+const char MAGIC[8] = {'M', 'A', 'T', 'R', 'X', 'B', 'I', 'N'};
+
+inline uint64_t alignUp(uint64_t value) {
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+template <typename T>
+MatrixFileHeader makeHeader(MatrixFileType type, uint64_t rows, uint64_t cols) {
+    MatrixFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.typeTag = static_cast<uint32_t>(type);
+    header.dtype = MatrixDType<T>::code;
+    header.elemSize = sizeof(T);
+    header.rows = rows;
+    header.cols = cols;
+    header.endianMark = ENDIAN_MARK;
+    header.dataOffset = alignUp(sizeof(MatrixFileHeader));
+    return header;
+}
+
+// Дописывает нули до позиции target
+inline void padTo(std::ostream& file, uint64_t position, uint64_t target) {
+    static const char zeros[ALIGNMENT] = {};
+    if (target > position) {
+        file.write(zeros, static_cast<std::streamsize>(target - position));
+    }
+}
+
+// Проверка заголовка файла размером fileSize байт
+template <typename T>
+void checkHeader(const MatrixFileHeader& header, uint64_t fileSize, MatrixFileType type, const std::string& filename) {
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a binary matrix file: " + filename);
+    }
+    if (header.endianMark != ENDIAN_MARK) {
+        throw std::runtime_error("Byte order mismatch in file: " + filename);
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error("Unsupported binary matrix version in file: " + filename);
+    }
+    if (header.typeTag != static_cast<uint32_t>(type)) {
+        throw std::runtime_error("Invalid matrix type in file: " + filename);
+    }
+    if (header.dtype != MatrixDType<T>::code || header.elemSize != sizeof(T)) {
+        throw std::runtime_error("Element type mismatch in file: " + filename);
+    }
+    // размеры матриц - unsigned, большие значения при приведении молча обрезались бы
+    if (header.rows == 0 || header.cols == 0 || header.rows > UINT_MAX || header.cols > UINT_MAX
+        || header.dataOffset % ALIGNMENT != 0 || header.dataOffset > fileSize) {
+        throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
+    }
+}
+
+// Помещаются ли count элементов по size байт, начиная с offset, в fileSize байт.
+// Без переполнения: испорченный заголовок не должен пройти проверку за счёт переноса
+inline bool fitsInFile(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && (size == 0 || count <= (fileSize - offset) / size);
+}
+
+// Проверка заголовка отображённого файла
+template <typename T>
+const MatrixFileHeader& readHeader(const MappedFile& mapped, MatrixFileType type, const std::string& filename) {
+    if (mapped.size() < sizeof(MatrixFileHeader)) {
+        throw std::runtime_error("File is too small for binary matrix: " + filename);
+    }
+    const MatrixFileHeader& header = *reinterpret_cast<const MatrixFileHeader*>(mapped.data());
+    checkHeader<T>(header, mapped.size(), type, filename);
+    return header;
+}
+
+} // namespace matrix_binary
@@ -1,75 +1,363 @@
+#pragma once
+
 #include "Matrix.h"
 #include "MatrixDense.cpp"
+#include "MatrixTextIO.cpp"
+#include "BlockArena.cpp"
+#include "ThreadPool.cpp"
+#include "TaskGraph.cpp"
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 #include <iomanip>
 #include <map>
+#include <memory>
+#include <algorithm>
+
 
+// BlockSize = 0: размер блока задаётся при создании, тайлы - MatrixDense в общей арене.
+// BlockSize > 0: размер известен при компиляции, тайлы MatrixFixed лежат прямо в матрице
+// (определение - в MatrixBlockFixed.cpp).
+template <typename T = double, unsigned BlockSize = 0>
+class MatrixBlock;
 
-template <typename T = double>
-class MatrixBlock : public Matrix<T> {
+template <typename T>
+class MatrixBlock<T, 0> : public Matrix<T> {
 private:
+    using BlockPtr = std::shared_ptr<MatrixDense<T>>;
+
     unsigned _blockRows;    // Количество блоков по строкам
     unsigned _blockCols;    // Количество блоков по столбцам
     unsigned _blockSize;   // Размер блока (предполагаем квадратные блоки)
-    std::vector<MatrixDense<T>*> _blocks;
+    // Блоки - значения со счётчиком ссылок: копия матрицы и повторяющиеся блоки
+    // разделяют один тайл, а изменение через operator() сначала делает копию (copy-on-write)
+    std::vector<BlockPtr> _blocks;
+    std::shared_ptr<BlockArena<T>> _arena; // общее хранилище тайлов, разделяется с копиями
+
+    // Новый нулевой блок в арене; тайл возвращается в арену вместе с последней ссылкой
+    BlockPtr newTile() {
+        const size_t tileElems = size_t(_blockSize) * _blockSize;
+        if (!_arena || _arena->tileElems() != tileElems) {
+            _arena = std::make_shared<BlockArena<T>>(tileElems);
+        }
+        std::shared_ptr<BlockArena<T>> arena = _arena;
+        T* tile = arena->allocate();
+        std::shared_ptr<void> storage(tile, [arena](void* p) { arena->release(static_cast<T*>(p)); });
+        return std::make_shared<MatrixDense<T>>(_blockSize, _blockSize, tile, storage);
+    }
 
-public:
-    MatrixBlock(unsigned blockRows, unsigned blockCols, unsigned blockSize)
-        : _blockRows(blockRows), _blockCols(blockCols), _blockSize(blockSize) {
-            _blocks.resize(blockRows*blockCols, nullptr);
+    // Блок для записи: если тайл разделён с кем-то ещё, он сначала копируется
+    MatrixDense<T>* mutableBlock(size_t index) {
+        BlockPtr& block = _blocks[index];
+        if (block && block.use_count() > 1) {
+            BlockPtr copy = newTile();
+            std::copy(block->getData(), block->getData() + size_t(_blockSize) * _blockSize, copy->getData());
+            block = copy;
         }
-    MatrixBlock(const MatrixBlock& other) : _blockRows(other._blockRows), _blockCols(other._blockCols), _blockSize(other._blockSize){
-        _blocks.resize(_blockRows*_blockCols, nullptr);
-        std::map<MatrixDense<T>*, MatrixDense<T>*> block_map;
-        for(size_t i = 0; i < _blockRows * _blockCols; ++i){
-            if(other._blocks[i]!= nullptr)
-            {
-                if(block_map.find(other._blocks[i]) == block_map.end()){
-                    _blocks[i] = new MatrixDense<T>(*other._blocks[i]);
-                    block_map[other._blocks[i]] = _blocks[i];
-                }else{
-                    _blocks[i] = block_map[other._blocks[i]];
+        return block.get();
+    }
+
+    // c += a * b для квадратных блоков (последовательное блочное ядро: блок - одна задача пула)
+    static void multiplyAccumulate(const T* a, const T* b, T* c, size_t n) {
+        gemm_kernel::multiplySequential(a, n, b, n, c, n, n, n, n, true);
+    }
+
+    // c += a * b^T: панели b^T упаковываются ядром GEMM прямо из строк b
+    static void multiplyTransposedAccumulate(const T* a, const T* b, T* c, size_t n) {
+        gemm_kernel::multiplyTransposed(a, n, b, n, c, n, n, n, n, true, false);
+    }
+
+    // c -= a * b (или a * b^T): произведение во временный буфер потока и вычитание,
+    // так обновления разложений используют то же блочное ядро, что и умножение
+    static void subtractProduct(const T* a, const T* b, T* c, size_t n, bool bTransposed) {
+        thread_local std::vector<T> product, transposedB;
+        product.resize(n * n);
+        const T* right = b;
+        if (bTransposed) {
+            transposedB.resize(n * n);
+            transpose_kernel::transpose(b, transposedB.data(), n, n);
+            right = transposedB.data();
+        }
+        gemm_kernel::multiplySequential(a, n, right, n, product.data(), n, n, n, n, false);
+        for (size_t e = 0; e < n * n; ++e) c[e] -= product[e];
+    }
+
+    // Сумма sum = sum_k tile_k * x_k по ненулевым блокам строки (или столбца при transposedTiles)
+    // сетки разложения; x - правые части n x nrhs по строкам
+    void tileProductSum(size_t line, size_t first, size_t last, bool transposedTiles, const T* x, size_t nrhs,
+                        T* sum) const {
+        const size_t bs = _blockSize;
+        std::fill(sum, sum + bs * nrhs, T(0));
+        for (size_t k = first; k < last; ++k) {
+            const MatrixDense<T>* block = transposedTiles ? _blocks[k * _blockCols + line].get()
+                                                          : _blocks[line * _blockCols + k].get();
+            if (block == nullptr) continue;
+            const T* tile = block->getData();
+            const T* xk = x + k * bs * nrhs;
+            if (!transposedTiles) {
+                gemm_kernel::multiply(tile, bs, xk, nrhs, sum, nrhs, bs, nrhs, bs, true);
+            } else {
+                // tile^T * xk: строка q тайла умножается на строку q правых частей
+                for (size_t q = 0; q < bs; ++q) {
+                    for (size_t r = 0; r < bs; ++r) {
+                        const T coefficient = tile[q * bs + r];
+                        if (coefficient == T(0)) continue;
+                        for (size_t c = 0; c < nrhs; ++c) sum[r * nrhs + c] += coefficient * xk[q * nrhs + c];
+                    }
                 }
             }
         }
     }
-    MatrixBlock& operator=(const MatrixBlock& other){
-        if(this == &other) return *this;
-        for(size_t i = 0; i < _blockRows*_blockCols; ++i){
-            if(_blocks[i] != nullptr){
-                delete _blocks[i];
+
+    void checkFactorSolve(size_t pivotCount, bool withPivots) const {
+        if (_blockRows != _blockCols || (withPivots && pivotCount != size_t(_blockRows) * _blockSize)) {
+            throw std::invalid_argument("Factorization does not match the right-hand side.");
+        }
+    }
+
+    // Движок блочного умножения. По шаблону нулевых блоков для каждого блока результата
+    // строится список ненулевых произведений A_ik * B_kj (или A_ik * B_jk^T). Каждый
+    // непустой блок результата - отдельная задача пула, пишущая только в свой тайл,
+    // поэтому накопление идёт без блокировок. Блоки без вкладов остаются нулевыми.
+    MatrixBlock<T>* multiplyBlocks(const MatrixBlock<T>& other, bool otherTransposed) const {
+        const size_t resultCols = otherTransposed ? other._blockRows : other._blockCols;
+        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, static_cast<unsigned>(resultCols), _blockSize);
+
+        // Ненулевые блоки второго множителя по индексу k: (j, данные)
+        std::vector<std::vector<std::pair<size_t, const T*>>> otherByK(_blockCols);
+        for (size_t r = 0; r < other._blockRows; ++r) {
+            for (size_t c = 0; c < other._blockCols; ++c) {
+                const MatrixDense<T>* block = other._blocks[r * other._blockCols + c].get();
+                if (block == nullptr) continue;
+                if (otherTransposed) otherByK[c].push_back({r, block->getData()});
+                else otherByK[r].push_back({c, block->getData()});
             }
         }
-        _blocks.clear();
-        _blockRows = other._blockRows;
-        _blockCols = other._blockCols;
-        _blockSize = other._blockSize;
-        _blocks.resize(_blockRows*_blockCols);
-        std::map<MatrixDense<T>*, MatrixDense<T>*> block_map;
-        for(size_t i = 0; i < _blockRows * _blockCols; ++i){
-            if(other._blocks[i]!= nullptr)
-            {
-                if(block_map.find(other._blocks[i]) == block_map.end()){
-                    _blocks[i] = new MatrixDense<T>(*other._blocks[i]);
-                    block_map[other._blocks[i]] = _blocks[i];
-                }else{
-                    _blocks[i] = block_map[other._blocks[i]];
+
+        std::vector<std::vector<std::pair<const T*, const T*>>> work(_blockRows * resultCols);
+        for (size_t i = 0; i < _blockRows; ++i) {
+            for (size_t k = 0; k < _blockCols; ++k) {
+                const MatrixDense<T>* a = _blocks[i * _blockCols + k].get();
+                if (a == nullptr) continue;
+                for (const auto& entry : otherByK[k]) {
+                    work[i * resultCols + entry.first].push_back({a->getData(), entry.second});
                 }
             }
         }
 
+        // Тайлы выделяются заранее в одном слэбе; тяжёлые задачи идут первыми
+        std::vector<size_t> tasks;
+        for (size_t b = 0; b < work.size(); ++b) {
+            if (!work[b].empty()) tasks.push_back(b);
+        }
+        if (tasks.empty()) return result;
+        std::stable_sort(tasks.begin(), tasks.end(), [&work](size_t x, size_t y) { return work[x].size() > work[y].size(); });
+        result->_arena = std::make_shared<BlockArena<T>>(size_t(_blockSize) * _blockSize);
+        result->_arena->reserve(tasks.size());
+        for (size_t b : tasks) {
+            result->_blocks[b] = result->newTile();
+        }
+
+        const size_t n = _blockSize;
+        ThreadPool::global().parallelFor(tasks.size(), [&](size_t t) {
+            const size_t b = tasks[t];
+            T* c = result->_blocks[b]->getData();
+            for (const auto& pair : work[b]) {
+                if (otherTransposed) multiplyTransposedAccumulate(pair.first, pair.second, c, n);
+                else multiplyAccumulate(pair.first, pair.second, c, n);
+            }
+        });
+        return result;
+    }
+
+    // Подсетка blocks x blocks, начиная с блока (row, col); тайлы разделяются, а не копируются
+    MatrixBlock<T> subGrid(size_t row, size_t col, size_t blocks) const {
+        MatrixBlock<T> grid(static_cast<unsigned>(blocks), static_cast<unsigned>(blocks), _blockSize);
+        grid._arena = _arena;
+        for (size_t i = 0; i < blocks; ++i) {
+            for (size_t j = 0; j < blocks; ++j) {
+                if (row + i < _blockRows && col + j < _blockCols) {
+                    grid._blocks[i * blocks + j] = _blocks[(row + i) * _blockCols + col + j];
+                }
+            }
+        }
+        return grid;
+    }
+
+    // Копирует блоки grid в позицию (row, col) этой сетки; выходящие за край отбрасываются
+    void placeGrid(const MatrixBlock<T>& grid, size_t row, size_t col) {
+        for (size_t i = 0; i < grid._blockRows && row + i < _blockRows; ++i) {
+            for (size_t j = 0; j < grid._blockCols && col + j < _blockCols; ++j) {
+                _blocks[(row + i) * _blockCols + col + j] = grid._blocks[i * grid._blockCols + j];
+            }
+        }
+    }
+
+    // a + sign * b с учётом нулевых блоков: нулевой блок не хранится и не вычисляется,
+    // а ненулевой блок, к которому прибавляется ноль, разделяется без копирования
+    static MatrixBlock<T> addGrids(const MatrixBlock<T>& a, const MatrixBlock<T>& b, T sign) {
+        MatrixBlock<T> c(a._blockRows, a._blockCols, a._blockSize);
+        const size_t tileElems = size_t(a._blockSize) * a._blockSize;
+        for (size_t i = 0; i < c._blocks.size(); ++i) {
+            const BlockPtr& x = a._blocks[i];
+            const BlockPtr& y = b._blocks[i];
+            if (!y) {
+                c._blocks[i] = x;
+            } else if (!x && sign == T(1)) {
+                c._blocks[i] = y;
+            } else {
+                BlockPtr tile = c.newTile();
+                T* z = tile->getData();
+                const T* yd = y->getData();
+                if (x) {
+                    const T* xd = x->getData();
+                    for (size_t e = 0; e < tileElems; ++e) z[e] = xd[e] + sign * yd[e];
+                } else {
+                    for (size_t e = 0; e < tileElems; ++e) z[e] = sign * yd[e];
+                }
+                c._blocks[i] = tile;
+            }
+        }
+        return c;
+    }
+
+    // Штрассен-Виноград над сеткой блоков: квадранты - подсетки, листья - движок multiplyBlocks.
+    // Нулевые блоки проходят через сложения без вычислений, поэтому разреженность сохраняется.
+    static MatrixBlock<T> strassenGrids(const MatrixBlock<T>& A, const MatrixBlock<T>& B, size_t parallelDepth) {
+        const size_t g = A._blockRows;
+        if (g <= strassen::params().blockCrossover || g % 2 != 0) {
+            std::unique_ptr<MatrixBlock<T>> product(A.multiplyBlocks(B, false));
+            return *product;
+        }
+        const size_t h = g / 2;
+        const T one = T(1);
+        MatrixBlock<T> A11 = A.subGrid(0, 0, h), A12 = A.subGrid(0, h, h), A21 = A.subGrid(h, 0, h), A22 = A.subGrid(h, h, h);
+        MatrixBlock<T> B11 = B.subGrid(0, 0, h), B12 = B.subGrid(0, h, h), B21 = B.subGrid(h, 0, h), B22 = B.subGrid(h, h, h);
+
+        MatrixBlock<T> S1 = addGrids(A21, A22, one);
+        MatrixBlock<T> S2 = addGrids(S1, A11, -one);
+        MatrixBlock<T> S3 = addGrids(A11, A21, -one);
+        MatrixBlock<T> S4 = addGrids(A12, S2, -one);
+        MatrixBlock<T> T1 = addGrids(B12, B11, -one);
+        MatrixBlock<T> T2 = addGrids(B22, T1, -one);
+        MatrixBlock<T> T3 = addGrids(B22, B12, -one);
+        MatrixBlock<T> T4 = addGrids(T2, B21, -one);
+
+        const MatrixBlock<T>* left[7] = {&A11, &A12, &S4, &A22, &S1, &S2, &S3};
+        const MatrixBlock<T>* right[7] = {&B11, &B21, &B22, &T4, &T1, &T2, &T3};
+        std::vector<MatrixBlock<T>> P(7, MatrixBlock<T>(static_cast<unsigned>(h), static_cast<unsigned>(h), A._blockSize));
+        auto compute = [&](size_t i) {
+            P[i] = strassenGrids(*left[i], *right[i], parallelDepth > 0 ? parallelDepth - 1 : 0);
+        };
+        if (parallelDepth > 0) {
+            ThreadPool::global().parallelFor(7, compute);
+        } else {
+            for (size_t i = 0; i < 7; ++i) compute(i);
+        }
+
+        MatrixBlock<T> U2 = addGrids(P[0], P[5], one);
+        MatrixBlock<T> U3 = addGrids(U2, P[6], one);
+        MatrixBlock<T> U4 = addGrids(U2, P[4], one);
+        MatrixBlock<T> C(static_cast<unsigned>(g), static_cast<unsigned>(g), A._blockSize);
+        C.placeGrid(addGrids(P[0], P[1], one), 0, 0);
+        C.placeGrid(addGrids(U4, P[2], one), 0, h);
+        C.placeGrid(addGrids(U3, P[3], -one), h, 0);
+        C.placeGrid(addGrids(U3, P[4], one), h, h);
+        return C;
+    }
+
+    // Поэлементная операция над блоками прямо в тайлы результата. keepUnion (сложение,
+    // вычитание): блок есть хотя бы в одном операнде, одиночный блок левого операнда
+    // разделяется с результатом (op(x, 0) == x), правого - считается как op(0, y);
+    // иначе (поэлементное произведение) - только общие ненулевые блоки
+    template <typename Op>
+    MatrixBlock<T>* combineBlocks(const MatrixBlock<T>& other, bool keepUnion, Op op) const {
+        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
+        const size_t tileElems = size_t(_blockSize) * _blockSize;
+        for (size_t b = 0; b < _blocks.size(); ++b) {
+            const BlockPtr& x = _blocks[b];
+            const BlockPtr& y = other._blocks[b];
+            if (x && y) {
+                BlockPtr tile = result->newTile();
+                const T* xd = x->getData();
+                const T* yd = y->getData();
+                T* z = tile->getData();
+                for (size_t e = 0; e < tileElems; ++e) {
+                    z[e] = op(xd[e], yd[e]);
+                }
+                result->_blocks[b] = tile;
+            } else if (keepUnion && x) {
+                result->_blocks[b] = x;
+            } else if (keepUnion && y) {
+                BlockPtr tile = result->newTile();
+                const T* yd = y->getData();
+                T* z = tile->getData();
+                for (size_t e = 0; e < tileElems; ++e) {
+                    z[e] = op(T(0), yd[e]);
+                }
+                result->_blocks[b] = tile;
+            }
+        }
+        return result;
+    }
+
+public:
+    MatrixBlock(unsigned blockRows, unsigned blockCols, unsigned blockSize)
+        : _blockRows(blockRows), _blockCols(blockCols), _blockSize(blockSize) {
+            _blocks.resize(blockRows*blockCols, nullptr);
+        }
+
+    // Копия разделяет тайлы с оригиналом: O(число блоков), данные копируются только при записи
+    MatrixBlock(const MatrixBlock& other)
+        : _blockRows(other._blockRows), _blockCols(other._blockCols), _blockSize(other._blockSize),
+          _blocks(other._blocks), _arena(other._arena) {}
+
+    MatrixBlock& operator=(const MatrixBlock& other){
+        if(this == &other) return *this;
+        _blockRows = other._blockRows;
+        _blockCols = other._blockCols;
+        _blockSize = other._blockSize;
+        _blocks = other._blocks;
+        _arena = other._arena;
         return *this;
     }
 
-    ~MatrixBlock() override {
-        for (auto block : _blocks) {
-            if (block != nullptr) {
-                delete block;
+    ~MatrixBlock() override = default;
+
+    // Разбиение плотной матрицы на блоки blockSize x blockSize; 0 - размер из профиля
+    // автонастройки (tuning_profile). Края дополняются нулями, нулевые блоки не хранятся.
+    // Пустая матрица даёт 0 x 0 блоков размера 1.
+    static MatrixBlock* fromDense(const MatrixDense<T>& dense, unsigned blockSize = 0) {
+        const size_t m = dense.getRows(), n = dense.getCols();
+        if (blockSize == 0) {
+            blockSize = static_cast<unsigned>(std::max<size_t>(1, std::min(tuning_profile::current().blockSize, std::max(m, n))));
+        }
+        const unsigned blockRows = static_cast<unsigned>((m + blockSize - 1) / blockSize);
+        const unsigned blockCols = static_cast<unsigned>((n + blockSize - 1) / blockSize);
+        MatrixBlock* result = new MatrixBlock(blockRows, blockCols, blockSize);
+        const T* source = dense.getData();
+        for (unsigned bi = 0; bi < blockRows; ++bi) {
+            for (unsigned bj = 0; bj < blockCols; ++bj) {
+                const size_t rowBegin = size_t(bi) * blockSize, colBegin = size_t(bj) * blockSize;
+                const size_t rows = std::min<size_t>(blockSize, m - rowBegin);
+                const size_t cols = std::min<size_t>(blockSize, n - colBegin);
+                bool zero = true;
+                for (size_t r = 0; r < rows && zero; ++r) {
+                    const T* row = source + (rowBegin + r) * n + colBegin;
+                    zero = std::all_of(row, row + cols, [](const T& value) { return value == T(0); });
+                }
+                if (zero) continue;
+                BlockPtr tile = result->newTile();
+                for (size_t r = 0; r < rows; ++r) {
+                    const T* row = source + (rowBegin + r) * n + colBegin;
+                    std::copy(row, row + cols, tile->getData() + r * blockSize);
+                }
+                result->_blocks[size_t(bi) * blockCols + bj] = tile;
             }
         }
+        return result;
     }
 
     T& operator()(unsigned i, unsigned j) override {
@@ -85,7 +373,7 @@ public:
             static T zero = 0;
             return zero;
         }
-        return (*_blocks[blockRow * _blockCols + blockCol])(inBlockRow, inBlockCol);
+        return (*mutableBlock(blockRow * _blockCols + blockCol))(inBlockRow, inBlockCol);
     }
 
     const T& operator()(unsigned i, unsigned j) const override {
@@ -105,15 +393,36 @@ public:
         return (*_blocks[blockRow * _blockCols + blockCol])(inBlockRow, inBlockCol);
     }
 
+    // Забирает владение block: данные переносятся в тайл арены, сам объект удаляется
     void setBlock(unsigned blockRow, unsigned blockCol, MatrixDense<T>* block) {
         if (blockRow >= _blockRows || blockCol >= _blockCols || block->getRows() != _blockSize || block->getCols() != _blockSize) {
             throw std::invalid_argument("Invalid block dimensions or position.");
         }
-        if(_blocks[blockRow*_blockCols + blockCol]!= nullptr){
-            delete _blocks[blockRow*_blockCols + blockCol];
+        BlockPtr tile = newTile();
+        std::copy(block->getData(), block->getData() + size_t(_blockSize) * _blockSize, tile->getData());
+        delete block;
+        _blocks[blockRow * _blockCols + blockCol] = tile;
+    }
+
+    // Повторяющийся блок: позиция (dstRow, dstCol) ссылается на тот же тайл, что и (srcRow, srcCol)
+    void shareBlock(unsigned srcRow, unsigned srcCol, unsigned dstRow, unsigned dstCol) {
+        if (srcRow >= _blockRows || srcCol >= _blockCols || dstRow >= _blockRows || dstCol >= _blockCols) {
+            throw std::invalid_argument("Invalid block position.");
+        }
+        _blocks[dstRow * _blockCols + dstCol] = _blocks[srcRow * _blockCols + srcCol];
+    }
+
+    // nullptr для нулевого блока
+    const MatrixDense<T>* getBlock(unsigned blockRow, unsigned blockCol) const {
+        if (blockRow >= _blockRows || blockCol >= _blockCols) {
+            throw std::out_of_range("Block index out of bounds.");
         }
-        _blocks[blockRow * _blockCols + blockCol] = block;
+        return _blocks[blockRow * _blockCols + blockCol].get();
     }
+
+    unsigned getBlockRows() const { return _blockRows; }
+    unsigned getBlockCols() const { return _blockCols; }
+    unsigned getBlockSize() const { return _blockSize; }
     unsigned getRows() const { return _blockRows * _blockSize; }
     unsigned getCols() const { return _blockCols * _blockSize; }
 
@@ -127,17 +436,7 @@ public:
             throw std::invalid_argument("Matrix block dimensions must be equal for addition.");
         }
 
-        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
-
-        for (size_t i = 0; i < _blockRows; ++i) {
-            for (size_t j = 0; j < _blockCols; ++j) {
-                if (_blocks[i * _blockCols + j] != nullptr && otherBlock->_blocks[i * _blockCols + j] != nullptr) {
-                    result->setBlock(i, j, *(_blocks[i * _blockCols + j]->operator+(*(otherBlock->_blocks[i * _blockCols + j])))); 
-                } 
-            }
-        }
-
-        return result;
+        return combineBlocks(*otherBlock, true, [](T x, T y) { return x + y; });
     }
 
     Matrix<T>* operator-(const Matrix<T>& other) const override {
@@ -150,17 +449,7 @@ public:
             throw std::invalid_argument("Matrix block dimensions must be equal for subtraction.");
         }
 
-        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
-
-        for (size_t i = 0; i < _blockRows; ++i) {
-            for (size_t j = 0; j < _blockCols; ++j) {
-                if (_blocks[i * _blockCols + j] != nullptr && otherBlock->_blocks[i * _blockCols + j] != nullptr) {
-                    result->setBlock(i, j, *(_blocks[i * _blockCols + j]->operator-(*(otherBlock->_blocks[i * _blockCols + j])))); 
-                } 
-            }
-        }
-
-        return result;
+        return combineBlocks(*otherBlock, true, [](T x, T y) { return x - y; });
     }
 
     Matrix<T>* operator*(const Matrix<T>& other) const override {
@@ -169,25 +458,11 @@ public:
             throw std::invalid_argument("Incompatible matrix types for multiplication.");
         }
 
-        if (_blockCols != otherBlock->_blockRows) {
+        if (_blockCols != otherBlock->_blockRows || _blockSize != otherBlock->_blockSize) {
             throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
         }
 
-        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, otherBlock->_blockCols, _blockSize);
-
-        for (size_t i = 0; i < _blockRows; ++i) {
-            for (size_t j = 0; j < otherBlock->_blockCols; ++j) {
-                MatrixDense<T>* blockSum = new MatrixDense<T>(_blockSize, _blockSize);
-                for (size_t k = 0; k < _blockCols; ++k) {
-                    if (_blocks[i * _blockCols + k] != nullptr && otherBlock->_blocks[k * otherBlock->_blockCols + j] != nullptr) {
-                        *blockSum = *blockSum + *(_blocks[i * _blockCols + k]->operator*(*(otherBlock->_blocks[k * otherBlock->_blockCols + j]))); 
-                    }
-                }
-                result->setBlock(i, j, blockSum);
-            }
-        }
-
-        return result;
+        return multiplyBlocks(*otherBlock, false);
     }
 
     Matrix<T>* elementWiseMultiplication(const Matrix<T>& other) const override {
@@ -200,12 +475,18 @@ public:
             throw std::invalid_argument("Matrix block dimensions must be equal for element-wise multiplication.");
         }
 
-        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
+        return combineBlocks(*otherBlock, false, [](T x, T y) { return x * y; });
+    }
+
+    Matrix<T>* transpose() const override {
+        MatrixBlock<T>* result = new MatrixBlock<T>(_blockCols, _blockRows, _blockSize);
 
         for (size_t i = 0; i < _blockRows; ++i) {
             for (size_t j = 0; j < _blockCols; ++j) {
-                if (_blocks[i * _blockCols + j] != nullptr && otherBlock->_blocks[i * _blockCols + j] != nullptr) {
-                    result->setBlock(i, j, *(_blocks[i * _blockCols + j]->elementWiseMultiplication(*(otherBlock->_blocks[i * _blockCols + j])))); 
+                if (_blocks[i * _blockCols + j] != nullptr) {
+                    BlockPtr tile = result->newTile();
+                    transpose_kernel::transpose(_blocks[i * _blockCols + j]->getData(), tile->getData(), _blockSize, _blockSize);
+                    result->_blocks[j * _blockRows + i] = tile;
                 }
             }
         }
@@ -213,17 +494,231 @@ public:
         return result;
     }
 
-    Matrix<T>* transpose() const override {
-        MatrixBlock<T>* result = new MatrixBlock<T>(_blockCols, _blockRows, _blockSize);
+    // Произведение this * other^T поблочно: C_ij = sum_k A_ik * (B_jk)^T,
+    // ни other^T, ни транспонированные блоки не создаются
+    MatrixBlock<T>* multiplyTransposed(const MatrixBlock<T>& other) const {
+        if (_blockCols != other._blockCols || _blockSize != other._blockSize) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+        }
 
-        for (size_t i = 0; i < _blockRows; ++i) {
-            for (size_t j = 0; j < _blockCols; ++j) {
-                if (_blocks[i * _blockCols + j] != nullptr) {
-                    result->setBlock(j, i, _blocks[i * _blockCols + j]->transpose()); 
+        return multiplyBlocks(other, true);
+    }
+
+    // Быстрое умножение квадратных сеток блоков по Штрассену-Винограду. Сетка дополняется
+    // нулевыми блоками до m * 2^k (это бесплатно), ниже strassen::params().blockCrossover
+    // блоков работает обычный движок multiplyBlocks.
+    MatrixBlock<T>* multiplyStrassen(const MatrixBlock<T>& other) const {
+        if (_blockRows != _blockCols || other._blockRows != other._blockCols || _blockCols != other._blockRows
+            || _blockSize != other._blockSize) {
+            throw std::invalid_argument("Strassen multiplication requires square block grids of equal size.");
+        }
+
+        const strassen::Params p = strassen::params();
+        const size_t padded = strassen::paddedSize(_blockRows, std::max<size_t>(p.blockCrossover, 1));
+        MatrixBlock<T> product = strassenGrids(subGrid(0, 0, padded), other.subGrid(0, 0, padded), p.parallelDepth);
+        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
+        result->placeGrid(product, 0, 0);
+        return result;
+    }
+
+    // Тайловое LU с частичным выбором главного элемента: P A = L U в тех же тайлах
+    // (pivots - глобальные номера строк, как у MatrixDense::luDecomposition). Задачи -
+    // панель столбца тайлов k, перестановки с решением L_kk U_kj = A_kj в остальных
+    // столбцах и обновления A_ij -= L_ik U_kj - выстраиваются в TaskGraph по зависимостям
+    // данных. Готовые задачи берутся по номеру столбца, поэтому панель следующего шага
+    // начинается, как только обновлён её столбец, параллельно с остальными обновлениями.
+    MatrixBlock<T>* luDecomposition(std::vector<unsigned>& pivots) const {
+        static_assert(std::is_floating_point<T>::value, "LU decomposition is intended for float/double matrices.");
+        if (_blockRows != _blockCols) {
+            throw std::invalid_argument("LU decomposition requires a square block grid.");
+        }
+        const size_t N = _blockRows, bs = _blockSize;
+        MatrixBlock<T>* result = new MatrixBlock<T>(*this);
+        // Перестановки и обновления заполняют все тайлы: нулевые создаются, общие копируются заранее
+        std::vector<T*> tiles(N * N);
+        for (size_t b = 0; b < tiles.size(); ++b) {
+            if (!result->_blocks[b]) result->_blocks[b] = result->newTile();
+            tiles[b] = result->mutableBlock(b)->getData();
+        }
+        auto tile = [&tiles, N](size_t i, size_t j) { return tiles[i * N + j]; };
+
+        pivots.assign(N * bs, 0);
+        std::atomic<bool> regular{true};
+        const size_t pivotResource = N * N; // + k: перестановки шага k
+        TaskGraph graph;
+        for (size_t k = 0; k < N; ++k) {
+            std::vector<size_t> column;
+            for (size_t i = k; i < N; ++i) column.push_back(i * N + k);
+            column.push_back(pivotResource + k);
+            // Панель: тайлы столбца k, поставленные друг под другом, образуют сплошную матрицу (N-k)*bs x bs
+            graph.add([&, k]() {
+                std::vector<T> panel((N - k) * bs * bs);
+                for (size_t i = k; i < N; ++i) std::copy(tile(i, k), tile(i, k) + bs * bs, panel.data() + (i - k) * bs * bs);
+                if (!factorization::panelLU(panel.data(), bs, (N - k) * bs, bs, pivots.data() + k * bs)) regular = false;
+                for (size_t j = 0; j < bs; ++j) pivots[k * bs + j] += static_cast<unsigned>(k * bs);
+                for (size_t i = k; i < N; ++i) std::copy(panel.data() + (i - k) * bs * bs, panel.data() + (i - k + 1) * bs * bs, tile(i, k));
+            }, {}, column, k * N + k);
+
+            for (size_t j = 0; j < N; ++j) {
+                if (j == k) continue;
+                std::vector<size_t> writes;
+                for (size_t i = k; i < N; ++i) writes.push_back(i * N + j);
+                std::vector<size_t> reads{pivotResource + k};
+                if (j > k) reads.push_back(k * N + k);
+                // Перестановки шага k в столбце тайлов j; справа от панели - ещё и U_kj = L_kk^{-1} A_kj.
+                // Столбцы слева (уже готовая L) не на критическом пути и идут последними.
+                graph.add([&, k, j]() {
+                    for (size_t r = k * bs; r < (k + 1) * bs; ++r) {
+                        const size_t p = pivots[r];
+                        if (p == r) continue;
+                        T* a = tile(r / bs, j) + (r % bs) * bs;
+                        std::swap_ranges(a, a + bs, tile(p / bs, j) + (p % bs) * bs);
+                    }
+                    if (j > k) factorization::solveLowerRows(tile(k, k), bs, bs, tile(k, j), bs, bs, true);
+                }, reads, writes, j > k ? j * N + k : N * N + k);
+            }
+
+            for (size_t i = k + 1; i < N; ++i) {
+                for (size_t j = k + 1; j < N; ++j) {
+                    graph.add([&, i, j, k]() {
+                        subtractProduct(tile(i, k), tile(k, j), tile(i, j), bs, false);
+                    }, {i * N + k, k * N + j}, {i * N + j}, j * N + k);
                 }
             }
         }
+        graph.run();
+        if (!regular) {
+            delete result;
+            throw std::runtime_error("Matrix is singular.");
+        }
+        return result;
+    }
 
+    // Тайловый Холецкий A = L L^T (читаются тайлы нижнего треугольника). Заполнение
+    // вычисляется заранее по шаблону нулевых блоков: L_ij существует, если существует A_ij
+    // или хоть одно обновление L_ik L_jk^T, - остальные тайлы остаются нулевыми.
+    MatrixBlock<T>* choleskyDecomposition() const {
+        static_assert(std::is_floating_point<T>::value, "Cholesky decomposition is intended for float/double matrices.");
+        if (_blockRows != _blockCols) {
+            throw std::invalid_argument("Cholesky decomposition requires a square block grid.");
+        }
+        const size_t N = _blockRows, bs = _blockSize;
+        std::vector<char> present(N * N, 0);
+        for (size_t i = 0; i < N; ++i)
+            for (size_t j = 0; j <= i; ++j)
+                present[i * N + j] = _blocks[i * N + j] != nullptr;
+        for (size_t k = 0; k < N; ++k) {
+            if (!present[k * N + k]) {
+                throw std::runtime_error("Matrix is not positive definite.");
+            }
+            for (size_t i = k + 1; i < N; ++i) {
+                if (!present[i * N + k]) continue;
+                for (size_t j = k + 1; j <= i; ++j) {
+                    if (present[j * N + k]) present[i * N + j] = 1;
+                }
+            }
+        }
+
+        MatrixBlock<T>* result = new MatrixBlock<T>(_blockRows, _blockCols, _blockSize);
+        result->_arena = _arena;
+        std::vector<T*> tiles(N * N, nullptr);
+        for (size_t b = 0; b < tiles.size(); ++b) {
+            if (!present[b]) continue;
+            result->_blocks[b] = result->newTile();
+            tiles[b] = result->_blocks[b]->getData();
+            if (_blocks[b]) std::copy(_blocks[b]->getData(), _blocks[b]->getData() + bs * bs, tiles[b]);
+        }
+        auto tile = [&tiles, N](size_t i, size_t j) { return tiles[i * N + j]; };
+
+        std::atomic<bool> positive{true};
+        TaskGraph graph;
+        for (size_t k = 0; k < N; ++k) {
+            graph.add([&, k]() {
+                if (!positive) return;
+                if (!factorization::choleskyBlock(tile(k, k), bs, bs)) positive = false;
+                for (size_t r = 0; r < bs; ++r) std::fill(tile(k, k) + r * bs + r + 1, tile(k, k) + (r + 1) * bs, T(0));
+            }, {}, {k * N + k}, k * N + k);
+            for (size_t i = k + 1; i < N; ++i) {
+                if (!present[i * N + k]) continue;
+                graph.add([&, i, k]() {
+                    if (!positive) return;
+                    factorization::solveRowsLowerTransposed(tile(k, k), bs, bs, tile(i, k), bs, 0, bs);
+                }, {k * N + k}, {i * N + k}, k * N + k);
+            }
+            for (size_t i = k + 1; i < N; ++i) {
+                if (!present[i * N + k]) continue;
+                for (size_t j = k + 1; j <= i; ++j) {
+                    if (!present[j * N + k]) continue;
+                    graph.add([&, i, j, k]() {
+                        if (!positive) return;
+                        subtractProduct(tile(i, k), tile(j, k), tile(i, j), bs, true);
+                    }, {i * N + k, j * N + k}, {i * N + j}, j * N + k);
+                }
+            }
+        }
+        graph.run();
+        if (!positive) {
+            delete result;
+            throw std::runtime_error("Matrix is not positive definite.");
+        }
+        return result;
+    }
+
+    // Решение A X = B по результату luDecomposition (вызывается у разложения): b - n x nrhs
+    // по строкам. Подстановки идут по блочным строкам, нулевые тайлы пропускаются.
+    void luSolveInPlace(const std::vector<unsigned>& pivots, T* b, size_t nrhs) const {
+        checkFactorSolve(pivots.size(), true);
+        const size_t N = _blockRows, bs = _blockSize;
+        factorization::applyPivots(b, nrhs, N * bs, nrhs, pivots.data());
+        std::vector<T> sum(bs * nrhs);
+        for (size_t i = 0; i < N; ++i) {
+            T* bi = b + i * bs * nrhs;
+            tileProductSum(i, 0, i, false, b, nrhs, sum.data());
+            for (size_t e = 0; e < sum.size(); ++e) bi[e] -= sum[e];
+            factorization::solveLower(_blocks[i * N + i]->getData(), bs, bs, bi, nrhs, nrhs, true);
+        }
+        for (size_t i = N; i-- > 0; ) {
+            T* bi = b + i * bs * nrhs;
+            tileProductSum(i, i + 1, N, false, b, nrhs, sum.data());
+            for (size_t e = 0; e < sum.size(); ++e) bi[e] -= sum[e];
+            factorization::solveUpper(_blocks[i * N + i]->getData(), bs, bs, bi, nrhs, nrhs);
+        }
+    }
+
+    MatrixDense<T>* luSolve(const std::vector<unsigned>& pivots, const MatrixDense<T>& b) const {
+        if (b.getRows() != getRows()) {
+            throw std::invalid_argument("Right-hand side does not match the factorization.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(b);
+        luSolveInPlace(pivots, result->getData(), b.getCols());
+        return result;
+    }
+
+    // Решение A X = B по результату choleskyDecomposition: L Y = B, затем L^T X = Y
+    void choleskySolveInPlace(T* b, size_t nrhs) const {
+        checkFactorSolve(0, false);
+        const size_t N = _blockRows, bs = _blockSize;
+        std::vector<T> sum(bs * nrhs);
+        for (size_t i = 0; i < N; ++i) {
+            T* bi = b + i * bs * nrhs;
+            tileProductSum(i, 0, i, false, b, nrhs, sum.data());
+            for (size_t e = 0; e < sum.size(); ++e) bi[e] -= sum[e];
+            factorization::solveLower(_blocks[i * N + i]->getData(), bs, bs, bi, nrhs, nrhs, false);
+        }
+        for (size_t i = N; i-- > 0; ) {
+            T* bi = b + i * bs * nrhs;
+            tileProductSum(i, i + 1, N, true, b, nrhs, sum.data());
+            for (size_t e = 0; e < sum.size(); ++e) bi[e] -= sum[e];
+            factorization::solveLowerTransposed(_blocks[i * N + i]->getData(), bs, bs, bi, nrhs, nrhs);
+        }
+    }
+
+    MatrixDense<T>* choleskySolve(const MatrixDense<T>& b) const {
+        if (b.getRows() != getRows()) {
+            throw std::invalid_argument("Right-hand side does not match the factorization.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(b);
+        choleskySolveInPlace(result->getData(), b.getCols());
         return result;
     }
 
@@ -245,9 +740,6 @@ public:
         if (file.fail() || blockRows == 0 || blockCols == 0 || blockSize == 0) {
             throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
         }
-        for(size_t i = 0; i < _blockRows*_blockCols; ++i){
-            if(_blocks[i]!=nullptr) delete _blocks[i];
-        }
         _blocks.clear();
         _blockRows = blockRows;
         _blockCols = blockCols;
@@ -260,7 +752,7 @@ public:
                 if(blockType == "nullptr"){
                     _blocks[i*_blockCols+j] = nullptr;
                 }else if(blockType == "MatrixDense"){
-                    _blocks[i*_blockCols + j] = new MatrixDense<T>(blockSize, blockSize);
+                    _blocks[i*_blockCols + j] = newTile();
                     for(size_t k = 0; k < blockSize; ++k){
                         for(size_t l = 0; l < blockSize; ++l){
                             file >> (*_blocks[i*_blockCols+j])(k, l);
@@ -297,6 +789,159 @@ public:
         }
         file.close();
     }
+    // Параллельный разбор текстового формата importFromFile. По позициям тегов
+    // "nullptr"/"MatrixDense" из первого прохода определяется, какие блоки присутствуют,
+    // после чего числа разбираются прямо в свои блоки.
+    void parallelImportFromFile(const std::string& filename, size_t numThreads) {
+        MappedFile mapped(filename);
+        const char* end = mapped.data() + mapped.size();
+        unsigned dims[3];
+        const char* payload = matrix_text::parseHeader(mapped.data(), end, "MatrixBlock", dims, 3, filename);
+        const size_t blockCount = size_t(dims[0]) * dims[1];
+        const size_t blockElems = size_t(dims[2]) * dims[2];
+
+        auto chunks = matrix_text::scan(payload, end, numThreads);
+        std::vector<bool> present;
+        present.reserve(blockCount);
+        size_t denseCount = 0;
+        for (const auto& chunk : chunks) {
+            for (const auto& tag : chunk.tags) {
+                // Каждый тег должен стоять ровно после данных предыдущих плотных блоков
+                if (present.size() == blockCount || chunk.firstIndex + tag.numbersBefore != denseCount * blockElems) {
+                    throw std::runtime_error("Invalid block type in file");
+                }
+                present.push_back(tag.dense);
+                if (tag.dense) ++denseCount;
+            }
+        }
+        if (present.size() != blockCount || matrix_text::totalNumbers(chunks) != denseCount * blockElems) {
+            throw std::runtime_error("Error reading matrix data from file: " + filename);
+        }
+
+        // Блоки собираются в отдельной матрице, чтобы при ошибке разбора не испортить текущую
+        MatrixBlock<T> loaded(dims[0], dims[1], dims[2]);
+        loaded._arena = std::make_shared<BlockArena<T>>(blockElems);
+        loaded._arena->reserve(denseCount);
+        std::vector<T*> denseData;
+        denseData.reserve(denseCount);
+        for (size_t i = 0; i < blockCount; ++i) {
+            if (present[i]) {
+                loaded._blocks[i] = loaded.newTile();
+                denseData.push_back(loaded._blocks[i]->getData());
+            }
+        }
+        matrix_text::parse<T>(chunks, filename, [&denseData, blockElems](size_t index, T value) {
+            denseData[index / blockElems][index % blockElems] = value;
+        });
+        *this = loaded;
+    }
+
+    // Параллельная запись в текстовом формате exportToFile, блоки делятся между потоками
+    void parallelExportToFile(const std::string& filename, size_t numThreads) const {
+        std::string header = "MatrixBlock\n" + std::to_string(_blockRows) + " " + std::to_string(_blockCols) + " "
+                             + std::to_string(_blockSize) + "\n";
+        matrix_text::writeParallel(filename, header, _blocks.size(), numThreads, [this](size_t begin, size_t end, std::string& out) {
+            for (size_t b = begin; b < end; ++b) {
+                if (_blocks[b] == nullptr) {
+                    out += "nullptr\n";
+                    continue;
+                }
+                out += "MatrixDense\n";
+                const T* blockData = _blocks[b]->getData();
+                for (size_t k = 0; k < _blockSize; ++k) {
+                    for (size_t l = 0; l < _blockSize; ++l) {
+                        matrix_text::appendValue(out, blockData[k * _blockSize + l]);
+                    }
+                    out.push_back('\n');
+                }
+            }
+        });
+    }
+
+    // Бинарный формат: таблица смещений блоков + выровненные блоки.
+    // Нулевые блоки места не занимают, разделяемые тайлы записываются один раз.
+    void exportToBinaryFile(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+
+        MatrixFileHeader header = matrix_binary::makeHeader<T>(MatrixFileType::Block, getRows(), getCols());
+        header.blockRows = _blockRows;
+        header.blockCols = _blockCols;
+        header.blockSize = _blockSize;
+        header.dataOffset = matrix_binary::alignUp(sizeof(header) + sizeof(uint64_t) * _blocks.size());
+
+        const uint64_t blockBytes = sizeof(T) * uint64_t(_blockSize) * _blockSize;
+        std::vector<uint64_t> table(_blocks.size(), 0);
+        std::vector<const MatrixDense<T>*> written;
+        std::map<const MatrixDense<T>*, uint64_t> offsets;
+        uint64_t position = header.dataOffset;
+        for (size_t i = 0; i < _blocks.size(); ++i) {
+            if (_blocks[i] == nullptr) continue;
+            auto found = offsets.find(_blocks[i].get());
+            if (found != offsets.end()) {
+                table[i] = found->second;
+                continue;
+            }
+            table[i] = position;
+            offsets[_blocks[i].get()] = position;
+            written.push_back(_blocks[i].get());
+            position = matrix_binary::alignUp(position + blockBytes);
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(sizeof(uint64_t) * table.size()));
+        position = sizeof(header) + sizeof(uint64_t) * table.size();
+        for (const MatrixDense<T>* block : written) {
+            uint64_t target = offsets[block];
+            matrix_binary::padTo(file, position, target);
+            file.write(reinterpret_cast<const char*>(block->getData()), static_cast<std::streamsize>(blockBytes));
+            position = target + blockBytes;
+        }
+        if (!file) {
+            throw std::runtime_error("Error writing matrix data to file: " + filename);
+        }
+    }
+
+    // Открывает бинарный файл через mmap: блоки ссылаются прямо на страницы файла
+    void importFromBinaryFile(const std::string& filename) {
+        auto mapped = std::make_shared<MappedFile>(filename);
+        const MatrixFileHeader& header = matrix_binary::readHeader<T>(*mapped, MatrixFileType::Block, filename);
+        const uint64_t blockCount = uint64_t(header.blockRows) * header.blockCols;
+        const uint64_t blockElements = uint64_t(header.blockSize) * header.blockSize;
+        if (blockCount == 0 || header.blockSize == 0
+            || header.rows != uint64_t(header.blockRows) * header.blockSize
+            || header.cols != uint64_t(header.blockCols) * header.blockSize
+            || !matrix_binary::fitsInFile(sizeof(header), blockCount, sizeof(uint64_t), header.dataOffset)) {
+            throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
+        }
+        const uint64_t* table = reinterpret_cast<const uint64_t*>(mapped->data() + sizeof(header));
+        for (uint64_t i = 0; i < blockCount; ++i) {
+            if (table[i] != 0 && (table[i] < header.dataOffset
+                                  || !matrix_binary::fitsInFile(table[i], blockElements, sizeof(T), mapped->size()))) {
+                throw std::runtime_error("Invalid block offset in file: " + filename);
+            }
+        }
+
+        _blocks.clear();
+        _blockRows = header.blockRows;
+        _blockCols = header.blockCols;
+        _blockSize = header.blockSize;
+        _blocks.resize(blockCount, nullptr);
+        // Одинаковые смещения в таблице снова становятся одним разделяемым блоком
+        std::map<uint64_t, BlockPtr> byOffset;
+        for (uint64_t i = 0; i < blockCount; ++i) {
+            if (table[i] == 0) continue;
+            BlockPtr& block = byOffset[table[i]];
+            if (!block) {
+                T* blockData = reinterpret_cast<T*>(mapped->data() + table[i]);
+                block = std::make_shared<MatrixDense<T>>(_blockSize, _blockSize, blockData, mapped);
+            }
+            _blocks[i] = block;
+        }
+    }
+
     void print() const override{
         for (unsigned i = 0; i < getRows(); ++i) {
             for (unsigned j = 0; j < getCols(); ++j) {
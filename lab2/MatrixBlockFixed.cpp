@@ -0,0 +1,266 @@
+#pragma once
+
+#include "MatrixBlock.cpp"
+#include "MatrixFixed.cpp"
+#include "ThreadPool.cpp"
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// MatrixBlock с размером блока BlockSize, известным при компиляции. Ненулевые тайлы MatrixFixed
+// лежат подряд в одном массиве без отдельных выделений памяти, таблица индексов отмечает
+// нулевые блоки. Операции над тайлами разворачиваются компилятором, а доступ к ним не
+// проходит через виртуальные вызовы и проверки границ. Текстовый и бинарный форматы те же,
+// что у MatrixBlock<T>: чтение и запись идут через преобразование в него.
+template <typename T, unsigned BlockSize>
+class MatrixBlock : public Matrix<T> {
+public:
+    using Tile = MatrixFixed<T, BlockSize, BlockSize>;
+
+private:
+    static constexpr unsigned NONE = std::numeric_limits<unsigned>::max();
+
+    unsigned _blockRows;
+    unsigned _blockCols;
+    std::vector<unsigned> _index; // номер тайла в _tiles для каждого блока или NONE
+    std::vector<Tile> _tiles;
+
+    // Тайл для записи; нулевой блок при первом обращении становится нулевым тайлом
+    Tile& tileAt(size_t block) {
+        if (_index[block] == NONE) {
+            _index[block] = static_cast<unsigned>(_tiles.size());
+            _tiles.emplace_back();
+        }
+        return _tiles[_index[block]];
+    }
+
+    const Tile* findTile(size_t block) const {
+        return _index[block] == NONE ? nullptr : &_tiles[_index[block]];
+    }
+
+    void checkSameShape(const MatrixBlock& other) const {
+        if (_blockRows != other._blockRows || _blockCols != other._blockCols) {
+            throw std::invalid_argument("Matrix dimensions must be equal.");
+        }
+    }
+
+    const MatrixBlock& castOther(const Matrix<T>& other, const char* message) const {
+        const MatrixBlock* otherBlock = dynamic_cast<const MatrixBlock*>(&other);
+        if (!otherBlock) {
+            throw std::invalid_argument(message);
+        }
+        return *otherBlock;
+    }
+
+    // Поэлементная операция op(x, y) прямо в тайлы результата; keepUnion - результат есть там,
+    // где есть хотя бы один блок (сложение и вычитание), иначе только там, где есть оба
+    template <typename Op>
+    MatrixBlock* combine(const MatrixBlock& other, bool keepUnion, Op op) const {
+        checkSameShape(other);
+        MatrixBlock* result = new MatrixBlock(_blockRows, _blockCols);
+        unsigned count = 0;
+        for (size_t b = 0; b < _index.size(); ++b) {
+            const bool x = _index[b] != NONE, y = other._index[b] != NONE;
+            if (keepUnion ? (x || y) : (x && y)) result->_index[b] = count++;
+        }
+        result->_tiles.resize(count);
+        const Tile zero;
+        for (size_t b = 0; b < _index.size(); ++b) {
+            if (result->_index[b] == NONE) continue;
+            const Tile* x = findTile(b);
+            const Tile* y = other.findTile(b);
+            const T* xd = (x ? *x : zero).getData();
+            const T* yd = (y ? *y : zero).getData();
+            T* out = result->_tiles[result->_index[b]].getData();
+            for (unsigned e = 0; e < BlockSize * BlockSize; ++e) out[e] = op(xd[e], yd[e]);
+        }
+        return result;
+    }
+
+public:
+    MatrixBlock(unsigned blockRows, unsigned blockCols)
+        : _blockRows(blockRows), _blockCols(blockCols), _index(size_t(blockRows) * blockCols, NONE) {}
+
+    // Та же форма, что у MatrixBlock<T>; blockSize должен совпадать с параметром шаблона
+    MatrixBlock(unsigned blockRows, unsigned blockCols, unsigned blockSize) : MatrixBlock(blockRows, blockCols) {
+        if (blockSize != BlockSize) {
+            throw std::invalid_argument("Block size does not match the template parameter.");
+        }
+    }
+
+    // Из MatrixBlock<T> с тем же размером блока; нулевые блоки остаются нулевыми
+    explicit MatrixBlock(const MatrixBlock<T>& dynamic) : MatrixBlock(dynamic.getBlockRows(), dynamic.getBlockCols()) {
+        if (dynamic.getBlockSize() != BlockSize) {
+            throw std::invalid_argument("Block size does not match the template parameter.");
+        }
+        for (unsigned i = 0; i < _blockRows; ++i) {
+            for (unsigned j = 0; j < _blockCols; ++j) {
+                const MatrixDense<T>* block = dynamic.getBlock(i, j);
+                if (block == nullptr) continue;
+                Tile& tile = tileAt(size_t(i) * _blockCols + j);
+                std::copy(block->getData(), block->getData() + BlockSize * BlockSize, tile.getData());
+            }
+        }
+    }
+
+    MatrixBlock<T> toDynamic() const {
+        MatrixBlock<T> dynamic(_blockRows, _blockCols, BlockSize);
+        for (unsigned i = 0; i < _blockRows; ++i) {
+            for (unsigned j = 0; j < _blockCols; ++j) {
+                const Tile* tile = findTile(size_t(i) * _blockCols + j);
+                if (tile == nullptr) continue;
+                MatrixDense<T>* block = new MatrixDense<T>(BlockSize, BlockSize);
+                std::copy(tile->getData(), tile->getData() + BlockSize * BlockSize, block->getData());
+                dynamic.setBlock(i, j, block);
+            }
+        }
+        return dynamic;
+    }
+
+    T& operator()(unsigned i, unsigned j) override {
+        if (i >= getRows() || j >= getCols()) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        return tileAt(size_t(i / BlockSize) * _blockCols + j / BlockSize)(i % BlockSize, j % BlockSize);
+    }
+
+    const T& operator()(unsigned i, unsigned j) const override {
+        if (i >= getRows() || j >= getCols()) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        const Tile* tile = findTile(size_t(i / BlockSize) * _blockCols + j / BlockSize);
+        if (tile == nullptr) {
+            static const T zero = 0;
+            return zero;
+        }
+        return (*tile)(i % BlockSize, j % BlockSize);
+    }
+
+    void setBlock(unsigned blockRow, unsigned blockCol, const Tile& tile) {
+        if (blockRow >= _blockRows || blockCol >= _blockCols) {
+            throw std::out_of_range("Block index out of bounds.");
+        }
+        tileAt(size_t(blockRow) * _blockCols + blockCol) = tile;
+    }
+
+    // nullptr для нулевого блока
+    const Tile* getBlock(unsigned blockRow, unsigned blockCol) const {
+        if (blockRow >= _blockRows || blockCol >= _blockCols) {
+            throw std::out_of_range("Block index out of bounds.");
+        }
+        return findTile(size_t(blockRow) * _blockCols + blockCol);
+    }
+
+    unsigned getBlockRows() const { return _blockRows; }
+    unsigned getBlockCols() const { return _blockCols; }
+    static constexpr unsigned getBlockSize() { return BlockSize; }
+    unsigned getRows() const { return _blockRows * BlockSize; }
+    unsigned getCols() const { return _blockCols * BlockSize; }
+
+    Matrix<T>* operator+(const Matrix<T>& other) const override {
+        const MatrixBlock& otherBlock = castOther(other, "Incompatible matrix types for addition.");
+        return combine(otherBlock, true, [](T x, T y) { return x + y; });
+    }
+
+    Matrix<T>* operator-(const Matrix<T>& other) const override {
+        const MatrixBlock& otherBlock = castOther(other, "Incompatible matrix types for substraction.");
+        return combine(otherBlock, true, [](T x, T y) { return x - y; });
+    }
+
+    Matrix<T>* elementWiseMultiplication(const Matrix<T>& other) const override {
+        const MatrixBlock& otherBlock = castOther(other, "Incompatible matrix types for element-wise multiplication.");
+        return combine(otherBlock, false, [](T x, T y) { return x * y; });
+    }
+
+    // Сначала по шаблону нулевых блоков размечаются блоки результата (тайлы выделяются
+    // одним массивом), затем блочные строки считаются параллельно прямо в свои тайлы;
+    // перебираются только пары ненулевых блоков A_ik, B_kj
+    Matrix<T>* operator*(const Matrix<T>& other) const override {
+        const MatrixBlock& otherBlock = castOther(other, "Incompatible matrix types for multiplication.");
+        if (_blockCols != otherBlock._blockRows) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+        }
+        const size_t resultCols = otherBlock._blockCols;
+        std::vector<std::vector<std::pair<unsigned, const Tile*>>> otherByK(_blockCols);
+        for (size_t k = 0; k < otherBlock._blockRows; ++k) {
+            for (size_t j = 0; j < resultCols; ++j) {
+                if (const Tile* tile = otherBlock.findTile(k * resultCols + j)) {
+                    otherByK[k].push_back({static_cast<unsigned>(j), tile});
+                }
+            }
+        }
+
+        MatrixBlock* result = new MatrixBlock(_blockRows, static_cast<unsigned>(resultCols));
+        unsigned count = 0;
+        for (size_t i = 0; i < _blockRows; ++i) {
+            for (size_t k = 0; k < _blockCols; ++k) {
+                if (_index[i * _blockCols + k] == NONE) continue;
+                for (const auto& entry : otherByK[k]) {
+                    unsigned& slot = result->_index[i * resultCols + entry.first];
+                    if (slot == NONE) slot = count++;
+                }
+            }
+        }
+        result->_tiles.resize(count);
+
+        ThreadPool::global().parallelFor(_blockRows, [&](size_t i) {
+            for (size_t k = 0; k < _blockCols; ++k) {
+                const Tile* a = findTile(i * _blockCols + k);
+                if (a == nullptr) continue;
+                for (const auto& entry : otherByK[k]) {
+                    result->_tiles[result->_index[i * resultCols + entry.first]].multiplyAccumulate(*a, *entry.second);
+                }
+            }
+        });
+        return result;
+    }
+
+    Matrix<T>* transpose() const override {
+        // Тайлы результата в том же порядке, что и исходные: номер тайла сохраняется
+        MatrixBlock* result = new MatrixBlock(_blockCols, _blockRows);
+        result->_tiles.resize(_tiles.size());
+        for (size_t i = 0; i < _blockRows; ++i) {
+            for (size_t j = 0; j < _blockCols; ++j) {
+                const unsigned index = _index[i * _blockCols + j];
+                if (index == NONE) continue;
+                result->_index[j * _blockRows + i] = index;
+                const Tile& source = _tiles[index];
+                Tile& target = result->_tiles[index];
+                for (unsigned r = 0; r < BlockSize; ++r)
+                    for (unsigned c = 0; c < BlockSize; ++c)
+                        target(c, r) = source(r, c);
+            }
+        }
+        return result;
+    }
+
+    void importFromFile(const std::string& filename) override {
+        MatrixBlock<T> loaded(1, 1, BlockSize);
+        loaded.importFromFile(filename);
+        *this = MatrixBlock(loaded);
+    }
+
+    void exportToFile(const std::string& filename) const override {
+        toDynamic().exportToFile(filename);
+    }
+
+    void importFromBinaryFile(const std::string& filename) {
+        MatrixBlock<T> loaded(1, 1, BlockSize);
+        loaded.importFromBinaryFile(filename);
+        *this = MatrixBlock(loaded);
+    }
+
+    void exportToBinaryFile(const std::string& filename) const {
+        toDynamic().exportToBinaryFile(filename);
+    }
+
+    void print() const override {
+        for (unsigned i = 0; i < getRows(); ++i) {
+            for (unsigned j = 0; j < getCols(); ++j) {
+                std::cout << std::setw(10) << (*this)(i, j) << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
+};
@@ -0,0 +1,554 @@
+#pragma once
+
+#include "BlockArena.cpp"
+#include "GemmKernel.cpp"
+#include "MatrixBinaryFormat.cpp"
+#include "ThreadPool.cpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Умножение блочных матриц, не помещающихся в память. Тайлы лежат в бинарном формате
+// MatrixBlock (exportToBinaryFile / importFromBinaryFile) и читаются по одному через
+// LRU-кэш с фиксированным бюджетом. C считается полосами r x s тайлов, которые остаются
+// в памяти, пока по k проходят столбец тайлов A и строка тайлов B. Так каждый тайл A
+// читается colPanels раз, а тайл B - rowPanels раз, и r, s выбираются максимальными под
+// бюджет. Если бюджет вмещает целую полосу строк A (r x K тайлов) и это даёт меньше
+// чтений, полоса A закрепляется в кэше, пока по ней проходят все столбцы B: тайл A
+// читается один раз, тайл B - rowPanels раз. Полосы обходятся змейкой, а k меняет
+// направление от полосы к полосе, поэтому тайлы, прочитанные последними, первыми нужны
+// снова и находятся в кэше. Тайлы следующего шага k могут читаться фоновым потоком, пока
+// считается текущий (Options::prefetch).
+namespace out_of_core {
+
+// Бинарный файл MatrixBlock с чтением и записью отдельных тайлов
+template <typename T>
+class TileFile {
+private:
+    std::string _filename;
+    std::fstream _file;
+    std::mutex _mutex;  // позиционирование и запись через один поток файла
+#ifndef _WIN32
+    int _fd = -1;       // чтение тайлов через pread: без общей позиции и без блокировки
+#endif
+    MatrixFileHeader _header;
+    std::vector<uint64_t> _table;  // смещение тайла, 0 - нулевой тайл
+    uint64_t _end = 0;             // сюда дописывается следующий тайл
+    std::atomic<uint64_t> _bytesRead{0};
+    std::atomic<uint64_t> _bytesWritten{0};
+
+public:
+    // Открывает файл, записанный MatrixBlock::exportToBinaryFile; данные не читаются
+    explicit TileFile(const std::string& filename) : _filename(filename) {
+        _file.open(filename, std::ios::in | std::ios::binary);
+        if (!_file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        _file.seekg(0, std::ios::end);
+        const uint64_t fileSize = uint64_t(_file.tellg());
+        _file.seekg(0);
+        if (fileSize < sizeof(_header) || !_file.read(reinterpret_cast<char*>(&_header), sizeof(_header))) {
+            throw std::runtime_error("File is too small for binary matrix: " + filename);
+        }
+        matrix_binary::checkHeader<T>(_header, fileSize, MatrixFileType::Block, filename);
+        const uint64_t blockCount = uint64_t(_header.blockRows) * _header.blockCols;
+        if (blockCount == 0 || _header.blockSize == 0
+            || _header.rows != uint64_t(_header.blockRows) * _header.blockSize
+            || _header.cols != uint64_t(_header.blockCols) * _header.blockSize
+            || sizeof(_header) + sizeof(uint64_t) * blockCount > _header.dataOffset) {
+            throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
+        }
+        _table.resize(blockCount);
+        _file.read(reinterpret_cast<char*>(_table.data()), static_cast<std::streamsize>(sizeof(uint64_t) * blockCount));
+        for (uint64_t offset : _table) {
+            if (offset != 0 && (offset < _header.dataOffset || offset + tileBytes() > fileSize)) {
+                throw std::runtime_error("Invalid block offset in file: " + filename);
+            }
+        }
+        _end = fileSize;
+        openForReading();
+    }
+
+    // Создаёт файл blockRows x blockCols тайлов, пока нулевых; тайлы дописываются write(),
+    // таблица смещений сохраняется finish()
+    TileFile(const std::string& filename, unsigned blockRows, unsigned blockCols, unsigned blockSize)
+        : _filename(filename) {
+        if (blockRows == 0 || blockCols == 0 || blockSize == 0) {
+            throw std::invalid_argument("Matrix dimensions must be positive.");
+        }
+        _file.open(filename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!_file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        _header = matrix_binary::makeHeader<T>(MatrixFileType::Block, uint64_t(blockRows) * blockSize,
+                                               uint64_t(blockCols) * blockSize);
+        _header.blockRows = blockRows;
+        _header.blockCols = blockCols;
+        _header.blockSize = blockSize;
+        _table.assign(size_t(blockRows) * blockCols, 0);
+        _header.dataOffset = matrix_binary::alignUp(sizeof(_header) + sizeof(uint64_t) * _table.size());
+        _end = _header.dataOffset;
+        finish();
+        openForReading();
+    }
+
+    TileFile(const TileFile&) = delete;
+    TileFile& operator=(const TileFile&) = delete;
+
+    ~TileFile() {
+#ifndef _WIN32
+        if (_fd >= 0) close(_fd);
+#endif
+    }
+
+    unsigned getBlockRows() const { return _header.blockRows; }
+    unsigned getBlockCols() const { return _header.blockCols; }
+    unsigned getBlockSize() const { return _header.blockSize; }
+    size_t tileElems() const { return size_t(_header.blockSize) * _header.blockSize; }
+    size_t tileBytes() const { return sizeof(T) * tileElems(); }
+
+    // Смещение тайла в файле; одинаковое у разделяемых тайлов, 0 - нулевой тайл
+    uint64_t offset(unsigned blockRow, unsigned blockCol) const {
+        return _table[size_t(blockRow) * _header.blockCols + blockCol];
+    }
+
+    // Число различных ненулевых тайлов в файле
+    size_t presentTiles() const {
+        std::set<uint64_t> offsets(_table.begin(), _table.end());
+        offsets.erase(0);
+        return offsets.size();
+    }
+
+    // Чтение тайла; потоки читают одновременно (кроме Windows). Видны тайлы, записанные до finish()
+    void read(uint64_t offset, T* out) {
+#ifdef _WIN32
+        std::lock_guard<std::mutex> lock(_mutex);
+        _file.seekg(static_cast<std::streamoff>(offset));
+        if (!_file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(tileBytes()))) {
+            _file.clear();
+            throw std::runtime_error("Error reading matrix data from file: " + _filename);
+        }
+#else
+        char* dst = reinterpret_cast<char*>(out);
+        size_t done = 0;
+        while (done < tileBytes()) {
+            const ssize_t got = pread(_fd, dst + done, tileBytes() - done, static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                throw std::runtime_error("Error reading matrix data from file: " + _filename);
+            }
+            done += size_t(got);
+        }
+#endif
+        _bytesRead += tileBytes();
+    }
+
+    void write(unsigned blockRow, unsigned blockCol, const T* data) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _file.seekp(static_cast<std::streamoff>(_end));
+        if (!_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(tileBytes()))) {
+            throw std::runtime_error("Error writing matrix data to file: " + _filename);
+        }
+        _table[size_t(blockRow) * _header.blockCols + blockCol] = _end;
+        _end = matrix_binary::alignUp(_end + tileBytes());
+        _bytesWritten += tileBytes();
+    }
+
+    // Записывает заголовок и таблицу смещений; до этого файл нельзя открыть как матрицу
+    void finish() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _file.seekp(0);
+        _file.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+        _file.write(reinterpret_cast<const char*>(_table.data()), static_cast<std::streamsize>(sizeof(uint64_t) * _table.size()));
+        matrix_binary::padTo(_file, sizeof(_header) + sizeof(uint64_t) * _table.size(), _header.dataOffset);
+        _file.flush();
+        if (!_file) {
+            throw std::runtime_error("Error writing matrix data to file: " + _filename);
+        }
+    }
+
+    uint64_t bytesRead() const { return _bytesRead; }
+    uint64_t bytesWritten() const { return _bytesWritten; }
+
+private:
+    void openForReading() {
+#ifndef _WIN32
+        _fd = open(_filename.c_str(), O_RDONLY);
+        if (_fd < 0) {
+            throw std::runtime_error("Failed to open file: " + _filename);
+        }
+#endif
+    }
+};
+
+// LRU-кэш тайлов на фиксированное число слотов. Закреплённые acquire() тайлы не
+// вытесняются до release(); prefetch() ставит тайл в очередь фонового чтения
+template <typename T>
+class TileCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;        // тайл уже был в памяти (или читался фоном)
+        uint64_t misses = 0;      // синхронное чтение в acquire()
+        uint64_t prefetched = 0;  // прочитано фоновым потоком
+        uint64_t evictions = 0;
+    };
+
+private:
+    using Key = std::pair<TileFile<T>*, uint64_t>;  // файл и смещение тайла
+
+    struct Entry {
+        T* data = nullptr;
+        size_t pins = 0;
+        bool ready = false;  // false - тайл ещё читается
+        typename std::list<Key>::iterator position;  // место в _lru, когда ready
+    };
+
+    BlockArena<T> _arena;
+    std::vector<T*> _free;
+    std::map<Key, Entry> _entries;
+    std::list<Key> _lru;  // прочитанные тайлы, в начале - давно не использованные
+    std::mutex _mutex;
+    std::condition_variable _loaded;
+    Stats _stats;
+
+    std::deque<Key> _queue;
+    std::condition_variable _wake;
+    std::thread _io;
+    bool _stop = false;
+
+    // Свободный слот или слот давно не использованного незакреплённого тайла
+    T* takeSlot() {
+        if (!_free.empty()) {
+            T* slot = _free.back();
+            _free.pop_back();
+            return slot;
+        }
+        for (auto it = _lru.begin(); it != _lru.end(); ++it) {
+            auto entry = _entries.find(*it);
+            if (entry->second.pins > 0) continue;
+            T* slot = entry->second.data;
+            _entries.erase(entry);
+            _lru.erase(it);
+            ++_stats.evictions;
+            return slot;
+        }
+        return nullptr;
+    }
+
+    // Чтение тайла в слот без блокировки кэша; при ошибке слот возвращается
+    void load(std::unique_lock<std::mutex>& lock, const Key& key, Entry& entry) {
+        lock.unlock();
+        try {
+            key.first->read(key.second, entry.data);
+        } catch (...) {
+            lock.lock();
+            _free.push_back(entry.data);
+            _entries.erase(key);
+            _loaded.notify_all();
+            throw;
+        }
+        lock.lock();
+        entry.ready = true;
+        entry.position = _lru.insert(_lru.end(), key);
+        _loaded.notify_all();
+    }
+
+    void ioLoop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait(lock, [this]() { return _stop || !_queue.empty(); });
+            if (_stop) return;
+            const Key key = _queue.front();
+            _queue.pop_front();
+            if (_entries.count(key)) continue;
+            T* slot = takeSlot();
+            if (slot == nullptr) continue;  // всё закреплено - тайл прочитает acquire()
+            Entry& entry = _entries[key];
+            entry.data = slot;
+            try {
+                load(lock, key, entry);
+                ++_stats.prefetched;
+            } catch (const std::exception&) {
+                // ошибку чтения сообщит синхронное чтение в acquire()
+            }
+        }
+    }
+
+public:
+    TileCache(size_t tileElems, size_t slots, bool prefetch) : _arena(tileElems) {
+        if (slots == 0) {
+            throw std::invalid_argument("Tile cache must have at least one slot.");
+        }
+        _arena.reserve(slots);
+        for (size_t i = 0; i < slots; ++i) _free.push_back(_arena.allocate());
+        if (prefetch) _io = std::thread([this]() { ioLoop(); });
+    }
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    ~TileCache() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        if (_io.joinable()) _io.join();
+    }
+
+    // Тайл по смещению в файле (nullptr для нулевого); закреплён до release()
+    const T* acquire(TileFile<T>& file, uint64_t offset) {
+        if (offset == 0) return nullptr;
+        const Key key(&file, offset);
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            auto found = _entries.find(key);
+            if (found == _entries.end()) break;
+            if (found->second.ready) {
+                ++_stats.hits;
+                ++found->second.pins;
+                _lru.splice(_lru.end(), _lru, found->second.position);
+                return found->second.data;
+            }
+            _loaded.wait(lock);
+        }
+        T* slot = takeSlot();
+        if (slot == nullptr) {
+            throw std::runtime_error("Tile cache budget is too small.");
+        }
+        ++_stats.misses;
+        Entry& entry = _entries[key];
+        entry.data = slot;
+        entry.pins = 1;
+        load(lock, key, entry);
+        return entry.data;
+    }
+
+    void release(TileFile<T>& file, uint64_t offset) {
+        if (offset == 0) return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _entries.find(Key(&file, offset));
+        if (found != _entries.end() && found->second.pins > 0) --found->second.pins;
+    }
+
+    // Фоновое чтение тайла; без фонового потока ничего не делает
+    void prefetch(TileFile<T>& file, uint64_t offset) {
+        if (offset == 0 || !_io.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            const Key key(&file, offset);
+            if (_entries.count(key)) return;
+            _queue.push_back(key);
+        }
+        _wake.notify_one();
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+};
+
+struct Options {
+    size_t memoryBytes = size_t(256) << 20;  // кэш тайлов и полоса C вместе
+    // Фоновое чтение тайлов следующего шага. Окупается, когда тайлы читаются с диска, а не
+    // из страничного кэша, и у фонового потока есть свободное ядро; иначе только добавляет
+    // переключения потоков и вытесняет тайлы раньше времени
+    bool prefetch = false;
+};
+
+struct Report {
+    double ms = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t minimalBytesRead = 0;  // каждый ненулевой тайл A и B прочитан ровно один раз
+    uint64_t hits = 0, misses = 0, prefetched = 0;
+    unsigned panelRows = 0, panelCols = 0;  // полоса C в тайлах
+    bool residentRows = false;              // полоса строк A закреплена на все столбцы B
+    size_t cacheTiles = 0;
+};
+
+// Полоса r x s: максимум r * s при r * s + 2 (r + s) <= budget - накопители C, тайлы
+// текущего шага k и столько же для фонового чтения следующего
+inline void choosePanel(size_t budget, unsigned maxRows, unsigned maxCols, unsigned& rows, unsigned& cols) {
+    rows = cols = 0;
+    size_t best = 0;
+    for (size_t r = 1; r <= maxRows && r * 1 + 2 * (r + 1) <= budget; ++r) {
+        const size_t s = std::min<size_t>(maxCols, (budget - 2 * r) / (r + 2));
+        if (s == 0) continue;
+        // при равной площади - ближе к квадрату (меньше повторных чтений A и B в сумме)
+        if (r * s > best || (r * s == best && std::max(r, s) < std::max<size_t>(rows, cols))) {
+            best = r * s;
+            rows = unsigned(r);
+            cols = unsigned(s);
+        }
+    }
+    if (best == 0) {
+        throw std::invalid_argument("Memory budget is too small for out-of-core multiplication.");
+    }
+}
+
+// Полоса C r x s при закреплённой полосе строк A r x depth: r * depth + r * s + 2 s <= budget.
+// r - наименьшее при наибольшем возможном числе строк полосы (тайл B читается rowPanels
+// раз), остаток бюджета - на s; false - не помещается даже одна строка
+inline bool chooseRowPanel(size_t budget, unsigned maxRows, unsigned maxCols, unsigned depth, unsigned& rows,
+                           unsigned& cols) {
+    rows = cols = 0;
+    if (size_t(depth) + 3 > budget) return false;
+    const size_t most = std::min<size_t>(maxRows, (budget - 2) / (size_t(depth) + 1));
+    const size_t panels = (maxRows + most - 1) / most;
+    const size_t r = (maxRows + panels - 1) / panels;
+    rows = unsigned(r);
+    cols = unsigned(std::min<size_t>(maxCols, (budget - r * depth) / (r + 2)));
+    return true;
+}
+
+// c = a * b для файлов MatrixBlock; результат - тоже файл MatrixBlock (нулевые тайлы не пишутся)
+template <typename T>
+Report multiply(const std::string& aFile, const std::string& bFile, const std::string& cFile,
+                const Options& options = Options()) {
+    const auto start = std::chrono::steady_clock::now();
+    TileFile<T> a(aFile);
+    TileFile<T> b(bFile);
+    if (a.getBlockCols() != b.getBlockRows() || a.getBlockSize() != b.getBlockSize()) {
+        throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+    }
+    const unsigned bs = a.getBlockSize();
+    const unsigned M = a.getBlockRows(), K = a.getBlockCols(), N = b.getBlockCols();
+    const size_t tileElems = a.tileElems();
+
+    Report report;
+    const size_t budget = options.memoryBytes / a.tileBytes();
+    choosePanel(budget, M, N, report.panelRows, report.panelCols);
+    // прогноз чтений тайлов для обеих схем, выбирается меньший
+    const uint64_t presentA = a.presentTiles(), presentB = b.presentTiles();
+    auto panels = [](unsigned total, unsigned size) { return uint64_t((total + size - 1) / size); };
+    unsigned rowsA = 0, colsA = 0;
+    if (chooseRowPanel(budget, M, N, K, rowsA, colsA)
+        && presentA + presentB * panels(M, rowsA)
+               < presentA * panels(N, report.panelCols) + presentB * panels(M, report.panelRows)) {
+        report.residentRows = true;
+        report.panelRows = rowsA;
+        report.panelCols = colsA;
+    }
+    const unsigned r = report.panelRows, s = report.panelCols;
+    report.cacheTiles = budget - size_t(r) * s;
+    report.minimalBytesRead = (presentA + presentB) * a.tileBytes();
+
+    TileFile<T> c(cFile, M, N, bs);
+    TileCache<T> cache(tileElems, report.cacheTiles, options.prefetch);
+    BlockArena<T> accumulators(tileElems);
+    accumulators.reserve(size_t(r) * s);
+
+    // Шаги (полоса, k): змейка по полосам, направление k чередуется; шаги, где столбец
+    // тайлов A или строка тайлов B в пределах полосы нулевые, пропускаются
+    struct Step {
+        unsigned row, col, k;  // первая строка и первый столбец полосы в тайлах
+    };
+    std::vector<Step> steps;
+    const unsigned rowPanels = (M + r - 1) / r, colPanels = (N + s - 1) / s;
+    size_t panelIndex = 0;
+    for (unsigned pi = 0; pi < rowPanels; ++pi) {
+        for (unsigned pj = 0; pj < colPanels; ++pj, ++panelIndex) {
+            const unsigned row = pi * r, col = (pi % 2 == 0 ? pj : colPanels - 1 - pj) * s;
+            for (unsigned kk = 0; kk < K; ++kk) {
+                const unsigned k = panelIndex % 2 == 0 ? kk : K - 1 - kk;
+                bool anyA = false, anyB = false;
+                for (unsigned i = row; i < std::min(M, row + r); ++i) anyA = anyA || a.offset(i, k) != 0;
+                for (unsigned j = col; j < std::min(N, col + s); ++j) anyB = anyB || b.offset(k, j) != 0;
+                if (anyA && anyB) steps.push_back(Step{row, col, k});
+            }
+            if (steps.empty() || steps.back().row != row || steps.back().col != col) {
+                steps.push_back(Step{row, col, K});  // полоса без вкладов: k == K
+            }
+        }
+    }
+
+    auto prefetchStep = [&](const Step& step) {
+        if (step.k == K) return;
+        for (unsigned i = step.row; i < std::min(M, step.row + r); ++i) cache.prefetch(a, a.offset(i, step.k));
+        for (unsigned j = step.col; j < std::min(N, step.col + s); ++j) cache.prefetch(b, b.offset(step.k, j));
+    };
+
+    // полоса строк A закрепляется в начале полосы строк C и освобождается в её конце
+    auto pinRows = [&](unsigned row, bool pin) {
+        for (unsigned i = row; i < std::min(M, row + r); ++i) {
+            for (unsigned k = 0; k < K; ++k) {
+                if (pin) cache.acquire(a, a.offset(i, k));
+                else cache.release(a, a.offset(i, k));
+            }
+        }
+    };
+
+    std::vector<T*> panel(size_t(r) * s, nullptr);
+    std::vector<char> touched(size_t(r) * s, 0);
+    std::vector<const T*> tilesA(r), tilesB(s);
+    for (size_t t = 0; t < steps.size(); ++t) {
+        const Step& step = steps[t];
+        const unsigned rows = std::min(r, M - step.row), cols = std::min(s, N - step.col);
+        if (report.residentRows && (t == 0 || steps[t - 1].row != step.row)) {
+            if (t > 0) pinRows(steps[t - 1].row, false);
+            pinRows(step.row, true);
+        }
+        if (t == 0 || steps[t - 1].row != step.row || steps[t - 1].col != step.col) {
+            for (size_t e = 0; e < panel.size(); ++e) {
+                if (panel[e] == nullptr) panel[e] = accumulators.allocate();
+                else std::fill(panel[e], panel[e] + tileElems, T(0));
+                touched[e] = 0;
+            }
+        }
+        if (step.k < K) {
+            // тайлы шага закрепляются до фонового чтения следующего, чтобы оно их не вытеснило
+            for (unsigned i = 0; i < rows; ++i) tilesA[i] = cache.acquire(a, a.offset(step.row + i, step.k));
+            for (unsigned j = 0; j < cols; ++j) tilesB[j] = cache.acquire(b, b.offset(step.k, step.col + j));
+            if (t + 1 < steps.size()) prefetchStep(steps[t + 1]);
+            ThreadPool::global().parallelFor(size_t(rows) * cols, [&](size_t index) {
+                const size_t i = index / cols, j = index % cols;
+                if (tilesA[i] == nullptr || tilesB[j] == nullptr) return;
+                gemm_kernel::multiplySequential(tilesA[i], bs, tilesB[j], bs, panel[i * s + j], bs, bs, bs, bs, true);
+                touched[i * s + j] = 1;
+            });
+            for (unsigned i = 0; i < rows; ++i) cache.release(a, a.offset(step.row + i, step.k));
+            for (unsigned j = 0; j < cols; ++j) cache.release(b, b.offset(step.k, step.col + j));
+        }
+        // полоса закончена - её ненулевые тайлы записываются в c
+        if (t + 1 == steps.size() || steps[t + 1].row != step.row || steps[t + 1].col != step.col) {
+            for (unsigned i = 0; i < rows; ++i)
+                for (unsigned j = 0; j < cols; ++j)
+                    if (touched[i * s + j]) c.write(step.row + i, step.col + j, panel[i * s + j]);
+        }
+    }
+    if (report.residentRows && !steps.empty()) pinRows(steps.back().row, false);
+    c.finish();
+    for (T* tile : panel) {
+        if (tile != nullptr) accumulators.release(tile);
+    }
+
+    const typename TileCache<T>::Stats stats = cache.stats();
+    report.bytesRead = a.bytesRead() + b.bytesRead();
+    report.bytesWritten = c.bytesWritten();
+    report.hits = stats.hits;
+    report.misses = stats.misses;
+    report.prefetched = stats.prefetched;
+    report.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+} // namespace out_of_core
@@ -1,15 +1,35 @@
+#pragma once
+
 #include "Matrix.h"
+#include "TransposeKernel.cpp"
+#include "MatrixBinaryFormat.cpp"
+#include "MatrixTextIO.cpp"
+#include "GemmKernel.cpp"
+#include "StrassenWinograd.cpp"
+#include "Factorization.cpp"
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 #include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
 
 template <typename T = double>
 class MatrixDense : public Matrix<T> {
 private:
     unsigned _m, _n;
     T* data;
+    std::shared_ptr<void> _storage; // внешнее хранилище (отображённый файл); если задано, data принадлежит ему
+
+    void releaseData() {
+        if (!_storage) {
+            delete[] data;
+        }
+        _storage.reset();
+        data = nullptr;
+    }
 
 public:
     MatrixDense(unsigned m, unsigned n) : _m(m), _n(n) {
@@ -21,6 +41,14 @@ public:
             data[i] = 0; //Инициализация нулями
     }
 
+    // Матрица поверх чужой памяти без копирования; storage удерживает её владельца
+    MatrixDense(unsigned m, unsigned n, T* external, std::shared_ptr<void> storage)
+        : _m(m), _n(n), data(external), _storage(std::move(storage)) {
+        if (m == 0 || n == 0) {
+            throw std::invalid_argument("Matrix dimensions must be positive.");
+        }
+    }
+
     MatrixDense(const MatrixDense& other) : _m(other._m), _n(other._n) {
       data = new T[_m * _n];
       for(size_t i = 0; i < _m*_n; ++i){
@@ -71,7 +99,7 @@ public:
 
     MatrixDense& operator=(const MatrixDense& other) {
       if (this == &other) return *this;
-      delete[] data;
+      releaseData();
       _m = other._m;
       _n = other._n;
       data = new T[_m*_n];
@@ -93,16 +121,107 @@ public:
         }
 
         MatrixDense<T>* result = new MatrixDense<T>(_m, otherDense->_n);
-        for(size_t i = 0; i < _m; ++i) {
-            for(size_t j = 0; j < otherDense->_n; ++j){
-                T sum = 0;
-                for(size_t k = 0; k < _n; ++k){
-                    sum += (*this)(i, k) * (*otherDense)(k, j);
-                }
-            (*result)(i, j) = sum;
-            }   
+        gemm_kernel::multiply(data, _n, otherDense->data, otherDense->_n, result->data, otherDense->_n,
+                              _m, otherDense->_n, _n, false);
+
+        return result;
+    }
+
+    // Целочисленное произведение в типе накопления (int8/int16 -> int32, int32 -> int64):
+    // в отличие от operator*, результат не приводится обратно к T и не переполняется
+    MatrixDense<gemm_integer::AccumulatorT<T>>* multiplyWide(const MatrixDense<T>& other) const {
+        static_assert(std::is_integral<T>::value, "Wide multiplication is intended for integer matrices.");
+        if(_n != other._m) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+        }
+        auto* result = new MatrixDense<gemm_integer::AccumulatorT<T>>(_m, other._n);
+        gemm_integer::multiply(data, _n, other.data, other._n, result->getData(), other._n, _m, other._n, _n, false);
+        return result;
+    }
+
+    // Быстрое умножение квадратных матриц по Штрассену-Винограду (O(n^2.81)).
+    // Ниже strassen::params().crossover работает обычное блочное ядро.
+    MatrixDense<T>* multiplyStrassen(const MatrixDense<T>& other) const {
+        static_assert(std::is_floating_point<T>::value, "Strassen multiplication is intended for float/double matrices.");
+        if(_m != _n || other._m != other._n || _n != other._m) {
+            throw std::invalid_argument("Strassen multiplication requires square matrices of equal size.");
         }
 
+        MatrixDense<T>* result = new MatrixDense<T>(_m, _n);
+        strassen::multiply(data, other.data, result->data, _n);
+        return result;
+    }
+
+    // LU-разложение с частичным выбором главного элемента: P A = L U. В результате под диагональю
+    // лежит L (единичная диагональ не хранится), на диагонали и выше - U; pivots[i] - строка,
+    // поменянная с i-й на шаге i. Блочный алгоритм factorization::luFactor.
+    MatrixDense<T>* luDecomposition(std::vector<unsigned>& pivots) const {
+        static_assert(std::is_floating_point<T>::value, "LU decomposition is intended for float/double matrices.");
+        if(_m != _n) {
+            throw std::invalid_argument("LU decomposition requires a square matrix.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(*this);
+        pivots.assign(_n, 0);
+        if (!factorization::luFactor(result->data, _n, _n, pivots.data())) {
+            delete result;
+            throw std::runtime_error("Matrix is singular.");
+        }
+        return result;
+    }
+
+    // Разложение Холецкого A = L L^T симметричной положительно определённой матрицы.
+    // Читается нижний треугольник; в результате L, выше диагонали нули.
+    MatrixDense<T>* choleskyDecomposition() const {
+        static_assert(std::is_floating_point<T>::value, "Cholesky decomposition is intended for float/double matrices.");
+        if(_m != _n) {
+            throw std::invalid_argument("Cholesky decomposition requires a square matrix.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(*this);
+        if (!factorization::choleskyFactor(result->data, _n, _n)) {
+            delete result;
+            throw std::runtime_error("Matrix is not positive definite.");
+        }
+        for (size_t i = 0; i < _n; ++i) {
+            std::fill(result->data + i * _n + i + 1, result->data + (i + 1) * _n, T(0));
+        }
+        return result;
+    }
+
+    // Решение A X = B по результату luDecomposition (вызывается у разложения).
+    // b - n x nrhs по строкам, решение записывается на его место.
+    void luSolveInPlace(const std::vector<unsigned>& pivots, T* b, size_t nrhs) const {
+        if(_m != _n || pivots.size() != _n) {
+            throw std::invalid_argument("LU factors and pivots do not match.");
+        }
+        factorization::applyPivots(b, nrhs, _n, nrhs, pivots.data());
+        factorization::solveLower(data, _n, _n, b, nrhs, nrhs, true);
+        factorization::solveUpper(data, _n, _n, b, nrhs, nrhs);
+    }
+
+    MatrixDense<T>* luSolve(const std::vector<unsigned>& pivots, const MatrixDense<T>& b) const {
+        if(b._m != _m) {
+            throw std::invalid_argument("Right-hand side does not match the factorization.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(b);
+        luSolveInPlace(pivots, result->data, b._n);
+        return result;
+    }
+
+    // Решение A X = B по результату choleskyDecomposition: L Y = B, затем L^T X = Y
+    void choleskySolveInPlace(T* b, size_t nrhs) const {
+        if(_m != _n) {
+            throw std::invalid_argument("Cholesky factor must be square.");
+        }
+        factorization::solveLower(data, _n, _n, b, nrhs, nrhs, false);
+        factorization::solveLowerTransposed(data, _n, _n, b, nrhs, nrhs);
+    }
+
+    MatrixDense<T>* choleskySolve(const MatrixDense<T>& b) const {
+        if(b._m != _m) {
+            throw std::invalid_argument("Right-hand side does not match the factorization.");
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(b);
+        choleskySolveInPlace(result->data, b._n);
         return result;
     }
 
@@ -130,16 +249,24 @@ public:
     
     Matrix<T>* transpose() const override{
         MatrixDense<T>* result = new MatrixDense<T>(_n, _m);
-        for(size_t i = 0; i < _m; ++i){
-            for(size_t j = 0; j < _n; ++j){
-                (*result)(j, i) = (*this)(i, j);
-            }
+        transpose_kernel::transpose(data, result->data, _m, _n);
+        return result;
+    }
+
+    // Произведение this * other^T без материализации other^T: блочное ядро GEMM упаковывает
+    // панели other^T прямо из строк other
+    MatrixDense<T>* multiplyTransposed(const MatrixDense<T>& other) const {
+        if(_n != other._n) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
         }
-    return result;
+
+        MatrixDense<T>* result = new MatrixDense<T>(_m, other._m);
+        gemm_kernel::multiplyTransposed(data, _n, other.data, other._n, result->data, other._m, _m, other._m, _n, false);
+        return result;
     }
 
     ~MatrixDense() override {
-        delete[] data;
+        releaseData();
     }
 
     T& operator()(unsigned i, unsigned j) override {
@@ -164,6 +291,15 @@ public:
         return _n;
     }
 
+    // Прямой доступ к непрерывному хранилищу (строки подряд) для вычислительных ядер
+    T* getData() {
+        return data;
+    }
+
+    const T* getData() const {
+        return data;
+    }
+
 //Операции и другие методы (см. ниже)...
     void importFromFile(const std::string& filename) override{
         std::ifstream file(filename);
@@ -182,7 +318,7 @@ public:
         if (file.fail() || m == 0 || n == 0) {
             throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
         }
-        delete[] data;
+        releaseData();
         _m = m;
         _n = n;
         data = new T[_m * _n];
@@ -217,6 +353,84 @@ public:
         file.close();
     }
 
+    // Параллельный разбор текстового формата importFromFile через mmap и std::from_chars
+    void parallelImportFromFile(const std::string& filename, size_t numThreads) {
+        MappedFile mapped(filename);
+        const char* end = mapped.data() + mapped.size();
+        unsigned dims[2];
+        const char* payload = matrix_text::parseHeader(mapped.data(), end, "MatrixDense", dims, 2, filename);
+        const size_t count = size_t(dims[0]) * dims[1];
+
+        auto chunks = matrix_text::scan(payload, end, numThreads);
+        for (const auto& chunk : chunks) {
+            if (!chunk.tags.empty()) {
+                throw std::runtime_error("Error reading matrix data from file: " + filename);
+            }
+        }
+        if (matrix_text::totalNumbers(chunks) < count) {
+            throw std::runtime_error("Error reading matrix data from file: " + filename);
+        }
+
+        T* buffer = new T[count];
+        try {
+            matrix_text::parse<T>(chunks, filename, [buffer, count](size_t index, T value) {
+                if (index < count) buffer[index] = value;
+            });
+        } catch (...) {
+            delete[] buffer;
+            throw;
+        }
+        releaseData();
+        _m = dims[0];
+        _n = dims[1];
+        data = buffer;
+    }
+
+    // Параллельная запись в текстовом формате exportToFile, строки форматируются std::to_chars
+    void parallelExportToFile(const std::string& filename, size_t numThreads) const {
+        std::string header = "MatrixDense\n" + std::to_string(_m) + " " + std::to_string(_n) + "\n";
+        matrix_text::writeParallel(filename, header, _m, numThreads, [this](size_t begin, size_t end, std::string& out) {
+            out.reserve((end - begin) * _n * 12);
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t j = 0; j < _n; ++j) {
+                    matrix_text::appendValue(out, data[i * _n + j]);
+                }
+                out.push_back('\n');
+            }
+        });
+    }
+
+    // Бинарный формат: заголовок и данные одной записью, без преобразования в текст
+    void exportToBinaryFile(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+
+        MatrixFileHeader header = matrix_binary::makeHeader<T>(MatrixFileType::Dense, _m, _n);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        matrix_binary::padTo(file, sizeof(header), header.dataOffset);
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * _m * _n));
+        if (!file) {
+            throw std::runtime_error("Error writing matrix data to file: " + filename);
+        }
+    }
+
+    // Открывает бинарный файл через mmap: данные не разбираются и не копируются
+    void importFromBinaryFile(const std::string& filename) {
+        auto mapped = std::make_shared<MappedFile>(filename);
+        const MatrixFileHeader& header = matrix_binary::readHeader<T>(*mapped, MatrixFileType::Dense, filename);
+        // rows, cols <= UINT_MAX (checkHeader), так что rows * cols помещается в 64 бита
+        if (!matrix_binary::fitsInFile(header.dataOffset, header.rows * header.cols, sizeof(T), mapped->size())) {
+            throw std::runtime_error("Error reading matrix data from file: " + filename);
+        }
+        releaseData();
+        _m = static_cast<unsigned>(header.rows);
+        _n = static_cast<unsigned>(header.cols);
+        data = reinterpret_cast<T*>(mapped->data() + header.dataOffset);
+        _storage = mapped;
+    }
+
     void print() const override{
         for (unsigned i = 0; i < _m; ++i) {
             for (unsigned j = 0; j < _n; ++j) {
@@ -1,9 +1,14 @@
+#pragma once
+
 #include "Matrix.h"
+#include "MatrixBinaryFormat.cpp"
+#include "MatrixTextIO.cpp"
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 #include <iomanip>
+#include <memory>
 
 
 
@@ -12,6 +17,15 @@ class MatrixDiagonal : public Matrix<T> {
 private:
     unsigned _size; // Размер матрицы (количество строк/столбцов)
     T* data;      // Массив для хранения диагональных элементов
+    std::shared_ptr<void> _storage; // внешнее хранилище (отображённый файл); если задано, data принадлежит ему
+
+    void releaseData() {
+        if (!_storage) {
+            delete[] data;
+        }
+        _storage.reset();
+        data = nullptr;
+    }
 
 public:
     MatrixDiagonal(unsigned size) : _size(size) {
@@ -32,7 +46,7 @@ public:
 
     MatrixDiagonal& operator=(const MatrixDiagonal& other) {
       if (this == &other) return *this;
-      delete[] data;
+      releaseData();
       _size = other._size;
       data = new T[_size];
        for(size_t i = 0; i < _size; ++i){
@@ -42,7 +56,7 @@ public:
     }
 
     ~MatrixDiagonal() override {
-        delete[] data;
+        releaseData();
     }
 
     T& operator()(unsigned i, unsigned j) override {
@@ -69,6 +83,19 @@ public:
         }
     }
 
+    unsigned getSize() const {
+        return _size;
+    }
+
+    // Диагональ подряд, для вычислительных ядер
+    T* getData() {
+        return data;
+    }
+
+    const T* getData() const {
+        return data;
+    }
+
     Matrix<T>* operator+(const Matrix<T>& other) const override{
         const MatrixDiagonal<T>* otherDiagonal = dynamic_cast<const MatrixDiagonal<T>*>(&other);
         if (!otherDiagonal) {
@@ -151,7 +178,7 @@ public:
         if (file.fail() || size == 0) {
             throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
         }
-        delete[] data;
+        releaseData();
         _size = size;
         data = new T[_size];
 
@@ -179,6 +206,78 @@ public:
 
         file.close();
     }
+    // Параллельный разбор текстового формата importFromFile через mmap и std::from_chars
+    void parallelImportFromFile(const std::string& filename, size_t numThreads) {
+        MappedFile mapped(filename);
+        const char* end = mapped.data() + mapped.size();
+        unsigned size;
+        const char* payload = matrix_text::parseHeader(mapped.data(), end, "MatrixDiagonal", &size, 1, filename);
+
+        auto chunks = matrix_text::scan(payload, end, numThreads);
+        for (const auto& chunk : chunks) {
+            if (!chunk.tags.empty()) {
+                throw std::runtime_error("Error reading matrix data from file: " + filename);
+            }
+        }
+        if (matrix_text::totalNumbers(chunks) < size) {
+            throw std::runtime_error("Error reading matrix data from file: " + filename);
+        }
+
+        T* buffer = new T[size];
+        try {
+            matrix_text::parse<T>(chunks, filename, [buffer, size](size_t index, T value) {
+                if (index < size) buffer[index] = value;
+            });
+        } catch (...) {
+            delete[] buffer;
+            throw;
+        }
+        releaseData();
+        _size = size;
+        data = buffer;
+    }
+
+    // Параллельная запись в текстовом формате exportToFile (диагональ одной строкой)
+    void parallelExportToFile(const std::string& filename, size_t numThreads) const {
+        std::string header = "MatrixDiagonal\n" + std::to_string(_size) + "\n";
+        matrix_text::writeParallel(filename, header, _size, numThreads, [this](size_t begin, size_t end, std::string& out) {
+            out.reserve((end - begin) * 12 + 1);
+            for (size_t i = begin; i < end; ++i) {
+                matrix_text::appendValue(out, data[i]);
+            }
+            if (end == _size) out.push_back('\n');
+        });
+    }
+
+    // Бинарный формат: хранится только диагональ
+    void exportToBinaryFile(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+
+        MatrixFileHeader header = matrix_binary::makeHeader<T>(MatrixFileType::Diagonal, _size, _size);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        matrix_binary::padTo(file, sizeof(header), header.dataOffset);
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * _size));
+        if (!file) {
+            throw std::runtime_error("Error writing matrix data to file: " + filename);
+        }
+    }
+
+    // Открывает бинарный файл через mmap без копирования
+    void importFromBinaryFile(const std::string& filename) {
+        auto mapped = std::make_shared<MappedFile>(filename);
+        const MatrixFileHeader& header = matrix_binary::readHeader<T>(*mapped, MatrixFileType::Diagonal, filename);
+        if (header.rows != header.cols || !matrix_binary::fitsInFile(header.dataOffset, header.rows, sizeof(T), mapped->size())) {
+            throw std::runtime_error("Error reading matrix data from file: " + filename);
+        }
+        releaseData();
+        _size = static_cast<unsigned>(header.rows);
+        data = reinterpret_cast<T*>(mapped->data() + header.dataOffset);
+        _storage = mapped;
+    }
+
     void print() const override{
         for (unsigned i = 0; i < _size; ++i) {
             for (unsigned j = 0; j < _size; ++j) {
@@ -0,0 +1,583 @@
+#pragma once
+
+#include "Matrix.h"
+#include "MatrixDense.cpp"
+#include "MatrixDiagonal.cpp"
+#include "MatrixBlock.cpp"
+#include "GemmKernel.cpp"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Отложенные вычисления: lazy::ref(...) и операторы * + - (и elementWise) только строят
+// граф выражения, а evaluate() считает его целиком.
+// - Цепочки умножений упорядочиваются динамическим программированием по размерам и типам
+//   множителей (плотная, диагональная, блочная с долей ненулевых блоков).
+// - Сложение, вычитание и поэлементное умножение над плотным произведением выполняются в
+//   эпилоге GEMM, пока полоса строк результата ещё в кэше.
+// - Общие подвыражения считаются один раз, промежуточные матрицы удаляются сразу после
+//   последнего использования.
+// Листья хранятся по ссылке и должны жить до вызова evaluate().
+namespace lazy {
+
+enum class Kind { Dense, Diagonal, Block };
+
+enum class Op { Leaf, Multiply, Add, Subtract, ElementWise };
+
+template <typename T>
+struct Node {
+    Op op = Op::Leaf;
+    const Matrix<T>* leaf = nullptr;
+    std::shared_ptr<Node> left, right;
+    unsigned rows = 0, cols = 0;
+    Kind kind = Kind::Dense;
+    double density = 1;      // доля ненулевых блоков блочной матрицы
+    unsigned blockSize = 0;
+};
+
+template <typename T>
+class Expression {
+private:
+    std::shared_ptr<Node<T>> _node;
+
+public:
+    explicit Expression(std::shared_ptr<Node<T>> node) : _node(std::move(node)) {}
+
+    const std::shared_ptr<Node<T>>& node() const { return _node; }
+    unsigned getRows() const { return _node->rows; }
+    unsigned getCols() const { return _node->cols; }
+};
+
+namespace detail {
+
+template <typename T>
+size_t presentBlocks(const MatrixBlock<T>& block) {
+    size_t present = 0;
+    for (unsigned i = 0; i < block.getBlockRows(); ++i)
+        for (unsigned j = 0; j < block.getBlockCols(); ++j)
+            present += block.getBlock(i, j) != nullptr;
+    return present;
+}
+
+template <typename T>
+size_t bytesOf(const Matrix<T>* matrix) {
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(matrix)) return sizeof(T) * dense->getRows() * dense->getCols();
+    if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(matrix)) return sizeof(T) * diagonal->getSize();
+    if (auto block = dynamic_cast<const MatrixBlock<T>*>(matrix))
+        return presentBlocks(*block) * sizeof(T) * block->getBlockSize() * block->getBlockSize();
+    return 0;
+}
+
+template <typename T>
+Matrix<T>* copyOf(const Matrix<T>& matrix) {
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(&matrix)) return new MatrixDense<T>(*dense);
+    if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(&matrix)) return new MatrixDiagonal<T>(*diagonal);
+    return new MatrixBlock<T>(dynamic_cast<const MatrixBlock<T>&>(matrix));
+}
+
+// Структура произведения: с блочной - блочная, иначе с плотной - плотная
+inline Kind productKind(Kind a, Kind b) {
+    if (a == Kind::Block || b == Kind::Block) return Kind::Block;
+    if (a == Kind::Dense || b == Kind::Dense) return Kind::Dense;
+    return Kind::Diagonal;
+}
+
+// Доля ненулевых блоков произведения: блок C_ij ненулевой, если есть хотя бы одна пара
+// ненулевых A_ik, B_kj (оценка в предположении независимости)
+inline double productDensity(Kind a, double da, Kind b, double db, double kBlocks) {
+    if (a == Kind::Block && b == Kind::Block) return std::min(1.0, da * db * kBlocks);
+    return a == Kind::Block ? da : db;
+}
+
+template <typename T>
+std::shared_ptr<Node<T>> makeNode(Op op, const Expression<T>& a, const Expression<T>& b) {
+    const Node<T>& x = *a.node();
+    const Node<T>& y = *b.node();
+    auto node = std::make_shared<Node<T>>();
+    node->op = op;
+    node->left = a.node();
+    node->right = b.node();
+    node->blockSize = std::max(x.blockSize, y.blockSize);
+    if (op == Op::Multiply) {
+        // блочная умножается только на блочную или диагональную
+        if ((x.kind == Kind::Block && y.kind == Kind::Dense) || (x.kind == Kind::Dense && y.kind == Kind::Block)) {
+            throw std::invalid_argument("Incompatible matrix types for multiplication.");
+        }
+        if (x.cols != y.rows) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+        }
+        node->rows = x.rows;
+        node->cols = y.cols;
+        node->kind = productKind(x.kind, y.kind);
+        const double kBlocks = std::max(1.0, double(x.cols) / std::max(1u, node->blockSize));
+        if (node->kind == Kind::Block) node->density = productDensity(x.kind, x.density, y.kind, y.density, kBlocks);
+        return node;
+    }
+    // поэлементные операции с блочной - только с блочной, как и у немедленных операторов
+    if ((x.kind == Kind::Block) != (y.kind == Kind::Block)) {
+        throw std::invalid_argument("Incompatible matrix types for element-wise operation.");
+    }
+    if (x.rows != y.rows || x.cols != y.cols) {
+        throw std::invalid_argument("Matrix dimensions must be equal.");
+    }
+    node->rows = x.rows;
+    node->cols = x.cols;
+    if (x.kind == Kind::Block) {
+        node->kind = Kind::Block;
+        // сумма и разность хранят объединение ненулевых блоков, поэлементное произведение - пересечение
+        node->density = op == Op::ElementWise ? std::min(x.density, y.density) : std::min(1.0, x.density + y.density);
+    } else if (op == Op::ElementWise) {
+        // поэлементное произведение с диагональной остаётся диагональным
+        node->kind = x.kind == Kind::Diagonal || y.kind == Kind::Diagonal ? Kind::Diagonal : Kind::Dense;
+    } else {
+        node->kind = x.kind == Kind::Diagonal && y.kind == Kind::Diagonal ? Kind::Diagonal : Kind::Dense;
+    }
+    return node;
+}
+
+} // namespace detail
+
+// Лист выражения: MatrixDense, MatrixDiagonal или MatrixBlock
+template <typename T>
+Expression<T> ref(const Matrix<T>& matrix) {
+    auto node = std::make_shared<Node<T>>();
+    node->leaf = &matrix;
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(&matrix)) {
+        node->kind = Kind::Dense;
+        node->rows = dense->getRows();
+        node->cols = dense->getCols();
+    } else if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(&matrix)) {
+        node->kind = Kind::Diagonal;
+        node->rows = node->cols = diagonal->getSize();
+    } else if (auto block = dynamic_cast<const MatrixBlock<T>*>(&matrix)) {
+        node->kind = Kind::Block;
+        node->rows = block->getRows();
+        node->cols = block->getCols();
+        node->blockSize = block->getBlockSize();
+        node->density = double(detail::presentBlocks(*block)) / (double(block->getBlockRows()) * block->getBlockCols());
+    } else {
+        throw std::invalid_argument("Unsupported matrix type for lazy evaluation.");
+    }
+    return Expression<T>(node);
+}
+
+template <typename T>
+Expression<T> operator*(const Expression<T>& a, const Expression<T>& b) {
+    return Expression<T>(detail::makeNode(Op::Multiply, a, b));
+}
+
+template <typename T>
+Expression<T> operator+(const Expression<T>& a, const Expression<T>& b) {
+    return Expression<T>(detail::makeNode(Op::Add, a, b));
+}
+
+template <typename T>
+Expression<T> operator-(const Expression<T>& a, const Expression<T>& b) {
+    return Expression<T>(detail::makeNode(Op::Subtract, a, b));
+}
+
+template <typename T>
+Expression<T> elementWise(const Expression<T>& a, const Expression<T>& b) {
+    return Expression<T>(detail::makeNode(Op::ElementWise, a, b));
+}
+
+struct Stats {
+    size_t multiplications = 0;   // попарных умножений матриц
+    double multiplyCost = 0;      // оценка умножений-сложений при выбранном порядке
+    size_t fusedOperations = 0;   // поэлементных операций, выполненных в эпилоге GEMM
+    size_t intermediates = 0;     // созданных матриц, включая результат
+    size_t peakBytes = 0;         // максимум одновременно живых созданных матриц
+    std::string plan;             // порядок вычисления: M0, M1 ... - листья, T0 ... - общие подвыражения
+};
+
+template <typename T>
+class Evaluator {
+private:
+    using NodePtr = std::shared_ptr<Node<T>>;
+
+    // Шаг эпилога над плотным произведением C
+    struct Step {
+        Op op;
+        NodePtr operand;
+        bool reversed;   // operand - C вместо C - operand
+    };
+
+    struct Value {
+        Matrix<T>* matrix = nullptr;
+        bool owned = false;
+        size_t bytes = 0;
+        size_t uses = 0;   // потребители, ещё не прочитавшие значение
+    };
+
+    std::map<const Node<T>*, size_t> _uses;
+    std::map<const Node<T>*, Value> _values;
+    std::map<const Node<T>*, std::string> _names;
+    std::vector<std::string> _plans;
+    size_t _leaves = 0, _shared = 0;
+    size_t _liveBytes = 0;
+    Stats _stats;
+
+    void countUses(const NodePtr& node) {
+        if (_uses[node.get()]++ > 0) return;  // потомки общего узла учитываются один раз
+        if (node->op == Op::Leaf) {
+            _names[node.get()] = "M" + std::to_string(_leaves++);
+            return;
+        }
+        countUses(node->left);
+        countUses(node->right);
+    }
+
+    std::string nameOf(const NodePtr& node) {
+        auto found = _names.find(node.get());
+        if (found != _names.end()) return found->second;
+        return _names[node.get()] = "T" + std::to_string(_shared++);
+    }
+
+    void track(Matrix<T>* matrix, size_t& bytes) {
+        bytes = detail::bytesOf(matrix);
+        _liveBytes += bytes;
+        _stats.peakBytes = std::max(_stats.peakBytes, _liveBytes);
+        ++_stats.intermediates;
+    }
+
+    void dispose(Matrix<T>* matrix, size_t bytes) {
+        delete matrix;
+        _liveBytes -= bytes;
+    }
+
+    // Значение узла; вычисляется при первом обращении
+    const Matrix<T>& acquire(const NodePtr& node) {
+        auto found = _values.find(node.get());
+        if (found == _values.end()) {
+            Value value;
+            value.uses = _uses[node.get()];
+            if (node->op == Op::Leaf) {
+                value.matrix = const_cast<Matrix<T>*>(node->leaf);
+            } else {
+                value.matrix = compute(node, value.bytes);
+                value.owned = true;
+            }
+            found = _values.emplace(node.get(), value).first;
+        }
+        return *found->second.matrix;
+    }
+
+    // Потребитель прочитал значение; после последнего созданная матрица удаляется
+    void release(const NodePtr& node) {
+        auto found = _values.find(node.get());
+        if (found == _values.end()) return;
+        if (--found->second.uses == 0) {
+            if (found->second.owned) dispose(found->second.matrix, found->second.bytes);
+            _values.erase(found);
+        }
+    }
+
+    // ---- Порядок цепочки умножений ----
+
+    // Множители цепочки: вложенные произведения без других потребителей раскрываются
+    void flatten(const NodePtr& node, std::vector<NodePtr>& factors, bool root) {
+        if (node->op == Op::Multiply && (root || _uses[node.get()] == 1)) {
+            flatten(node->left, factors, false);
+            flatten(node->right, factors, false);
+        } else {
+            factors.push_back(node);
+        }
+    }
+
+    struct Shape {
+        double rows, cols;
+        Kind kind;
+        double density;
+    };
+
+    // Оценка числа умножений-сложений для a * b
+    static double pairCost(const Shape& a, const Shape& b) {
+        if (a.kind == Kind::Diagonal && b.kind == Kind::Diagonal) return a.rows;
+        if (a.kind == Kind::Diagonal) return b.rows * b.cols * b.density;
+        if (b.kind == Kind::Diagonal) return a.rows * a.cols * a.density;
+        return a.rows * a.cols * b.cols * a.density * b.density;
+    }
+
+    // Динамическое программирование по отрезкам цепочки: split[i][j] - где делится [i, j]
+    static std::vector<std::vector<size_t>> chainOrder(const std::vector<Shape>& factors, unsigned blockSize, double& best) {
+        const size_t n = factors.size();
+        std::vector<std::vector<double>> cost(n, std::vector<double>(n, 0));
+        std::vector<std::vector<Shape>> shape(n, std::vector<Shape>(n));
+        std::vector<std::vector<size_t>> split(n, std::vector<size_t>(n, 0));
+        for (size_t i = 0; i < n; ++i) shape[i][i] = factors[i];
+        for (size_t length = 2; length <= n; ++length) {
+            for (size_t i = 0; i + length <= n; ++i) {
+                const size_t j = i + length - 1;
+                cost[i][j] = std::numeric_limits<double>::max();
+                for (size_t k = i; k < j; ++k) {
+                    const double c = cost[i][k] + cost[k + 1][j] + pairCost(shape[i][k], shape[k + 1][j]);
+                    if (c < cost[i][j]) {
+                        cost[i][j] = c;
+                        split[i][j] = k;
+                    }
+                }
+                const Shape& a = shape[i][split[i][j]];
+                const Shape& b = shape[split[i][j] + 1][j];
+                const Kind kind = detail::productKind(a.kind, b.kind);
+                const double kBlocks = std::max(1.0, a.cols / std::max(1u, blockSize));
+                shape[i][j] = Shape{a.rows, b.cols, kind,
+                                    kind == Kind::Block ? detail::productDensity(a.kind, a.density, b.kind, b.density, kBlocks) : 1.0};
+            }
+        }
+        best = cost[0][n - 1];
+        return split;
+    }
+
+    std::string planOf(const std::vector<NodePtr>& factors, const std::vector<std::vector<size_t>>& split, size_t i, size_t j) {
+        if (i == j) return nameOf(factors[i]);
+        return "(" + planOf(factors, split, i, split[i][j]) + " * " + planOf(factors, split, split[i][j] + 1, j) + ")";
+    }
+
+    // Произведение отрезка [i, j]; steps - эпилог самого внешнего умножения
+    Matrix<T>* multiplyRange(const std::vector<NodePtr>& factors, const std::vector<std::vector<size_t>>& split,
+                             size_t i, size_t j, const std::vector<Step>* steps, size_t& bytes) {
+        if (i == j) {
+            bytes = 0;
+            return const_cast<Matrix<T>*>(&acquire(factors[i]));
+        }
+        const size_t k = split[i][j];
+        size_t leftBytes = 0, rightBytes = 0;
+        Matrix<T>* left = multiplyRange(factors, split, i, k, nullptr, leftBytes);
+        Matrix<T>* right = multiplyRange(factors, split, k + 1, j, nullptr, rightBytes);
+        Matrix<T>* product = multiplyPair(*left, *right, steps);
+        track(product, bytes);
+        // операнды больше не нужны: промежуточные удаляются, множители освобождаются
+        if (i == k) release(factors[i]); else dispose(left, leftBytes);
+        if (k + 1 == j) release(factors[j]); else dispose(right, rightBytes);
+        return product;
+    }
+
+    // ---- Умножение пары по фактическим типам ----
+
+    Matrix<T>* multiplyPair(const Matrix<T>& a, const Matrix<T>& b, const std::vector<Step>* steps) {
+        ++_stats.multiplications;
+        auto denseA = dynamic_cast<const MatrixDense<T>*>(&a);
+        auto denseB = dynamic_cast<const MatrixDense<T>*>(&b);
+        auto diagonalA = dynamic_cast<const MatrixDiagonal<T>*>(&a);
+        auto diagonalB = dynamic_cast<const MatrixDiagonal<T>*>(&b);
+        if (denseA && denseB) {
+            const size_t m = denseA->getRows(), k = denseA->getCols(), n = denseB->getCols();
+            MatrixDense<T>* result = new MatrixDense<T>(denseA->getRows(), denseB->getCols());
+            T* c = result->getData();
+            if (steps == nullptr) {
+                gemm_kernel::multiply(denseA->getData(), k, denseB->getData(), n, c, n, m, n, k, false);
+                return result;
+            }
+            // операнды эпилога уже вычислены: задачи пула только читают их
+            std::vector<std::pair<const Step*, const Matrix<T>*>> epilogue;
+            for (const Step& step : *steps) epilogue.push_back({&step, &acquire(step.operand)});
+            gemm_kernel::multiply(denseA->getData(), k, denseB->getData(), n, c, n, m, n, k, false,
+                                  [&](size_t rowBegin, size_t rowEnd) {
+                                      for (const auto& entry : epilogue)
+                                          applyStep(*entry.first, *entry.second, c, n, rowBegin, rowEnd);
+                                  });
+            _stats.fusedOperations += steps->size();
+            return result;
+        }
+        Matrix<T>* result;
+        if (diagonalA && denseB) {
+            result = scaleDense(*denseB, diagonalA->getData(), true);
+        } else if (denseA && diagonalB) {
+            result = scaleDense(*denseA, diagonalB->getData(), false);
+        } else if (diagonalA && !diagonalB) {
+            result = scaleBlock(dynamic_cast<const MatrixBlock<T>&>(b), diagonalA->getData(), true);
+        } else if (diagonalB && !diagonalA) {
+            result = scaleBlock(dynamic_cast<const MatrixBlock<T>&>(a), diagonalB->getData(), false);
+        } else {
+            result = a * b;  // диагональная * диагональная, блочная * блочная
+        }
+        if (steps != nullptr) {
+            // эпилог есть только у плотного GEMM; здесь - отдельными проходами
+            for (const Step& step : *steps) {
+                const Matrix<T>& operand = acquire(step.operand);
+                Matrix<T>* next = step.reversed ? combine(step.op, operand, *result) : combine(step.op, *result, operand);
+                delete result;
+                result = next;
+            }
+        }
+        return result;
+    }
+
+    // D * X (по строкам) или X * D (по столбцам)
+    static MatrixDense<T>* scaleDense(const MatrixDense<T>& x, const T* d, bool rows) {
+        const size_t m = x.getRows(), n = x.getCols();
+        MatrixDense<T>* result = new MatrixDense<T>(x.getRows(), x.getCols());
+        const T* source = x.getData();
+        T* target = result->getData();
+        for (size_t i = 0; i < m; ++i)
+            for (size_t j = 0; j < n; ++j)
+                target[i * n + j] = source[i * n + j] * (rows ? d[i] : d[j]);
+        return result;
+    }
+
+    // То же для блочной: масштабируются только ненулевые блоки
+    static MatrixBlock<T>* scaleBlock(const MatrixBlock<T>& x, const T* d, bool rows) {
+        const unsigned bs = x.getBlockSize();
+        MatrixBlock<T>* result = new MatrixBlock<T>(x.getBlockRows(), x.getBlockCols(), bs);
+        for (unsigned bi = 0; bi < x.getBlockRows(); ++bi) {
+            for (unsigned bj = 0; bj < x.getBlockCols(); ++bj) {
+                const MatrixDense<T>* tile = x.getBlock(bi, bj);
+                if (tile == nullptr) continue;
+                result->setBlock(bi, bj, scaleDense(*tile, d + size_t(rows ? bi : bj) * bs, rows));
+            }
+        }
+        return result;
+    }
+
+    // ---- Поэлементные операции ----
+
+    // Шаг эпилога над строками [rowBegin, rowEnd) плотного C с n столбцами
+    static void applyStep(const Step& step, const Matrix<T>& operand, T* c, size_t n, size_t rowBegin, size_t rowEnd) {
+        if (auto dense = dynamic_cast<const MatrixDense<T>*>(&operand)) {
+            const T* d = dense->getData();
+            for (size_t i = rowBegin; i < rowEnd; ++i) {
+                T* row = c + i * n;
+                const T* other = d + i * n;
+                if (step.op == Op::Add) {
+                    for (size_t j = 0; j < n; ++j) row[j] += other[j];
+                } else if (step.op == Op::ElementWise) {
+                    for (size_t j = 0; j < n; ++j) row[j] *= other[j];
+                } else if (step.reversed) {
+                    for (size_t j = 0; j < n; ++j) row[j] = other[j] - row[j];
+                } else {
+                    for (size_t j = 0; j < n; ++j) row[j] -= other[j];
+                }
+            }
+            return;
+        }
+        // диагональная: только сложение и вычитание
+        const T* d = static_cast<const MatrixDiagonal<T>&>(operand).getData();
+        for (size_t i = rowBegin; i < rowEnd; ++i) {
+            T* row = c + i * n;
+            if (step.op == Op::Add) {
+                row[i] += d[i];
+            } else if (step.reversed) {
+                for (size_t j = 0; j < n; ++j) row[j] = -row[j];
+                row[i] += d[i];
+            } else {
+                row[i] -= d[i];
+            }
+        }
+    }
+
+    // Сумма, разность или поэлементное произведение двух готовых значений
+    static Matrix<T>* combine(Op op, const Matrix<T>& a, const Matrix<T>& b) {
+        auto denseA = dynamic_cast<const MatrixDense<T>*>(&a);
+        auto denseB = dynamic_cast<const MatrixDense<T>*>(&b);
+        auto diagonalA = dynamic_cast<const MatrixDiagonal<T>*>(&a);
+        auto diagonalB = dynamic_cast<const MatrixDiagonal<T>*>(&b);
+        if (!(denseA && diagonalB) && !(diagonalA && denseB)) {
+            // одинаковые типы - немедленные операторы
+            return op == Op::Add ? a + b : op == Op::Subtract ? a - b : a.elementWiseMultiplication(b);
+        }
+        const MatrixDense<T>& dense = denseA ? *denseA : *denseB;
+        const MatrixDiagonal<T>& diagonal = diagonalA ? *diagonalA : *diagonalB;
+        const size_t size = diagonal.getSize();
+        if (op == Op::ElementWise) {
+            MatrixDiagonal<T>* result = new MatrixDiagonal<T>(diagonal.getSize());
+            for (size_t i = 0; i < size; ++i) result->getData()[i] = diagonal.getData()[i] * dense.getData()[i * size + i];
+            return result;
+        }
+        MatrixDense<T>* result = new MatrixDense<T>(dense);
+        applyStep(Step{op, nullptr, diagonalA != nullptr}, diagonal, result->getData(), size, 0, size);
+        return result;
+    }
+
+    // Цепочка поэлементных операций над плотным произведением, которая сливается с GEMM:
+    // возвращает это произведение (или nullptr) и шаги в порядке применения
+    NodePtr fusableProduct(const NodePtr& node, std::vector<Step>& steps, bool root) {
+        if (node->kind != Kind::Dense || (!root && _uses[node.get()] != 1)) return nullptr;
+        if (node->op == Op::Multiply) return node;
+        if (node->op == Op::Leaf) return nullptr;
+        for (int side = 0; side < 2; ++side) {
+            const NodePtr& child = side == 0 ? node->left : node->right;
+            const NodePtr& other = side == 0 ? node->right : node->left;
+            if (other->kind == Kind::Diagonal && node->op == Op::ElementWise) continue;
+            const size_t depth = steps.size();
+            NodePtr product = fusableProduct(child, steps, false);
+            if (product) {
+                steps.push_back(Step{node->op, other, side == 1});
+                return product;
+            }
+            steps.resize(depth);
+        }
+        return nullptr;
+    }
+
+    // ---- Вычисление узла ----
+
+    Matrix<T>* compute(const NodePtr& node, size_t& bytes) {
+        std::vector<Step> steps;
+        const NodePtr product = node->op == Op::Multiply ? node : fusableProduct(node, steps, true);
+        if (!product) {
+            const Matrix<T>& a = acquire(node->left);
+            const Matrix<T>& b = acquire(node->right);
+            Matrix<T>* result = combine(node->op, a, b);
+            track(result, bytes);
+            release(node->left);
+            release(node->right);
+            return result;
+        }
+        std::vector<NodePtr> factors;
+        flatten(product, factors, true);
+        std::vector<Shape> shapes;
+        for (const NodePtr& factor : factors) {
+            shapes.push_back(Shape{double(factor->rows), double(factor->cols), factor->kind, factor->density});
+        }
+        double cost = 0;
+        const auto split = chainOrder(shapes, product->blockSize, cost);
+        _stats.multiplyCost += cost;
+
+        std::string plan = planOf(factors, split, 0, factors.size() - 1);
+        for (const Step& step : steps) {
+            const char* sign = step.op == Op::Add ? " + " : step.op == Op::Subtract ? " - " : " .* ";
+            plan = step.reversed ? "(" + nameOf(step.operand) + sign + plan + ")" : "(" + plan + sign + nameOf(step.operand) + ")";
+        }
+        if (_names.count(node.get())) plan = _names[node.get()] + " = " + plan;
+
+        // множители и операнды эпилога считаются до умножений, их планы идут раньше
+        for (const NodePtr& factor : factors) acquire(factor);
+        for (const Step& step : steps) acquire(step.operand);
+        _plans.push_back(plan);
+        Matrix<T>* result = multiplyRange(factors, split, 0, factors.size() - 1, steps.empty() ? nullptr : &steps, bytes);
+        for (const Step& step : steps) release(step.operand);
+        return result;
+    }
+
+public:
+    Matrix<T>* run(const Expression<T>& expression, Stats* stats) {
+        const NodePtr& root = expression.node();
+        countUses(root);
+        Matrix<T>* result;
+        if (root->op == Op::Leaf) {
+            result = detail::copyOf(*root->leaf);
+        } else {
+            result = const_cast<Matrix<T>*>(&acquire(root));
+            _values.erase(root.get());  // результат передаётся вызывающему
+        }
+        if (stats != nullptr) {
+            _stats.plan.clear();
+            for (size_t i = 0; i < _plans.size(); ++i) _stats.plan += (i > 0 ? "; " : "") + _plans[i];
+            *stats = _stats;
+        }
+        return result;
+    }
+};
+
+// Вычисляет выражение; результат - новая матрица, как у немедленных операторов
+template <typename T>
+Matrix<T>* evaluate(const Expression<T>& expression, Stats* stats = nullptr) {
+    Evaluator<T> evaluator;
+    return evaluator.run(expression, stats);
+}
+
+} // namespace lazy
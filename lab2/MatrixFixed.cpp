@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+// Выравнивание тайла: по кэш-линии, если тайл занимает целое число линий,
+// иначе естественное (чтобы массив тайлов 3x3 не раздувался до 128 байт на тайл)
+template <typename T, unsigned R, unsigned C>
+struct FixedAlignment {
+    static constexpr size_t bytes = sizeof(T) * R * C;
+    static constexpr size_t value = bytes % 64 == 0 ? 64 : alignof(T);
+};
+
+// Маленькая матрица R x C с размерами, известными при компиляции. Данные лежат внутри
+// объекта (без выделения памяти), доступ без проверки границ и без виртуальных вызовов,
+// а все циклы имеют постоянные границы - компилятор разворачивает и векторизует их.
+// Это значение, а не наследник Matrix<T>: указатель на vtable удвоил бы тайл 2x2 и
+// помешал хранить тайлы сплошным массивом. Основное применение - тайлы MatrixBlock<T, B>.
+template <typename T, unsigned R, unsigned C>
+class alignas(FixedAlignment<T, R, C>::value) MatrixFixed {
+    static_assert(R > 0 && C > 0, "MatrixFixed dimensions must be positive.");
+
+private:
+    T _data[R * C];
+
+public:
+    MatrixFixed() : _data{} {}
+
+    static constexpr unsigned getRows() { return R; }
+    static constexpr unsigned getCols() { return C; }
+
+    T& operator()(unsigned i, unsigned j) { return _data[i * C + j]; }
+    const T& operator()(unsigned i, unsigned j) const { return _data[i * C + j]; }
+
+    // С проверкой границ, как operator() у остальных матриц
+    T& at(unsigned i, unsigned j) {
+        if (i >= R || j >= C) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        return _data[i * C + j];
+    }
+
+    const T& at(unsigned i, unsigned j) const {
+        if (i >= R || j >= C) {
+            throw std::out_of_range("Matrix index out of bounds.");
+        }
+        return _data[i * C + j];
+    }
+
+    T* getData() { return _data; }
+    const T* getData() const { return _data; }
+
+    MatrixFixed& operator+=(const MatrixFixed& other) {
+        for (unsigned e = 0; e < R * C; ++e) _data[e] += other._data[e];
+        return *this;
+    }
+
+    MatrixFixed& operator-=(const MatrixFixed& other) {
+        for (unsigned e = 0; e < R * C; ++e) _data[e] -= other._data[e];
+        return *this;
+    }
+
+    MatrixFixed operator+(const MatrixFixed& other) const {
+        MatrixFixed result(*this);
+        result += other;
+        return result;
+    }
+
+    MatrixFixed operator-(const MatrixFixed& other) const {
+        MatrixFixed result(*this);
+        result -= other;
+        return result;
+    }
+
+    MatrixFixed elementWiseMultiplication(const MatrixFixed& other) const {
+        MatrixFixed result;
+        for (unsigned e = 0; e < R * C; ++e) result._data[e] = _data[e] * other._data[e];
+        return result;
+    }
+
+    // this += a * b. Строка результата накапливается в локальном массиве постоянной длины,
+    // который компилятор держит в векторных регистрах на всём проходе по k
+    template <unsigned K>
+    void multiplyAccumulate(const MatrixFixed<T, R, K>& a, const MatrixFixed<T, K, C>& b) {
+        for (unsigned i = 0; i < R; ++i) {
+            T row[C];
+            for (unsigned j = 0; j < C; ++j) row[j] = _data[i * C + j];
+            for (unsigned k = 0; k < K; ++k) {
+                const T aik = a(i, k);
+                for (unsigned j = 0; j < C; ++j) row[j] += aik * b(k, j);
+            }
+            for (unsigned j = 0; j < C; ++j) _data[i * C + j] = row[j];
+        }
+    }
+
+    template <unsigned K>
+    MatrixFixed<T, R, K> operator*(const MatrixFixed<T, C, K>& other) const {
+        MatrixFixed<T, R, K> result;
+        result.multiplyAccumulate(*this, other);
+        return result;
+    }
+
+    MatrixFixed<T, C, R> transpose() const {
+        MatrixFixed<T, C, R> result;
+        for (unsigned i = 0; i < R; ++i)
+            for (unsigned j = 0; j < C; ++j)
+                result(j, i) = _data[i * C + j];
+        return result;
+    }
+
+    void print() const {
+        for (unsigned i = 0; i < R; ++i) {
+            for (unsigned j = 0; j < C; ++j) {
+                std::cout << std::setw(10) << _data[i * C + j] << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "MappedFile.cpp"
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <vector>
+
+// Параллельный разбор и запись текстового формата матриц ("MatrixDense\nm n\n...").
+// Файл отображается в память и делится на куски по пробельным символам: числа не зависят
+// от разбиения на строки (диагональ пишется одной строкой). Проход 1 считает числа (и теги
+// блоков MatrixBlock) в каждом куске, префиксная сумма даёт каждому куску его первый
+// глобальный индекс, проход 2 разбирает числа std::from_chars прямо на место.
+namespace matrix_text {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Тег блока MatrixBlock ("nullptr" / "MatrixDense") и число чисел перед ним в куске
+struct Tag {
+    size_t numbersBefore;
+    bool dense;
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    size_t numbers = 0;
+    size_t firstIndex = 0; // глобальный индекс первого числа куска
+    std::vector<Tag> tags;
+};
+
+inline std::string_view nextToken(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    const char* tokenBegin = p;
+    while (p < end && !isSpace(*p)) ++p;
+    return std::string_view(tokenBegin, static_cast<size_t>(p - tokenBegin));
+}
+
+inline bool isTag(std::string_view token) {
+    return token == "nullptr" || token == "MatrixDense";
+}
+
+// Запускает f(chunk) для каждого куска в отдельной задаче
+template <typename Func>
+void forEachChunk(std::vector<Chunk>& chunks, Func f) {
+    std::vector<std::future<void>> futures;
+    for (auto& chunk : chunks) {
+        futures.push_back(std::async(std::launch::async, [&f, &chunk]() { f(chunk); }));
+    }
+    for (auto& future : futures) {
+        future.get(); // пробрасывает исключения разбора
+    }
+}
+
+// Разбор заголовка: тип и count беззнаковых размеров; возвращает начало данных
+inline const char* parseHeader(const char* p, const char* end, std::string_view expectedType,
+                               unsigned* dims, size_t count, const std::string& filename) {
+    if (nextToken(p, end) != expectedType) {
+        throw std::runtime_error("Invalid matrix type in file: " + filename);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::string_view token = nextToken(p, end);
+        auto result = std::from_chars(token.data(), token.data() + token.size(), dims[i]);
+        if (token.empty() || result.ec != std::errc() || result.ptr != token.data() + token.size() || dims[i] == 0) {
+            throw std::runtime_error("Invalid matrix dimensions in file: " + filename);
+        }
+    }
+    return p;
+}
+
+// Делит данные на куски по границам токенов и параллельно считает в них числа и теги
+inline std::vector<Chunk> scan(const char* begin, const char* end, size_t numThreads) {
+    if (numThreads == 0) numThreads = 1;
+    std::vector<Chunk> chunks;
+    const size_t length = static_cast<size_t>(end - begin);
+    const char* start = begin;
+    for (size_t t = 1; t <= numThreads && start < end; ++t) {
+        const char* stop = (t == numThreads) ? end : begin + length * t / numThreads;
+        if (stop < start) stop = start;
+        // конец куска - первый пробельный символ не раньше stop, токен не разрезается
+        while (stop < end && !isSpace(*stop)) ++stop;
+        Chunk chunk;
+        chunk.begin = start;
+        chunk.end = stop;
+        chunks.push_back(chunk);
+        start = stop;
+    }
+
+    forEachChunk(chunks, [](Chunk& chunk) {
+        const char* p = chunk.begin;
+        while (true) {
+            std::string_view token = nextToken(p, chunk.end);
+            if (token.empty()) break;
+            if (isTag(token)) {
+                chunk.tags.push_back({chunk.numbers, token[0] == 'M'});
+            } else {
+                ++chunk.numbers;
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstIndex = total;
+        total += chunk.numbers;
+    }
+    return chunks;
+}
+
+inline size_t totalNumbers(const std::vector<Chunk>& chunks) {
+    return chunks.empty() ? 0 : chunks.back().firstIndex + chunks.back().numbers;
+}
+
+// Проход 2: sink(globalIndex, value) для каждого числа
+template <typename T, typename Sink>
+void parse(std::vector<Chunk>& chunks, const std::string& filename, Sink sink) {
+    forEachChunk(chunks, [&](Chunk& chunk) {
+        const char* p = chunk.begin;
+        size_t index = chunk.firstIndex;
+        while (true) {
+            std::string_view token = nextToken(p, chunk.end);
+            if (token.empty()) break;
+            if (isTag(token)) continue;
+            T value;
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+                throw std::runtime_error("Error reading matrix data from file: " + filename);
+            }
+            sink(index++, value);
+        }
+    });
+}
+
+// Кратчайшее представление, которое читается обратно без потери точности
+template <typename T>
+inline void appendValue(std::string& out, T value) {
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+    out.push_back(' ');
+}
+
+// Параллельная запись: items делятся на numThreads диапазонов, каждый форматируется
+// format(begin, end, out) в свой буфер; буферы пишутся по порядку одним write каждый
+template <typename Format>
+void writeParallel(const std::string& filename, const std::string& header, size_t items, size_t numThreads, Format format) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    if (numThreads == 0) numThreads = 1;
+    if (numThreads > items) numThreads = items > 0 ? items : 1;
+
+    std::vector<std::future<std::string>> futures;
+    for (size_t t = 0; t < numThreads; ++t) {
+        size_t begin = items * t / numThreads;
+        size_t end = items * (t + 1) / numThreads;
+        futures.push_back(std::async(std::launch::async, [&format, begin, end]() {
+            std::string out;
+            format(begin, end, out);
+            return out;
+        }));
+    }
+
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (auto& future : futures) {
+        std::string out = future.get();
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    if (!file) {
+        throw std::runtime_error("Error writing matrix data to file: " + filename);
+    }
+}
+
+} // namespace matrix_text
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MatrixDense.cpp"
+#include "MatrixBlock.cpp"
+
+// Ленивое транспонирование: представление без копирования данных.
+// Хранит ссылку на исходную матрицу, поэтому не должно её переживать.
+template <typename M>
+class TransposeView {
+private:
+    const M& _base;
+
+public:
+    explicit TransposeView(const M& base) : _base(base) {}
+
+    const M& base() const { return _base; }
+
+    unsigned getRows() const { return _base.getCols(); }
+    unsigned getCols() const { return _base.getRows(); }
+
+    decltype(auto) operator()(unsigned i, unsigned j) const {
+        return _base(j, i);
+    }
+};
+
+template <typename M>
+TransposeView<M> transposed(const M& matrix) {
+    return TransposeView<M>(matrix);
+}
+
+// A * B^T: ядро получает B как есть и читает его строки вместо столбцов
+template <typename T>
+Matrix<T>* operator*(const MatrixDense<T>& a, const TransposeView<MatrixDense<T>>& b) {
+    return a.multiplyTransposed(b.base());
+}
+
+template <typename T>
+Matrix<T>* operator*(const MatrixBlock<T>& a, const TransposeView<MatrixBlock<T>>& b) {
+    return a.multiplyTransposed(b.base());
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include "MatrixDense.cpp"
+#include "MatrixDiagonal.cpp"
+#include "MatrixBlock.cpp"
+#include "MatrixBanded.cpp"
+#include "ThreadPool.cpp"
+#include "../lab3/Vector.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// Умножение матриц lab2 на векторы lab3: y = alpha * op(A) * x + beta * y.
+// Векторы читаются и пишутся напрямую через data_ptr(), без промежуточных копий.
+namespace matrix_vector {
+
+// Элементов матрицы на одну задачу пула; меньшие произведения считаются в вызывающем потоке
+const size_t ELEMENTS_PER_TASK = 1 << 16;
+const size_t TRANSPOSED_MIN_COLS = 512;
+
+// Скалярное произведение с четырьмя независимыми суммами: цикл векторизуется и без -ffast-math
+template <typename T>
+inline T dot(const T* a, const T* b, size_t n) {
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// y = alpha * x + y
+template <typename T>
+inline void axpy(T alpha, const T* x, T* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+// y = beta * y; при beta == 0 старое содержимое y не читается (оно может быть не инициализировано)
+template <typename T>
+inline void scale(T* y, size_t n, T beta) {
+    if (beta == T(0)) {
+        std::fill(y, y + n, T(0));
+    } else if (beta != T(1)) {
+        for (size_t i = 0; i < n; ++i) y[i] *= beta;
+    }
+}
+
+// Разбивает count единиц работы по unitCost элементов на задачи пула
+template <typename Func>
+void forRanges(size_t count, size_t unitCost, Func f) {
+    const size_t perTask = std::max<size_t>(1, ELEMENTS_PER_TASK / std::max<size_t>(unitCost, 1));
+    const size_t tasks = (count + perTask - 1) / perTask;
+    if (tasks <= 1) {
+        f(0, count);
+        return;
+    }
+    ThreadPool::global().parallelFor(tasks, [&](size_t t) {
+        f(t * perTask, std::min(count, (t + 1) * perTask));
+    });
+}
+
+template <typename T>
+void checkSizes(size_t rows, size_t cols, const Vector<T>& x, const Vector<T>& y, T beta) {
+    x.check_initialization();
+    if (beta != T(0)) y.check_initialization();
+    if (x.size() != cols || y.size() != rows) {
+        throw std::invalid_argument("Vector sizes do not match matrix dimensions.");
+    }
+}
+
+// ---- MatrixDense ----
+
+// Строки делятся между потоками, каждая строка - одно скалярное произведение
+template <typename T>
+void gemv(const MatrixDense<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t m = A.getRows(), n = A.getCols();
+    checkSizes(m, n, x, y, beta);
+    const T* a = A.getData();
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(m, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const T sum = alpha * dot(a + i * n, xd, n);
+            yd[i] = beta == T(0) ? sum : sum + beta * yd[i];
+        }
+    });
+    y.mark_initialized();
+}
+
+// y = alpha * A^T * x + beta * y: потоки делят столбцы (элементы y), каждый проходит
+// все строки A по своему непрерывному отрезку - без общих сумм и синхронизации
+template <typename T>
+void gemvTransposed(const MatrixDense<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t m = A.getRows(), n = A.getCols();
+    checkSizes(n, m, x, y, beta);
+    const T* a = A.getData();
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    // Отрезок не уже TRANSPOSED_MIN_COLS столбцов, чтобы чтение строк A шло длинными кусками
+    forRanges(n, std::min(m, ELEMENTS_PER_TASK / TRANSPOSED_MIN_COLS), [&](size_t begin, size_t end) {
+        const size_t width = end - begin;
+        T* yb = yd + begin;
+        scale(yb, width, beta);
+        size_t i = 0;
+        for (; i + 4 <= m; i += 4) {
+            const T x0 = alpha * xd[i], x1 = alpha * xd[i + 1], x2 = alpha * xd[i + 2], x3 = alpha * xd[i + 3];
+            const T* a0 = a + i * n + begin;
+            const T* a1 = a0 + n;
+            const T* a2 = a1 + n;
+            const T* a3 = a2 + n;
+            for (size_t j = 0; j < width; ++j) {
+                yb[j] += x0 * a0[j] + x1 * a1[j] + x2 * a2[j] + x3 * a3[j];
+            }
+        }
+        for (; i < m; ++i) {
+            axpy(alpha * xd[i], a + i * n + begin, yb, width);
+        }
+    });
+    y.mark_initialized();
+}
+
+// ---- MatrixDiagonal: поэлементное масштабирование за O(n) ----
+
+template <typename T>
+void gemv(const MatrixDiagonal<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t n = A.getSize();
+    checkSizes(n, n, x, y, beta);
+    const T* d = A.getData();
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(n, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const T value = alpha * d[i] * xd[i];
+            yd[i] = beta == T(0) ? value : value + beta * yd[i];
+        }
+    });
+    y.mark_initialized();
+}
+
+template <typename T>
+void gemvTransposed(const MatrixDiagonal<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    gemv(A, x, y, alpha, beta);
+}
+
+// ---- MatrixBlock: нулевые блоки пропускаются ----
+
+// Потоки делят блочные строки; каждая пишет только в свой отрезок y
+template <typename T>
+void gemv(const MatrixBlock<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t bs = A.getBlockSize();
+    const size_t blockRows = A.getBlockRows(), blockCols = A.getBlockCols();
+    checkSizes(A.getRows(), A.getCols(), x, y, beta);
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(blockRows, blockCols * bs * bs, [&](size_t begin, size_t end) {
+        for (size_t bi = begin; bi < end; ++bi) {
+            T* yi = yd + bi * bs;
+            scale(yi, bs, beta);
+            for (size_t bk = 0; bk < blockCols; ++bk) {
+                const MatrixDense<T>* block = A.getBlock(bi, bk);
+                if (block == nullptr) continue;
+                const T* b = block->getData();
+                const T* xk = xd + bk * bs;
+                for (size_t r = 0; r < bs; ++r) {
+                    yi[r] += alpha * dot(b + r * bs, xk, bs);
+                }
+            }
+        }
+    });
+    y.mark_initialized();
+}
+
+// Потоки делят блочные столбцы: y_j = sum_k B_kj^T x_k
+template <typename T>
+void gemvTransposed(const MatrixBlock<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t bs = A.getBlockSize();
+    const size_t blockRows = A.getBlockRows(), blockCols = A.getBlockCols();
+    checkSizes(A.getCols(), A.getRows(), x, y, beta);
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(blockCols, blockRows * bs * bs, [&](size_t begin, size_t end) {
+        for (size_t bj = begin; bj < end; ++bj) {
+            T* yj = yd + bj * bs;
+            scale(yj, bs, beta);
+            for (size_t bk = 0; bk < blockRows; ++bk) {
+                const MatrixDense<T>* block = A.getBlock(bk, bj);
+                if (block == nullptr) continue;
+                const T* b = block->getData();
+                const T* xk = xd + bk * bs;
+                for (size_t r = 0; r < bs; ++r) {
+                    axpy(alpha * xk[r], b + r * bs, yj, bs);
+                }
+            }
+        }
+    });
+    y.mark_initialized();
+}
+
+// ---- MatrixBanded: проходы по диагоналям, O(n * ширина ленты) ----
+
+template <typename T>
+void gemv(const MatrixBanded<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t n = A.getSize();
+    checkSizes(n, n, x, y, beta);
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(n, A.getLower() + A.getUpper() + 1, [&](size_t begin, size_t end) {
+        A.multiplyRows(xd, yd, begin, end, alpha, beta);
+    });
+    y.mark_initialized();
+}
+
+template <typename T>
+void gemvTransposed(const MatrixBanded<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    const size_t n = A.getSize();
+    checkSizes(n, n, x, y, beta);
+    const T* xd = x.data_ptr();
+    T* yd = y.data_ptr();
+    forRanges(n, A.getLower() + A.getUpper() + 1, [&](size_t begin, size_t end) {
+        A.multiplyRowsTransposed(xd, yd, begin, end, alpha, beta);
+    });
+    y.mark_initialized();
+}
+
+// ---- Любая Matrix<T>: выбор ядра по фактическому типу ----
+
+template <typename T>
+size_t rows(const Matrix<T>& A) {
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(&A)) return dense->getRows();
+    if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(&A)) return diagonal->getSize();
+    if (auto block = dynamic_cast<const MatrixBlock<T>*>(&A)) return block->getRows();
+    if (auto banded = dynamic_cast<const MatrixBanded<T>*>(&A)) return banded->getSize();
+    throw std::invalid_argument("Unsupported matrix type for matrix-vector product.");
+}
+
+template <typename T>
+void gemv(const Matrix<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(&A)) return gemv(*dense, x, y, alpha, beta);
+    if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(&A)) return gemv(*diagonal, x, y, alpha, beta);
+    if (auto block = dynamic_cast<const MatrixBlock<T>*>(&A)) return gemv(*block, x, y, alpha, beta);
+    if (auto banded = dynamic_cast<const MatrixBanded<T>*>(&A)) return gemv(*banded, x, y, alpha, beta);
+    throw std::invalid_argument("Unsupported matrix type for matrix-vector product.");
+}
+
+template <typename T>
+void gemvTransposed(const Matrix<T>& A, const Vector<T>& x, Vector<T>& y, T alpha = T(1), T beta = T(0)) {
+    if (auto dense = dynamic_cast<const MatrixDense<T>*>(&A)) return gemvTransposed(*dense, x, y, alpha, beta);
+    if (auto diagonal = dynamic_cast<const MatrixDiagonal<T>*>(&A)) return gemvTransposed(*diagonal, x, y, alpha, beta);
+    if (auto block = dynamic_cast<const MatrixBlock<T>*>(&A)) return gemvTransposed(*block, x, y, alpha, beta);
+    if (auto banded = dynamic_cast<const MatrixBanded<T>*>(&A)) return gemvTransposed(*banded, x, y, alpha, beta);
+    throw std::invalid_argument("Unsupported matrix type for matrix-vector product.");
+}
+
+// ---- Несколько правых частей: Y = A * [x1 .. xr] ----
+
+// Строка a умножается сразу на 4 вектора: каждый загруженный элемент a используется 4 раза
+template <typename T>
+inline void dot4(const T* a, const T* const* x, size_t offset, size_t n, T* out) {
+    const T* x0 = x[0] + offset;
+    const T* x1 = x[1] + offset;
+    const T* x2 = x[2] + offset;
+    const T* x3 = x[3] + offset;
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const T ai = a[i];
+        s0 += ai * x0[i];
+        s1 += ai * x1[i];
+        s2 += ai * x2[i];
+        s3 += ai * x3[i];
+    }
+    out[0] += s0;
+    out[1] += s1;
+    out[2] += s2;
+    out[3] += s3;
+}
+
+// y_r[row] += a . x_r[offset..offset+n) для всех r; правые части обрабатываются четвёрками
+template <typename T>
+inline void dotMany(const T* a, const std::vector<const T*>& xs, size_t offset, size_t n,
+                    const std::vector<T*>& ys, size_t row) {
+    const size_t count = xs.size();
+    size_t r = 0;
+    for (; r + 4 <= count; r += 4) {
+        T sums[4] = {0, 0, 0, 0};
+        dot4(a, xs.data() + r, offset, n, sums);
+        for (size_t q = 0; q < 4; ++q) ys[r + q][row] += sums[q];
+    }
+    for (; r < count; ++r) {
+        ys[r][row] += dot(a, xs[r] + offset, n);
+    }
+}
+
+template <typename T>
+std::vector<const T*> inputPointers(const std::vector<Vector<T>>& xs, size_t cols) {
+    std::vector<const T*> result;
+    for (const auto& x : xs) {
+        x.check_initialization();
+        if (x.size() != cols) {
+            throw std::invalid_argument("Vector sizes do not match matrix dimensions.");
+        }
+        result.push_back(x.data_ptr());
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<Vector<T>> zeroOutputs(size_t count, size_t rows, std::vector<T*>& pointers) {
+    std::vector<Vector<T>> ys;
+    ys.reserve(count);
+    for (size_t r = 0; r < count; ++r) {
+        ys.emplace_back(rows);
+        ys.back().initialize(T(0));
+        pointers.push_back(ys.back().data_ptr());
+    }
+    return ys;
+}
+
+template <typename T>
+std::vector<Vector<T>> gemvBatch(const MatrixDense<T>& A, const std::vector<Vector<T>>& xs) {
+    const size_t m = A.getRows(), n = A.getCols();
+    std::vector<const T*> in = inputPointers(xs, n);
+    std::vector<T*> out;
+    std::vector<Vector<T>> ys = zeroOutputs<T>(xs.size(), m, out);
+    const T* a = A.getData();
+    forRanges(m, n * std::max<size_t>(xs.size(), 1), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            dotMany(a + i * n, in, 0, n, out, i);
+        }
+    });
+    return ys;
+}
+
+template <typename T>
+std::vector<Vector<T>> gemvBatch(const MatrixDiagonal<T>& A, const std::vector<Vector<T>>& xs) {
+    const size_t n = A.getSize();
+    std::vector<const T*> in = inputPointers(xs, n);
+    std::vector<T*> out;
+    std::vector<Vector<T>> ys = zeroOutputs<T>(xs.size(), n, out);
+    const T* d = A.getData();
+    forRanges(n, std::max<size_t>(xs.size(), 1), [&](size_t begin, size_t end) {
+        for (size_t r = 0; r < in.size(); ++r) {
+            for (size_t i = begin; i < end; ++i) out[r][i] = d[i] * in[r][i];
+        }
+    });
+    return ys;
+}
+
+template <typename T>
+std::vector<Vector<T>> gemvBatch(const MatrixBlock<T>& A, const std::vector<Vector<T>>& xs) {
+    const size_t bs = A.getBlockSize();
+    const size_t blockRows = A.getBlockRows(), blockCols = A.getBlockCols();
+    std::vector<const T*> in = inputPointers(xs, A.getCols());
+    std::vector<T*> out;
+    std::vector<Vector<T>> ys = zeroOutputs<T>(xs.size(), A.getRows(), out);
+    forRanges(blockRows, blockCols * bs * bs * std::max<size_t>(xs.size(), 1), [&](size_t begin, size_t end) {
+        for (size_t bi = begin; bi < end; ++bi) {
+            for (size_t bk = 0; bk < blockCols; ++bk) {
+                const MatrixDense<T>* block = A.getBlock(bi, bk);
+                if (block == nullptr) continue;
+                const T* b = block->getData();
+                for (size_t r = 0; r < bs; ++r) {
+                    dotMany(b + r * bs, in, bk * bs, bs, out, bi * bs + r);
+                }
+            }
+        }
+    });
+    return ys;
+}
+
+// ---- Решение A x = b по готовому разложению (MatrixDense или MatrixBlock) ----
+
+template <typename Factor, typename T>
+Vector<T> luSolve(const Factor& lu, const std::vector<unsigned>& pivots, const Vector<T>& b) {
+    b.check_initialization();
+    if (b.size() != lu.getRows()) {
+        throw std::invalid_argument("Right-hand side does not match the factorization.");
+    }
+    Vector<T> x(b);
+    lu.luSolveInPlace(pivots, x.data_ptr(), 1);
+    return x;
+}
+
+template <typename Factor, typename T>
+Vector<T> choleskySolve(const Factor& l, const Vector<T>& b) {
+    b.check_initialization();
+    if (b.size() != l.getRows()) {
+        throw std::invalid_argument("Right-hand side does not match the factorization.");
+    }
+    Vector<T> x(b);
+    l.choleskySolveInPlace(x.data_ptr(), 1);
+    return x;
+}
+
+// ---- Трёхдиагональные системы: прогонка и параллельная циклическая редукция ----
+
+template <typename T>
+Vector<T> thomasSolve(const MatrixBanded<T>& A, const Vector<T>& b) {
+    b.check_initialization();
+    if (b.size() != A.getSize()) {
+        throw std::invalid_argument("Right-hand side does not match the matrix.");
+    }
+    Vector<T> x(b);
+    A.thomasSolveInPlace(x.data_ptr(), 1);
+    return x;
+}
+
+template <typename T>
+Vector<T> cyclicReductionSolve(const MatrixBanded<T>& A, const Vector<T>& b) {
+    b.check_initialization();
+    if (b.size() != A.getSize()) {
+        throw std::invalid_argument("Right-hand side does not match the matrix.");
+    }
+    Vector<T> x(b);
+    A.cyclicReductionSolveInPlace(x.data_ptr(), 1);
+    return x;
+}
+
+} // namespace matrix_vector
+
+// y = A * x как значение: результат перемещается, а не копируется
+template <typename T>
+Vector<T> operator*(const Matrix<T>& A, const Vector<T>& x) {
+    Vector<T> y(matrix_vector::rows(A));
+    matrix_vector::gemv(A, x, y);
+    return y;
+}
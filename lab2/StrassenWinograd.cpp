@@ -0,0 +1,137 @@
+#pragma once
+
+#include "GemmKernel.cpp"
+#include "ThreadPool.cpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Умножение квадратных матриц по схеме Штрассена-Винограда: 7 умножений и 15 сложений
+// половинного размера на уровень. Ниже crossover - блочное ядро gemm_kernel.
+namespace strassen {
+
+struct Params {
+    size_t crossover = 256;     // размер, ниже которого выгоднее блочное ядро
+    size_t blockCrossover = 2;  // то же для MatrixBlock, в блоках сетки
+    size_t parallelDepth = 2;   // на скольких верхних уровнях 7 произведений считаются параллельно
+};
+
+inline Params& params() {
+    static Params current;
+    return current;
+}
+
+// c = a + b, c = a - b для подматриц h x h с произвольными шагами строк
+template <typename T>
+void add(const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, size_t h) {
+    for (size_t i = 0; i < h; ++i)
+        for (size_t j = 0; j < h; ++j)
+            c[i * ldc + j] = a[i * lda + j] + b[i * ldb + j];
+}
+
+template <typename T>
+void sub(const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, size_t h) {
+    for (size_t i = 0; i < h; ++i)
+        for (size_t j = 0; j < h; ++j)
+            c[i * ldc + j] = a[i * lda + j] - b[i * ldb + j];
+}
+
+// C = A * B для n x n; n на каждом уровне выше crossover должно быть чётным
+template <typename T>
+void multiplyRecursive(const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc,
+                       size_t n, size_t crossover, size_t parallelDepth) {
+    if (n <= crossover || n % 2 != 0) {
+        gemm_kernel::multiply(A, lda, B, ldb, C, ldc, n, n, n, false);
+        return;
+    }
+    const size_t h = n / 2;
+    const size_t hh = h * h;
+    const T* A11 = A;
+    const T* A12 = A + h;
+    const T* A21 = A + h * lda;
+    const T* A22 = A21 + h;
+    const T* B11 = B;
+    const T* B12 = B + h;
+    const T* B21 = B + h * ldb;
+    const T* B22 = B21 + h;
+
+    // S1..S4, T1..T4, P1..P7 подряд в одном буфере
+    std::vector<T> buffer(15 * hh);
+    T* S[4];
+    T* Tm[4];
+    T* P[7];
+    for (size_t i = 0; i < 4; ++i) S[i] = buffer.data() + i * hh;
+    for (size_t i = 0; i < 4; ++i) Tm[i] = buffer.data() + (4 + i) * hh;
+    for (size_t i = 0; i < 7; ++i) P[i] = buffer.data() + (8 + i) * hh;
+
+    add(A21, lda, A22, lda, S[0], h, h);     // S1 = A21 + A22
+    sub(S[0], h, A11, lda, S[1], h, h);      // S2 = S1 - A11
+    sub(A11, lda, A21, lda, S[2], h, h);     // S3 = A11 - A21
+    sub(A12, lda, S[1], h, S[3], h, h);      // S4 = A12 - S2
+    sub(B12, ldb, B11, ldb, Tm[0], h, h);    // T1 = B12 - B11
+    sub(B22, ldb, Tm[0], h, Tm[1], h, h);    // T2 = B22 - T1
+    sub(B22, ldb, B12, ldb, Tm[2], h, h);    // T3 = B22 - B12
+    sub(Tm[1], h, B21, ldb, Tm[3], h, h);    // T4 = T2 - B21
+
+    struct Product { const T* a; size_t lda; const T* b; size_t ldb; };
+    const Product products[7] = {
+        {A11, lda, B11, ldb},     // P1
+        {A12, lda, B21, ldb},     // P2
+        {S[3], h, B22, ldb},      // P3
+        {A22, lda, Tm[3], h},     // P4
+        {S[0], h, Tm[0], h},      // P5
+        {S[1], h, Tm[1], h},      // P6
+        {S[2], h, Tm[2], h}       // P7
+    };
+    auto compute = [&](size_t i) {
+        multiplyRecursive(products[i].a, products[i].lda, products[i].b, products[i].ldb, P[i], h, h,
+                          crossover, parallelDepth > 0 ? parallelDepth - 1 : 0);
+    };
+    if (parallelDepth > 0) {
+        ThreadPool::global().parallelFor(7, compute);
+    } else {
+        for (size_t i = 0; i < 7; ++i) compute(i);
+    }
+
+    T* C11 = C;
+    T* C12 = C + h;
+    T* C21 = C + h * ldc;
+    T* C22 = C21 + h;
+    add(P[0], h, P[1], h, C11, ldc, h);      // C11 = P1 + P2
+    add(P[0], h, P[5], h, P[5], h, h);       // U2 = P1 + P6
+    add(P[5], h, P[6], h, P[6], h, h);       // U3 = U2 + P7
+    add(P[5], h, P[4], h, P[5], h, h);       // U4 = U2 + P5
+    add(P[5], h, P[2], h, C12, ldc, h);      // C12 = U4 + P3
+    sub(P[6], h, P[3], h, C21, ldc, h);      // C21 = U3 - P4
+    add(P[6], h, P[4], h, C22, ldc, h);      // C22 = U3 + P5
+}
+
+// Размер с дополнением нулями: n' = m * 2^levels >= n, где m <= crossover
+inline size_t paddedSize(size_t n, size_t crossover) {
+    size_t levels = 0;
+    while ((n >> levels) > crossover) ++levels;
+    const size_t step = size_t(1) << levels;
+    return (n + step - 1) / step * step;
+}
+
+// C = A * B для n x n со сплошным хранением; при необходимости дополняет нулями до paddedSize
+template <typename T>
+void multiply(const T* A, const T* B, T* C, size_t n) {
+    const Params p = params();
+    const size_t padded = paddedSize(n, p.crossover);
+    if (padded == n) {
+        multiplyRecursive(A, n, B, n, C, n, n, p.crossover, p.parallelDepth);
+        return;
+    }
+    std::vector<T> a(padded * padded, T(0)), b(padded * padded, T(0)), c(padded * padded);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(A + i * n, A + (i + 1) * n, a.data() + i * padded);
+        std::copy(B + i * n, B + (i + 1) * n, b.data() + i * padded);
+    }
+    multiplyRecursive(a.data(), padded, b.data(), padded, c.data(), padded, padded, p.crossover, p.parallelDepth);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(c.data() + i * padded, c.data() + i * padded + n, C + i * n);
+    }
+}
+
+} // namespace strassen
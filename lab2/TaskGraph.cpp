@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ThreadPool.cpp"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Граф задач с зависимостями по данным. Задачи добавляются в порядке последовательного
+// алгоритма вместе со списками читаемых и записываемых ресурсов (например, номеров тайлов),
+// а зависимости - чтение после записи, запись после чтения и после записи - выводятся сами.
+// run() раздаёт готовые задачи потокам общего пула, среди готовых первой идёт задача
+// с меньшим priority: так задачи критического пути могут обгонять остальные.
+class TaskGraph {
+private:
+    static constexpr size_t NONE = size_t(-1);
+
+    struct Task {
+        std::function<void()> run;
+        size_t priority;
+        size_t waiting = 0;              // сколько предшественников ещё не выполнено
+        std::vector<size_t> successors;
+    };
+
+    struct Resource {
+        size_t lastWriter = NONE;
+        std::vector<size_t> readers;     // читатели после последней записи
+    };
+
+    std::vector<Task> _tasks;
+    std::unordered_map<size_t, Resource> _resources;
+
+    void addEdge(size_t from, size_t to) {
+        if (from == NONE || from == to) return;
+        _tasks[from].successors.push_back(to);
+        ++_tasks[to].waiting;
+    }
+
+public:
+    // Ресурс, который задача и читает, и пишет, достаточно указать в writes
+    size_t add(std::function<void()> run, const std::vector<size_t>& reads, const std::vector<size_t>& writes,
+               size_t priority = 0) {
+        const size_t id = _tasks.size();
+        _tasks.emplace_back();
+        _tasks.back().run = std::move(run);
+        _tasks.back().priority = priority;
+        for (size_t r : reads) {
+            addEdge(_resources[r].lastWriter, id);
+        }
+        for (size_t w : writes) {
+            Resource& resource = _resources[w];
+            addEdge(resource.lastWriter, id);
+            for (size_t reader : resource.readers) addEdge(reader, id);
+            resource.readers.clear();
+            resource.lastWriter = id;
+        }
+        for (size_t r : reads) {
+            Resource& resource = _resources[r];
+            if (resource.lastWriter != id) resource.readers.push_back(id);
+        }
+        return id;
+    }
+
+    size_t size() const { return _tasks.size(); }
+
+    // Выполняет все задачи. Исключения из задач не допускаются (как и в parallelFor).
+    void run(ThreadPool& pool = ThreadPool::global()) {
+        using Entry = std::pair<size_t, size_t>; // (priority, id)
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> ready;
+        for (size_t id = 0; id < _tasks.size(); ++id) {
+            if (_tasks[id].waiting == 0) ready.push({_tasks[id].priority, id});
+        }
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t completed = 0;
+        const size_t total = _tasks.size();
+
+        // Каждый исполнитель берёт готовые задачи, пока граф не выполнен целиком;
+        // исполнителей на один больше, чем потоков пула, - вызывающий поток тоже работает
+        pool.parallelFor(pool.size() + 1, [&](size_t) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&]() { return completed == total || !ready.empty(); });
+                if (completed == total) return;
+                const size_t id = ready.top().second;
+                ready.pop();
+                lock.unlock();
+                _tasks[id].run();
+                lock.lock();
+                ++completed;
+                for (size_t next : _tasks[id].successors) {
+                    if (--_tasks[next].waiting == 0) ready.push({_tasks[next].priority, next});
+                }
+                changed.notify_all();
+            }
+        });
+        _tasks.clear();
+        _resources.clear();
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "HardwareInfo.cpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Пул потоков с общей очередью задач. Основной способ использования - parallelFor:
+// индексы раздаются атомарным счётчиком, вызывающий поток работает наравне с пулом,
+// поэтому вложенные parallelFor (например, из рекурсивных алгоритмов) не блокируются.
+class ThreadPool {
+private:
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop = false;
+
+    // Общее состояние одного parallelFor; живёт, пока его держит хотя бы один помощник в очереди
+    struct ForState {
+        std::atomic<size_t> next{0};
+        size_t count = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t active = 0;
+        bool closed = false; // после закрытия новые помощники сразу выходят
+    };
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                if (_stop && _tasks.empty()) return;
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t numThreads) {
+        if (numThreads == 0) numThreads = 1;
+        for (size_t i = 0; i < numThreads; ++i) {
+            _workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _condition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    size_t size() const { return _workers.size(); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push(std::move(task));
+        }
+        _condition.notify_one();
+    }
+
+    // Выполняет f(index) для всех index из [0, count). Исключения из f не допускаются.
+    template <typename Func>
+    void parallelFor(size_t count, Func f) {
+        if (count == 0) return;
+        auto state = std::make_shared<ForState>();
+        state->count = count;
+        auto run = [state, &f]() {
+            for (size_t index = state->next++; index < state->count; index = state->next++) {
+                f(index);
+            }
+        };
+
+        size_t helpers = std::min(size(), count - 1);
+        for (size_t i = 0; i < helpers; ++i) {
+            submit([state, run]() {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->closed) return;
+                    ++state->active;
+                }
+                run();
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (--state->active == 0) state->finished.notify_all();
+            });
+        }
+
+        run();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->closed = true;
+        state->finished.wait(lock, [&state]() { return state->active == 0; });
+    }
+
+    // Общий пул на все процессоры, доступные процессу (с учётом маски привязки и cpuset)
+    static ThreadPool& global() {
+        static ThreadPool pool(hardware_info::local().usableCpus);
+        return pool;
+    }
+};
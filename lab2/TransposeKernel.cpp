@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Ядро транспонирования для непрерывных массивов с произвольным шагом строки (ld).
+// Рекурсивно делим большую сторону пополам, пока блок не поместится в L1,
+// затем транспонируем тайл микроблоками 4x4 в регистрах.
+namespace transpose_kernel {
+
+const size_t TILE = 32; // 32x32 double = 8 КБ, с запасом помещается в L1
+
+// Скалярный вариант для любых типов и хвостов тайла
+template <typename T>
+inline void transposeScalar(const T* src, size_t ldSrc, T* dst, size_t ldDst, size_t rows, size_t cols) {
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            dst[j * ldDst + i] = src[i * ldSrc + j];
+        }
+    }
+}
+
+// Микроблок 4x4; для типов без SIMD-перегрузки - скалярно
+template <typename T>
+inline void transpose4x4(const T* src, size_t ldSrc, T* dst, size_t ldDst) {
+    transposeScalar(src, ldSrc, dst, ldDst, 4, 4);
+}
+
+#if defined(__AVX__)
+inline void transpose4x4(const double* src, size_t ldSrc, double* dst, size_t ldDst) {
+    __m256d r0 = _mm256_loadu_pd(src);
+    __m256d r1 = _mm256_loadu_pd(src + ldSrc);
+    __m256d r2 = _mm256_loadu_pd(src + 2 * ldSrc);
+    __m256d r3 = _mm256_loadu_pd(src + 3 * ldSrc);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + ldDst, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * ldDst, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * ldDst, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+#elif defined(__SSE2__)
+inline void transpose4x4(const double* src, size_t ldSrc, double* dst, size_t ldDst) {
+    // Четыре блока 2x2 в регистрах SSE2
+    for (size_t bi = 0; bi < 4; bi += 2) {
+        for (size_t bj = 0; bj < 4; bj += 2) {
+            __m128d r0 = _mm_loadu_pd(src + bi * ldSrc + bj);
+            __m128d r1 = _mm_loadu_pd(src + (bi + 1) * ldSrc + bj);
+            _mm_storeu_pd(dst + bj * ldDst + bi, _mm_unpacklo_pd(r0, r1));
+            _mm_storeu_pd(dst + (bj + 1) * ldDst + bi, _mm_unpackhi_pd(r0, r1));
+        }
+    }
+}
+#endif
+
+#if defined(__SSE2__)
+inline void transpose4x4(const float* src, size_t ldSrc, float* dst, size_t ldDst) {
+    __m128 r0 = _mm_loadu_ps(src);
+    __m128 r1 = _mm_loadu_ps(src + ldSrc);
+    __m128 r2 = _mm_loadu_ps(src + 2 * ldSrc);
+    __m128 r3 = _mm_loadu_ps(src + 3 * ldSrc);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(dst, r0);
+    _mm_storeu_ps(dst + ldDst, r1);
+    _mm_storeu_ps(dst + 2 * ldDst, r2);
+    _mm_storeu_ps(dst + 3 * ldDst, r3);
+}
+#endif
+
+// Транспонирование одного тайла, помещающегося в кэш
+template <typename T>
+inline void transposeTile(const T* src, size_t ldSrc, T* dst, size_t ldDst, size_t rows, size_t cols) {
+    size_t rows4 = rows & ~size_t(3);
+    size_t cols4 = cols & ~size_t(3);
+    for (size_t i = 0; i < rows4; i += 4) {
+        for (size_t j = 0; j < cols4; j += 4) {
+            transpose4x4(src + i * ldSrc + j, ldSrc, dst + j * ldDst + i, ldDst);
+        }
+    }
+    // Хвосты по столбцам и строкам
+    transposeScalar(src + cols4, ldSrc, dst + cols4 * ldDst, ldDst, rows, cols - cols4);
+    transposeScalar(src + rows4 * ldSrc, ldSrc, dst + rows4, ldDst, rows - rows4, cols4);
+}
+
+// Кэш-независимая рекурсия: делим большую сторону, сохраняя кратность 4
+template <typename T>
+void transposeRecursive(const T* src, size_t ldSrc, T* dst, size_t ldDst, size_t rows, size_t cols) {
+    if (rows <= TILE && cols <= TILE) {
+        transposeTile(src, ldSrc, dst, ldDst, rows, cols);
+        return;
+    }
+    if (rows >= cols) {
+        size_t half = (rows / 2 + 3) & ~size_t(3);
+        transposeRecursive(src, ldSrc, dst, ldDst, half, cols);
+        transposeRecursive(src + half * ldSrc, ldSrc, dst + half, ldDst, rows - half, cols);
+    } else {
+        size_t half = (cols / 2 + 3) & ~size_t(3);
+        transposeRecursive(src, ldSrc, dst, ldDst, rows, half);
+        transposeRecursive(src + half, ldSrc, dst + half * ldDst, ldDst, rows, cols - half);
+    }
+}
+
+// src: rows x cols (строки подряд), dst: cols x rows
+template <typename T>
+void transpose(const T* src, T* dst, size_t rows, size_t cols) {
+    transposeRecursive(src, cols, dst, rows, rows, cols);
+}
+
+} // namespace transpose_kernel
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "HardwareInfo.cpp"
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Профиль настройки под конкретную машину: параметры блочного умножения и размер блока
+// MatrixBlock, найденные автонастройкой (GemmTuner.cpp). Профиль читается при первом
+// обращении к current() из файла MATRIX_TUNING_PROFILE (по умолчанию matrix_tuning.txt
+// в текущем каталоге). Профиль другой машины (по сигнатуре процессора и кэшей) не
+// применяется - остаются значения по умолчанию.
+namespace tuning_profile {
+
+const unsigned VERSION = 1;
+
+struct Profile {
+    bool loaded = false;    // значения взяты из файла этой машины
+    std::string machine;
+    size_t mc = 64;         // параметры gemm_kernel::Params
+    size_t kc = 256;
+    size_t nc = 1024;
+    size_t threads = 0;
+    size_t blockSize = 64;  // размер блока MatrixBlock по умолчанию
+};
+
+struct CacheSizes {
+    size_t l1 = 32 * 1024;
+    size_t l2 = 256 * 1024;
+    size_t l3 = 8 * 1024 * 1024;
+};
+
+// Размеры кэшей данных из описания машины; если система их не сообщает - типичные значения
+inline CacheSizes cacheSizes() {
+    const hardware_info::Info& info = hardware_info::local();
+    CacheSizes sizes;
+    sizes.l1 = info.l1d;
+    sizes.l2 = info.l2;
+    sizes.l3 = info.l3;
+    return sizes;
+}
+
+// Модель процессора, число потоков и размеры кэшей одной строкой
+inline std::string machineSignature() {
+    const CacheSizes caches = cacheSizes();
+    std::ostringstream out;
+    out << hardware_info::local().cpuModel << "; threads " << std::thread::hardware_concurrency() << "; L1 "
+        << caches.l1 << "; L2 " << caches.l2 << "; L3 " << caches.l3;
+    return out.str();
+}
+
+// Значения без профиля: самая широкая панель B (не шире 256 x 1024), которая помещается в L2
+inline Profile defaults() {
+    Profile profile;
+    const size_t l2 = cacheSizes().l2;
+    const std::pair<size_t, size_t> panels[] = {{256, 1024}, {256, 512}, {256, 256}, {128, 256}, {64, 256}};
+    for (const auto& panel : panels) {
+        profile.kc = panel.first;
+        profile.nc = panel.second;
+        if (panel.first * panel.second * sizeof(double) <= l2) break;
+    }
+    return profile;
+}
+
+inline std::string defaultPath() {
+    const char* path = std::getenv("MATRIX_TUNING_PROFILE");
+    return path != nullptr && *path != '\0' ? path : "matrix_tuning.txt";
+}
+
+// Формат: "MatrixTuningProfile <версия>", затем строки "ключ значение"; неизвестные ключи
+// пропускаются. false, если файла нет; исключение, если он испорчен.
+inline bool read(const std::string& filename, Profile& profile) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string type;
+    unsigned version = 0;
+    file >> type >> version;
+    if (type != "MatrixTuningProfile" || version != VERSION) {
+        throw std::runtime_error("Invalid tuning profile: " + filename);
+    }
+    Profile result;
+    std::string key;
+    while (file >> key) {
+        if (key == "machine") {
+            std::getline(file >> std::ws, result.machine);
+            continue;
+        }
+        size_t value;
+        if (!(file >> value)) {
+            throw std::runtime_error("Invalid tuning profile: " + filename);
+        }
+        if (key == "gemm.mc") result.mc = value;
+        else if (key == "gemm.kc") result.kc = value;
+        else if (key == "gemm.nc") result.nc = value;
+        else if (key == "gemm.threads") result.threads = value;
+        else if (key == "block.size") result.blockSize = value;
+    }
+    if (result.mc == 0 || result.kc == 0 || result.nc == 0 || result.blockSize == 0) {
+        throw std::runtime_error("Invalid tuning profile: " + filename);
+    }
+    result.loaded = true;
+    profile = result;
+    return true;
+}
+
+inline void write(const std::string& filename, const Profile& profile) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    file << "MatrixTuningProfile " << VERSION << "\n";
+    file << "machine " << profile.machine << "\n";
+    file << "gemm.mc " << profile.mc << "\n";
+    file << "gemm.kc " << profile.kc << "\n";
+    file << "gemm.nc " << profile.nc << "\n";
+    file << "gemm.threads " << profile.threads << "\n";
+    file << "block.size " << profile.blockSize << "\n";
+    if (!file) {
+        throw std::runtime_error("Error writing tuning profile: " + filename);
+    }
+}
+
+// Профиль этой машины из defaultPath() или defaults(); читается один раз
+inline Profile& current() {
+    static Profile profile = []() {
+        Profile loaded;
+        try {
+            if (read(defaultPath(), loaded) && loaded.machine == machineSignature()) return loaded;
+        } catch (const std::exception&) {
+            // испорченный профиль не мешает работе - используются значения по умолчанию
+        }
+        return defaults();
+    }();
+    return profile;
+}
+
+} // namespace tuning_profile
@@ -0,0 +1,888 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <string>
+#include <cstdio>
+#include <thread>
+#include "MatrixDense.cpp"
+#include "MatrixDiagonal.cpp"
+#include "MatrixBlock.cpp"
+#include "MatrixBlockFixed.cpp"
+#include "MatrixBanded.cpp"
+#include "MatrixTransposeView.cpp"
+#include "MatrixVector.cpp"
+#include "IterativeSolvers.cpp"
+#include "GemmTuner.cpp"
+#include "MatrixExpression.cpp"
+#include "MatrixBlockOutOfCore.cpp"
+
+// Замер времени выполнения функции в миллисекундах
+template <typename Func>
+double measure_ms(Func f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename T>
+void fillRandom(MatrixDense<T>& matrix, unsigned seed = 42) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    T* data = matrix.getData();
+    for (size_t i = 0; i < size_t(matrix.getRows()) * matrix.getCols(); ++i) {
+        data[i] = static_cast<T>(dist(gen));
+    }
+}
+
+template <typename T>
+double maxDifference(const MatrixDense<T>& a, const MatrixDense<T>& b) {
+    double diff = 0;
+    for (size_t i = 0; i < size_t(a.getRows()) * a.getCols(); ++i) {
+        diff = std::max(diff, std::abs(double(a.getData()[i]) - double(b.getData()[i])));
+    }
+    return diff;
+}
+
+// Транспонирование: наивный обход через operator() против тайлового ядра
+void benchTranspose(unsigned m, unsigned n) {
+    MatrixDense<double> a(m, n);
+    fillRandom(a);
+
+    MatrixDense<double> naive(n, m);
+    double naiveTime = measure_ms([&]() {
+        for (unsigned i = 0; i < m; ++i)
+            for (unsigned j = 0; j < n; ++j)
+                naive(j, i) = a(i, j);
+    });
+    // Ядро в заранее выделенный буфер, чтобы не замерять первые обращения к страницам
+    MatrixDense<double> tiled(n, m);
+    double tiledTime = measure_ms([&]() {
+        transpose_kernel::transpose(a.getData(), tiled.getData(), m, n);
+    });
+
+    std::cout << "Transpose " << m << "x" << n << ": naive " << naiveTime << "ms, tiled " << tiledTime
+              << "ms, max diff " << maxDifference(naive, tiled) << "\n";
+}
+
+// A * B^T: явное транспонирование + умножение против ленивого представления
+void benchMultiplyTransposed(unsigned n) {
+    MatrixDense<double> a(n, n), b(n, n);
+    fillRandom(a, 1);
+    fillRandom(b, 2);
+
+    Matrix<double>* eager = nullptr;
+    double eagerTime = measure_ms([&]() {
+        Matrix<double>* bt = b.transpose();
+        eager = a * *bt;
+        delete bt;
+    });
+    Matrix<double>* lazy = nullptr;
+    double lazyTime = measure_ms([&]() { lazy = a * transposed(b); });
+
+    std::cout << "A*B^T " << n << "x" << n << ": eager " << eagerTime << "ms, view " << lazyTime
+              << "ms, max diff " << maxDifference(*static_cast<MatrixDense<double>*>(eager), *static_cast<MatrixDense<double>*>(lazy)) << "\n";
+    delete eager;
+    delete lazy;
+}
+
+size_t benchThreads() {
+    size_t threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 2 : threads;
+}
+
+void printThroughput(const std::string& name, double bytes, double ms) {
+    std::cout << "  " << name << ": " << ms << "ms, " << (bytes / (1024.0 * 1024.0)) / (ms / 1000.0) << " MB/s\n";
+}
+
+// Сохранение/загрузка: текстовый формат против бинарного (mmap)
+void benchDenseIO(unsigned n) {
+    MatrixDense<double> a(n, n);
+    fillRandom(a);
+    const double bytes = sizeof(double) * double(n) * n;
+    std::cout << "Dense I/O " << n << "x" << n << ":\n";
+
+    printThroughput("text save", bytes, measure_ms([&]() { a.exportToFile("bench_dense.txt"); }));
+    MatrixDense<double> fromText(1, 1);
+    printThroughput("text load", bytes, measure_ms([&]() { fromText.importFromFile("bench_dense.txt"); }));
+    const size_t threads = benchThreads();
+    MatrixDense<double> fromParallel(1, 1);
+    printThroughput("parallel text load", bytes, measure_ms([&]() { fromParallel.parallelImportFromFile("bench_dense.txt", threads); }));
+    printThroughput("parallel text save", bytes, measure_ms([&]() { a.parallelExportToFile("bench_dense_parallel.txt", threads); }));
+    MatrixDense<double> fromParallelSave(1, 1);
+    fromParallelSave.parallelImportFromFile("bench_dense_parallel.txt", threads);
+
+    printThroughput("binary save", bytes, measure_ms([&]() { a.exportToBinaryFile("bench_dense.bin"); }));
+    MatrixDense<double> fromBinary(1, 1);
+    printThroughput("binary open", bytes, measure_ms([&]() { fromBinary.importFromBinaryFile("bench_dense.bin"); }));
+    // Первое чтение всех страниц отображения
+    double checksum = 0;
+    printThroughput("binary first touch", bytes, measure_ms([&]() {
+        const double* data = fromBinary.getData();
+        for (size_t i = 0; i < size_t(n) * n; ++i) checksum += data[i];
+    }));
+
+    std::cout << "  max diff text " << maxDifference(a, fromText) << ", parallel text " << maxDifference(fromText, fromParallel)
+              << ", parallel round trip " << maxDifference(a, fromParallelSave) << ", binary " << maxDifference(a, fromBinary)
+              << " (checksum " << checksum << ")\n";
+    std::remove("bench_dense.txt");
+    std::remove("bench_dense_parallel.txt");
+    std::remove("bench_dense.bin");
+}
+
+void benchBlockIO(unsigned blocks, unsigned blockSize) {
+    MatrixBlock<double> a(blocks, blocks, blockSize);
+    size_t present = 0;
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            if ((i + j) % 3 != 0) continue; // треть блоков ненулевые
+            MatrixDense<double>* block = new MatrixDense<double>(blockSize, blockSize);
+            fillRandom(*block, i * blocks + j);
+            a.setBlock(i, j, block);
+            ++present;
+        }
+    }
+    const double bytes = sizeof(double) * double(present) * blockSize * blockSize;
+    std::cout << "Block I/O " << blocks << "x" << blocks << " blocks of " << blockSize << " (" << present << " present):\n";
+
+    printThroughput("text save", bytes, measure_ms([&]() { a.exportToFile("bench_block.txt"); }));
+    MatrixBlock<double> fromText(1, 1, 1);
+    printThroughput("text load", bytes, measure_ms([&]() { fromText.importFromFile("bench_block.txt"); }));
+    MatrixBlock<double> fromParallel(1, 1, 1);
+    printThroughput("parallel text load", bytes, measure_ms([&]() { fromParallel.parallelImportFromFile("bench_block.txt", benchThreads()); }));
+    printThroughput("parallel text save", bytes, measure_ms([&]() { a.parallelExportToFile("bench_block_parallel.txt", benchThreads()); }));
+    printThroughput("binary save", bytes, measure_ms([&]() { a.exportToBinaryFile("bench_block.bin"); }));
+    MatrixBlock<double> fromBinary(1, 1, 1);
+    printThroughput("binary open", bytes, measure_ms([&]() { fromBinary.importFromBinaryFile("bench_block.bin"); }));
+
+    double diff = 0;
+    for (unsigned i = 0; i < a.getRows(); i += 7) {
+        for (unsigned j = 0; j < a.getCols(); j += 5) {
+            diff = std::max(diff, std::abs(a(i, j) - fromBinary(i, j)));
+            diff = std::max(diff, std::abs(fromText(i, j) - fromParallel(i, j)));
+        }
+    }
+    std::cout << "  max diff binary/parallel text (sampled) " << diff << "\n";
+    std::remove("bench_block.txt");
+    std::remove("bench_block_parallel.txt");
+    std::remove("bench_block.bin");
+}
+
+// Копия MatrixBlock разделяет тайлы; первая запись в блок копирует только его
+void benchBlockCopy(unsigned blocks, unsigned blockSize) {
+    MatrixBlock<double> a(blocks, blocks, blockSize);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            MatrixDense<double>* block = new MatrixDense<double>(blockSize, blockSize);
+            fillRandom(*block, i * blocks + j);
+            a.setBlock(i, j, block);
+        }
+    }
+    MatrixBlock<double>* copy = nullptr;
+    double copyTime = measure_ms([&]() { copy = new MatrixBlock<double>(a); });
+    double writeTime = measure_ms([&]() { (*copy)(0, 0) = 1.0; });
+    std::cout << "Block copy " << blocks << "x" << blocks << " blocks of " << blockSize << ": copy " << copyTime
+              << "ms, first write (copy-on-write) " << writeTime << "ms\n";
+    delete copy;
+}
+
+// Умножение блочных матриц с разреженным шаблоном блоков: последовательный
+// перебор всех (i, j, k) с плотными суммами против движка задач
+void benchBlockMultiply(unsigned blocks, unsigned blockSize, unsigned density) {
+    MatrixBlock<double> a(blocks, blocks, blockSize), b(blocks, blocks, blockSize);
+    std::mt19937 gen(7);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            if (gen() % 100 < density) {
+                MatrixDense<double>* block = new MatrixDense<double>(blockSize, blockSize);
+                fillRandom(*block, gen());
+                a.setBlock(i, j, block);
+            }
+            if (gen() % 100 < density) {
+                MatrixDense<double>* block = new MatrixDense<double>(blockSize, blockSize);
+                fillRandom(*block, gen());
+                b.setBlock(i, j, block);
+            }
+        }
+    }
+
+    std::vector<MatrixDense<double>*> reference(size_t(blocks) * blocks, nullptr);
+    double sequentialTime = measure_ms([&]() {
+        for (unsigned i = 0; i < blocks; ++i) {
+            for (unsigned j = 0; j < blocks; ++j) {
+                MatrixDense<double>* sum = new MatrixDense<double>(blockSize, blockSize);
+                for (unsigned k = 0; k < blocks; ++k) {
+                    if (a.getBlock(i, k) == nullptr || b.getBlock(k, j) == nullptr) continue;
+                    Matrix<double>* product = (*a.getBlock(i, k)) * (*b.getBlock(k, j));
+                    Matrix<double>* next = (*sum) + (*product);
+                    delete product;
+                    delete sum;
+                    sum = static_cast<MatrixDense<double>*>(next);
+                }
+                reference[size_t(i) * blocks + j] = sum;
+            }
+        }
+    });
+
+    Matrix<double>* result = nullptr;
+    double engineTime = measure_ms([&]() { result = a * b; });
+    MatrixBlock<double>* blockResult = static_cast<MatrixBlock<double>*>(result);
+
+    size_t present = 0;
+    double diff = 0;
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            const MatrixDense<double>* block = blockResult->getBlock(i, j);
+            MatrixDense<double>* expected = reference[size_t(i) * blocks + j];
+            if (block != nullptr) {
+                ++present;
+                diff = std::max(diff, maxDifference(*block, *expected));
+            } else {
+                MatrixDense<double> zero(blockSize, blockSize);
+                diff = std::max(diff, maxDifference(zero, *expected));
+            }
+            delete expected;
+        }
+    }
+    std::cout << "Block multiply " << blocks << "x" << blocks << " blocks of " << blockSize << ", " << density
+              << "% dense: sequential " << sequentialTime << "ms, task engine " << engineTime << "ms, output blocks "
+              << present << "/" << size_t(blocks) * blocks << ", max diff " << diff << "\n";
+    delete result;
+}
+
+// Штрассен-Виноград: подбор точки перехода на блочное ядро, ускорение и погрешность
+void benchStrassen(unsigned n) {
+    MatrixDense<double> a(n, n), b(n, n);
+    fillRandom(a, 3);
+    fillRandom(b, 4);
+
+    Matrix<double>* reference = nullptr;
+    double gemmTime = measure_ms([&]() { reference = a * b; });
+    const MatrixDense<double>& expected = *static_cast<MatrixDense<double>*>(reference);
+    std::cout << "Strassen " << n << "x" << n << ": blocked kernel " << gemmTime << "ms\n";
+
+    const size_t defaultCrossover = strassen::params().crossover;
+    size_t bestCrossover = defaultCrossover;
+    double bestTime = gemmTime;
+    for (size_t crossover : {64, 128, 256, 512}) {
+        if (crossover >= n) break;
+        strassen::params().crossover = crossover;
+        MatrixDense<double>* fast = nullptr;
+        double time = measure_ms([&]() { fast = a.multiplyStrassen(b); });
+        std::cout << "  crossover " << crossover << ": " << time << "ms, speedup " << gemmTime / time
+                  << ", max error " << maxDifference(expected, *fast) << "\n";
+        if (time < bestTime) {
+            bestTime = time;
+            bestCrossover = crossover;
+        }
+        delete fast;
+    }
+    std::cout << "  best crossover " << (bestTime < gemmTime ? std::to_string(bestCrossover) : std::string("none (kernel faster)")) << "\n";
+    strassen::params().crossover = defaultCrossover;
+    delete reference;
+}
+
+void benchBlockStrassen(unsigned blocks, unsigned blockSize) {
+    MatrixBlock<double> a(blocks, blocks, blockSize), b(blocks, blocks, blockSize);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            MatrixDense<double>* x = new MatrixDense<double>(blockSize, blockSize);
+            fillRandom(*x, i * blocks + j);
+            a.setBlock(i, j, x);
+            MatrixDense<double>* y = new MatrixDense<double>(blockSize, blockSize);
+            fillRandom(*y, 1000 + i * blocks + j);
+            b.setBlock(i, j, y);
+        }
+    }
+    Matrix<double>* engine = nullptr;
+    double engineTime = measure_ms([&]() { engine = a * b; });
+    MatrixBlock<double>* fast = nullptr;
+    double fastTime = measure_ms([&]() { fast = a.multiplyStrassen(b); });
+    double error = 0;
+    for (unsigned i = 0; i < blocks; ++i)
+        for (unsigned j = 0; j < blocks; ++j)
+            error = std::max(error, maxDifference(*static_cast<MatrixBlock<double>*>(engine)->getBlock(i, j), *fast->getBlock(i, j)));
+    std::cout << "Block Strassen " << blocks << "x" << blocks << " blocks of " << blockSize << ": engine " << engineTime
+              << "ms, Strassen " << fastTime << "ms, speedup " << engineTime / fastTime << ", max error " << error << "\n";
+    delete engine;
+    delete fast;
+}
+
+// Умножение матрицы на вектор: наивный цикл через operator() против ядер matrix_vector,
+// затем несколько правых частей одним проходом по матрице против повторных вызовов
+void benchGemv(unsigned n, unsigned rhs) {
+    MatrixDense<double> a(n, n);
+    fillRandom(a, 5);
+    Vector<double> x(n), y(n), yt(n), naive(n);
+    x.initialize_random(-1.0, 1.0);
+    naive.initialize(0.0);
+
+    double naiveTime = measure_ms([&]() {
+        for (unsigned i = 0; i < n; ++i) {
+            double sum = 0;
+            for (unsigned j = 0; j < n; ++j) sum += a(i, j) * x[j];
+            naive[i] = sum;
+        }
+    });
+    double gemvTime = measure_ms([&]() { matrix_vector::gemv(a, x, y); });
+    double transposedTime = measure_ms([&]() { matrix_vector::gemvTransposed(a, x, yt); });
+    double diff = 0;
+    for (unsigned i = 0; i < n; ++i) diff = std::max(diff, std::abs(naive[i] - y[i]));
+    const double bytes = double(n) * n * sizeof(double);
+    std::cout << "GEMV " << n << "x" << n << ": naive " << naiveTime << "ms, kernel " << gemvTime << "ms ("
+              << bytes / gemvTime / 1e6 << " GB/s), transposed " << transposedTime << "ms, max diff " << diff << "\n";
+
+    std::vector<Vector<double>> xs;
+    for (unsigned r = 0; r < rhs; ++r) {
+        xs.emplace_back(n);
+        xs.back().initialize_random(-1.0, 1.0);
+    }
+    double repeatedTime = measure_ms([&]() {
+        for (unsigned r = 0; r < rhs; ++r) matrix_vector::gemv(a, xs[r], y);
+    });
+    std::vector<Vector<double>> ys;
+    double batchTime = measure_ms([&]() { ys = matrix_vector::gemvBatch(a, xs); });
+    matrix_vector::gemv(a, xs[rhs - 1], y);
+    diff = 0;
+    for (unsigned i = 0; i < n; ++i) diff = std::max(diff, std::abs(ys[rhs - 1][i] - y[i]));
+    std::cout << "  " << rhs << " right-hand sides: repeated " << repeatedTime << "ms, batched " << batchTime
+              << "ms, max diff " << diff << "\n";
+}
+
+// Блочная матрица с пропуском нулевых блоков и диагональная за O(n)
+void benchBlockGemv(unsigned blocks, unsigned blockSize, unsigned density) {
+    MatrixBlock<double> a(blocks, blocks, blockSize);
+    std::mt19937 gen(11);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            if (gen() % 100 < density) {
+                MatrixDense<double>* block = new MatrixDense<double>(blockSize, blockSize);
+                fillRandom(*block, gen());
+                a.setBlock(i, j, block);
+            }
+        }
+    }
+    const unsigned n = blocks * blockSize;
+    Vector<double> x(n), y(n), yt(n);
+    x.initialize_random(-1.0, 1.0);
+    double gemvTime = measure_ms([&]() { matrix_vector::gemv(a, x, y); });
+    double transposedTime = measure_ms([&]() { matrix_vector::gemvTransposed(a, x, yt); });
+
+    // Проверка на нескольких строках через operator()
+    double diff = 0;
+    for (unsigned i = 0; i < n; i += n / 16) {
+        double sum = 0, sumT = 0;
+        for (unsigned j = 0; j < n; ++j) {
+            sum += a(i, j) * x[j];
+            sumT += a(j, i) * x[j];
+        }
+        diff = std::max(diff, std::max(std::abs(sum - y[i]), std::abs(sumT - yt[i])));
+    }
+
+    MatrixDiagonal<double> d(n);
+    for (unsigned i = 0; i < n; ++i) d(i, i) = 1.0 + i % 7;
+    Vector<double> yd(n);
+    double diagonalTime = measure_ms([&]() { yd = d * x; });
+    for (unsigned i = 0; i < n; ++i) diff = std::max(diff, std::abs((1.0 + i % 7) * x[i] - yd[i]));
+
+    std::cout << "Block GEMV " << blocks << "x" << blocks << " blocks of " << blockSize << ", " << density
+              << "% dense: " << gemvTime << "ms, transposed " << transposedTime << "ms; diagonal " << n << ": "
+              << diagonalTime << "ms, max diff " << diff << "\n";
+}
+
+// Относительная невязка ||A x - b|| / (||A|| ||x||) в max-нормах
+double relativeResidual(const Matrix<double>& a, const Vector<double>& x, const Vector<double>& b, double normA) {
+    Vector<double> ax = a * x;
+    double residual = 0, normX = 0;
+    for (size_t i = 0; i < b.size(); ++i) {
+        residual = std::max(residual, std::abs(ax[i] - b[i]));
+        normX = std::max(normX, std::abs(x[i]));
+    }
+    return residual / (normA * normX);
+}
+
+// LU и Холецкий: неблочный алгоритм (панель во всю ширину) против блочного, затем тайловый
+// вариант над MatrixBlock; GFLOPS по 2/3 n^3 и 1/3 n^3 операций и невязки решений
+void benchFactorization(unsigned n, unsigned blockSize) {
+    MatrixDense<double> a(n, n);
+    fillRandom(a, 8);
+    MatrixDense<double> spd(n, n);
+    fillRandom(spd, 9);
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < i; ++j) spd(j, i) = spd(i, j);
+        spd(i, i) += n;
+    }
+    double normA = 0, normS = 0;
+    for (size_t i = 0; i < size_t(n) * n; ++i) {
+        normA = std::max(normA, std::abs(a.getData()[i]));
+        normS = std::max(normS, std::abs(spd.getData()[i]));
+    }
+    Vector<double> b(n);
+    b.initialize_random(-1.0, 1.0);
+    const double luFlops = 2.0 / 3.0 * n * n * n, choleskyFlops = 1.0 / 3.0 * n * n * n;
+
+    const size_t defaultBlock = factorization::params().block;
+    for (size_t block : {size_t(n), defaultBlock}) {
+        factorization::params().block = block;
+        std::vector<unsigned> pivots;
+        MatrixDense<double>* lu = nullptr;
+        MatrixDense<double>* l = nullptr;
+        double luTime = measure_ms([&]() { lu = a.luDecomposition(pivots); });
+        double choleskyTime = measure_ms([&]() { l = spd.choleskyDecomposition(); });
+        Vector<double> x = matrix_vector::luSolve(*lu, pivots, b);
+        Vector<double> y = matrix_vector::choleskySolve(*l, b);
+        std::cout << "Factorization " << n << "x" << n << (block == n ? " unblocked" : " blocked") << ": LU " << luTime
+                  << "ms (" << luFlops / luTime / 1e6 << " GFLOPS, residual " << relativeResidual(a, x, b, normA)
+                  << "), Cholesky " << choleskyTime << "ms (" << choleskyFlops / choleskyTime / 1e6
+                  << " GFLOPS, residual " << relativeResidual(spd, y, b, normS) << ")\n";
+        delete lu;
+        delete l;
+    }
+    factorization::params().block = defaultBlock;
+
+    const unsigned blocks = n / blockSize;
+    MatrixBlock<double> tiledA(blocks, blocks, blockSize), tiledS(blocks, blocks, blockSize);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            MatrixDense<double>* x = new MatrixDense<double>(blockSize, blockSize);
+            MatrixDense<double>* y = new MatrixDense<double>(blockSize, blockSize);
+            for (unsigned r = 0; r < blockSize; ++r) {
+                for (unsigned c = 0; c < blockSize; ++c) {
+                    (*x)(r, c) = a(i * blockSize + r, j * blockSize + c);
+                    (*y)(r, c) = spd(i * blockSize + r, j * blockSize + c);
+                }
+            }
+            tiledA.setBlock(i, j, x);
+            tiledS.setBlock(i, j, y);
+        }
+    }
+    std::vector<unsigned> pivots;
+    MatrixBlock<double>* lu = nullptr;
+    MatrixBlock<double>* l = nullptr;
+    double luTime = measure_ms([&]() { lu = tiledA.luDecomposition(pivots); });
+    double choleskyTime = measure_ms([&]() { l = tiledS.choleskyDecomposition(); });
+    Vector<double> x = matrix_vector::luSolve(*lu, pivots, b);
+    Vector<double> y = matrix_vector::choleskySolve(*l, b);
+    std::cout << "  tiled " << blocks << "x" << blocks << " blocks of " << blockSize << ": LU " << luTime << "ms ("
+              << luFlops / luTime / 1e6 << " GFLOPS, residual " << relativeResidual(tiledA, x, b, normA)
+              << "), Cholesky " << choleskyTime << "ms (" << choleskyFlops / choleskyTime / 1e6
+              << " GFLOPS, residual " << relativeResidual(tiledS, y, b, normS) << ")\n";
+    delete lu;
+    delete l;
+}
+
+void printSolve(const std::string& name, const iterative::Report& report) {
+    std::cout << "  " << name << ": " << report.iterations << " iterations, " << report.totalMs << "ms ("
+              << report.msPerIteration << "ms/iteration), residual " << report.residual
+              << (report.converged ? "" : " (not converged)") << "\n";
+}
+
+// Итерационные решатели: CG без предобусловливателя и с Якоби на плотной СПД-системе с сильно
+// различающейся диагональю (для сравнения - прямой Холецкий), BiCGSTAB на несимметричной,
+// PCG на блочно-трёхдиагональной MatrixBlock, где нулевые блоки не участвуют в умножениях
+void benchIterative(unsigned n, unsigned blocks, unsigned blockSize) {
+    MatrixDense<double> spd(n, n), general(n, n);
+    fillRandom(spd, 12);
+    fillRandom(general, 13);
+    const double offScale = 0.5 / std::sqrt(double(n));
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < i; ++j) {
+            spd(i, j) *= offScale;
+            spd(j, i) = spd(i, j);
+            general(i, j) *= offScale;
+            general(j, i) *= offScale;
+        }
+        spd(i, i) = 1.0 + (i % 10) * 50.0;
+        general(i, i) = 2.0 + (i % 5) * 10.0;
+    }
+    Vector<double> b(n);
+    b.initialize_random(-1.0, 1.0);
+    iterative::KrylovSolver<double> solver(n);
+    MatrixDiagonal<double>* jacobi = iterative::jacobiPreconditioner<double>(spd);
+    MatrixDiagonal<double>* jacobiGeneral = iterative::jacobiPreconditioner<double>(general);
+
+    std::cout << "Iterative solvers, dense " << n << "x" << n << ":\n";
+    Vector<double> x(n);
+    x.initialize(0.0);
+    printSolve("CG", solver.conjugateGradient(spd, b, x));
+    x.initialize(0.0);
+    printSolve("PCG (Jacobi)", solver.conjugateGradient(spd, b, x, jacobi));
+    x.initialize(0.0);
+    printSolve("BiCGSTAB", solver.biCGStab(general, b, x));
+    x.initialize(0.0);
+    printSolve("BiCGSTAB (Jacobi)", solver.biCGStab(general, b, x, jacobiGeneral));
+    MatrixDense<double>* l = nullptr;
+    double choleskyTime = measure_ms([&]() { l = spd.choleskyDecomposition(); });
+    std::cout << "  Cholesky for comparison: " << choleskyTime << "ms\n";
+    delete l;
+    delete jacobi;
+    delete jacobiGeneral;
+
+    // Блочно-трёхдиагональная СПД-матрица: диагональные блоки с преобладающей диагональю
+    MatrixBlock<double> tridiagonal(blocks, blocks, blockSize);
+    std::mt19937 gen(14);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (unsigned i = 0; i < blocks; ++i) {
+        MatrixDense<double>* diagonal = new MatrixDense<double>(blockSize, blockSize);
+        for (unsigned r = 0; r < blockSize; ++r) {
+            for (unsigned c = 0; c < r; ++c) {
+                (*diagonal)(r, c) = dist(gen) * 0.1;
+                (*diagonal)(c, r) = (*diagonal)(r, c);
+            }
+            (*diagonal)(r, r) = 4.0 + (r % 8);
+        }
+        tridiagonal.setBlock(i, i, diagonal);
+        if (i + 1 < blocks) {
+            MatrixDense<double>* lower = new MatrixDense<double>(blockSize, blockSize);
+            MatrixDense<double>* upper = new MatrixDense<double>(blockSize, blockSize);
+            for (unsigned r = 0; r < blockSize; ++r) {
+                for (unsigned c = 0; c < blockSize; ++c) {
+                    (*lower)(r, c) = dist(gen) * 0.5 / blockSize;
+                    (*upper)(c, r) = (*lower)(r, c);
+                }
+            }
+            tridiagonal.setBlock(i + 1, i, lower);
+            tridiagonal.setBlock(i, i + 1, upper);
+        }
+    }
+    const unsigned size = blocks * blockSize;
+    Vector<double> rhs(size), y(size);
+    rhs.initialize_random(-1.0, 1.0);
+    iterative::KrylovSolver<double> blockSolver(size);
+    MatrixDiagonal<double>* blockJacobi = iterative::jacobiPreconditioner<double>(tridiagonal);
+    std::cout << "Iterative solvers, block tridiagonal " << blocks << "x" << blocks << " blocks of " << blockSize << ":\n";
+    y.initialize(0.0);
+    printSolve("CG", blockSolver.conjugateGradient(tridiagonal, rhs, y));
+    y.initialize(0.0);
+    printSolve("PCG (Jacobi)", blockSolver.conjugateGradient(tridiagonal, rhs, y, blockJacobi));
+    delete blockJacobi;
+}
+
+// Маленькие блоки: тайлы MatrixDense с размером во время выполнения против MatrixBlock<T, B>
+// с тайлами MatrixFixed внутри матрицы - умножение, сложение и транспонирование
+template <unsigned B>
+void benchFixedTiles(unsigned blocks, unsigned density) {
+    MatrixBlock<double> a(blocks, blocks, B), b(blocks, blocks, B);
+    std::mt19937 gen(15 + B);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            if (gen() % 100 < density) {
+                MatrixDense<double>* block = new MatrixDense<double>(B, B);
+                fillRandom(*block, gen());
+                a.setBlock(i, j, block);
+            }
+            if (gen() % 100 < density) {
+                MatrixDense<double>* block = new MatrixDense<double>(B, B);
+                fillRandom(*block, gen());
+                b.setBlock(i, j, block);
+            }
+        }
+    }
+    MatrixBlock<double, B> fa(a), fb(b);
+
+    Matrix<double>* product = nullptr;
+    Matrix<double>* fixedProduct = nullptr;
+    double multiplyTime = measure_ms([&]() { product = a * b; });
+    double fixedMultiplyTime = measure_ms([&]() { fixedProduct = fa * fb; });
+    // оба вида хранят в сумме блоки, ненулевые хотя бы в одном слагаемом
+    Matrix<double>* sum = nullptr;
+    Matrix<double>* fixedSum = nullptr;
+    double addTime = measure_ms([&]() { sum = a + b; });
+    double fixedAddTime = measure_ms([&]() { fixedSum = fa + fb; });
+    Matrix<double>* transposed = nullptr;
+    Matrix<double>* fixedTransposed = nullptr;
+    double transposeTime = measure_ms([&]() { transposed = a.transpose(); });
+    double fixedTransposeTime = measure_ms([&]() { fixedTransposed = fa.transpose(); });
+
+    double diff = 0;
+    const MatrixBlock<double>& dynamicProduct = *static_cast<MatrixBlock<double>*>(product);
+    const MatrixBlock<double, B>& staticProduct = *static_cast<MatrixBlock<double, B>*>(fixedProduct);
+    const MatrixBlock<double>& dynamicSum = *static_cast<MatrixBlock<double>*>(sum);
+    const MatrixBlock<double, B>& staticSum = *static_cast<MatrixBlock<double, B>*>(fixedSum);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            const MatrixDense<double>* x = dynamicProduct.getBlock(i, j);
+            const MatrixFixed<double, B, B>* y = staticProduct.getBlock(i, j);
+            const MatrixDense<double>* u = dynamicSum.getBlock(i, j);
+            const MatrixFixed<double, B, B>* v = staticSum.getBlock(i, j);
+            for (unsigned e = 0; e < B * B; ++e) {
+                diff = std::max(diff, std::abs((x ? x->getData()[e] : 0.0) - (y ? y->getData()[e] : 0.0)));
+                diff = std::max(diff, std::abs((u ? u->getData()[e] : 0.0) - (v ? v->getData()[e] : 0.0)));
+            }
+        }
+    }
+    std::cout << "Fixed tiles " << B << "x" << B << ", " << blocks << "x" << blocks << " blocks, " << density
+              << "% dense: multiply " << multiplyTime << "ms -> " << fixedMultiplyTime << "ms, add " << addTime << "ms -> "
+              << fixedAddTime << "ms, transpose " << transposeTime << "ms -> " << fixedTransposeTime << "ms, max diff "
+              << diff << "\n";
+    delete product;
+    delete fixedProduct;
+    delete sum;
+    delete fixedSum;
+    delete transposed;
+    delete fixedTransposed;
+}
+
+// Трёхдиагональный оператор (разностная схема -u'' + u): MatrixDense размера n против
+// MatrixBanded - матвектор, произведение и решение системы; затем MatrixBanded большого
+// размера, где плотное хранение уже невозможно, - прогонка против циклической редукции
+void benchBanded(unsigned n, unsigned largeN) {
+    auto stencil = [](MatrixBanded<double>& a) {
+        for (unsigned i = 0; i < a.getSize(); ++i) {
+            a(i, i) = 3.0;
+            if (i > 0) a(i, i - 1) = -1.0;
+            if (i + 1 < a.getSize()) a(i, i + 1) = -1.0;
+        }
+    };
+    MatrixBanded<double> banded(n);
+    stencil(banded);
+    MatrixDense<double> dense(n, n);
+    for (unsigned i = 0; i < n; ++i)
+        for (unsigned j = (i > 0 ? i - 1 : 0); j <= std::min(n - 1, i + 1); ++j) dense(i, j) = banded(i, j);
+    Vector<double> x(n), y(n), z(n);
+    x.initialize_random(-1.0, 1.0);
+
+    double denseGemv = measure_ms([&]() { matrix_vector::gemv(dense, x, y); });
+    double bandedGemv = measure_ms([&]() { matrix_vector::gemv(banded, x, z); });
+    double gemvDiff = 0;
+    for (unsigned i = 0; i < n; ++i) gemvDiff = std::max(gemvDiff, std::abs(y[i] - z[i]));
+
+    Matrix<double>* denseProduct = nullptr;
+    Matrix<double>* bandedProduct = nullptr;
+    double denseMultiply = measure_ms([&]() { denseProduct = dense * dense; });
+    double bandedMultiply = measure_ms([&]() { bandedProduct = banded * banded; });
+    double productDiff = 0;
+    for (unsigned i = 0; i < n; ++i)
+        for (unsigned j = 0; j < n; ++j)
+            productDiff = std::max(productDiff, std::abs((*denseProduct)(i, j) - (*bandedProduct)(i, j)));
+    delete denseProduct;
+    delete bandedProduct;
+
+    std::vector<unsigned> pivots;
+    Vector<double> luX(n), thomasX(n);
+    double denseSolve = measure_ms([&]() {
+        MatrixDense<double>* lu = dense.luDecomposition(pivots);
+        luX = matrix_vector::luSolve(*lu, pivots, x);
+        delete lu;
+    });
+    double thomasSolve = measure_ms([&]() { thomasX = matrix_vector::thomasSolve(banded, x); });
+    double solveDiff = 0;
+    for (unsigned i = 0; i < n; ++i) solveDiff = std::max(solveDiff, std::abs(luX[i] - thomasX[i]));
+    std::cout << "Tridiagonal " << n << "x" << n << ", dense -> banded: gemv " << denseGemv << "ms -> " << bandedGemv
+              << "ms (diff " << gemvDiff << "), multiply " << denseMultiply << "ms -> " << bandedMultiply
+              << "ms (diff " << productDiff << "), LU solve -> Thomas " << denseSolve << "ms -> " << thomasSolve
+              << "ms (diff " << solveDiff << ")\n";
+
+    MatrixBanded<double> large(largeN);
+    stencil(large);
+    Vector<double> b(largeN), c(largeN);
+    b.initialize_random(-1.0, 1.0);
+    double largeGemv = measure_ms([&]() { matrix_vector::gemv(large, b, c); });
+    Vector<double> thomas(largeN), reduction(largeN);
+    double thomasTime = measure_ms([&]() { thomas = matrix_vector::thomasSolve(large, b); });
+    double reductionTime = measure_ms([&]() { reduction = matrix_vector::cyclicReductionSolve(large, b); });
+    double reductionDiff = 0;
+    for (unsigned i = 0; i < largeN; ++i) reductionDiff = std::max(reductionDiff, std::abs(thomas[i] - reduction[i]));
+    Matrix<double>* square = nullptr;
+    double largeMultiply = measure_ms([&]() { square = large * large; });
+    delete square;
+    std::cout << "Tridiagonal n = " << largeN << ": gemv " << largeGemv << "ms, multiply " << largeMultiply
+              << "ms, Thomas " << thomasTime << "ms, cyclic reduction (" << ThreadPool::global().size() + 1
+              << " threads) " << reductionTime << "ms, diff " << reductionDiff << "\n";
+}
+
+// Пропускная способность GEMM n x n по типу элемента: double и float - ядро gemm_kernel,
+// int32 - прежний путь (общее ядро с накоплением в int) против gemm_integer с накоплением
+// в int64, int16 и int8 - упакованные пары (pmaddwd / VNNI) с накоплением в int32
+template <typename T, typename Acc>
+double integerGemmMs(unsigned n, int range) {
+    std::mt19937 gen(37);
+    std::uniform_int_distribution<int> dist(-range, range);
+    std::vector<T> a(size_t(n) * n), b(size_t(n) * n);
+    for (auto& x : a) x = T(dist(gen));
+    for (auto& x : b) x = T(dist(gen));
+    std::vector<Acc> c(size_t(n) * n);
+    return measure_ms([&]() { gemm_integer::multiply<T, Acc>(a.data(), n, b.data(), n, c.data(), n, n, n, n, false); });
+}
+
+void benchTypedGemm(unsigned n) {
+    const double ops = 2.0 * n * n * n;
+    auto report = [&](const std::string& name, double ms) {
+        std::cout << "  " << name << ": " << ms << "ms, " << ops / ms / 1e6 << " GOPS\n";
+    };
+    std::cout << "GEMM " << n << "x" << n << " by element type:\n";
+    MatrixDense<double> ad(n, n), bd(n, n);
+    fillRandom(ad, 1);
+    fillRandom(bd, 2);
+    MatrixDense<float> af(n, n), bf(n, n);
+    for (size_t e = 0; e < size_t(n) * n; ++e) {
+        af.getData()[e] = float(ad.getData()[e]);
+        bf.getData()[e] = float(bd.getData()[e]);
+    }
+    Matrix<double>* cd = nullptr;
+    Matrix<float>* cf = nullptr;
+    report("double", measure_ms([&]() { cd = ad * bd; }));
+    report("float", measure_ms([&]() { cf = af * bf; }));
+    delete cd;
+    delete cf;
+
+    std::vector<int32_t> ai(size_t(n) * n), bi(size_t(n) * n), ci(size_t(n) * n);
+    std::mt19937 gen(38);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    for (auto& x : ai) x = dist(gen);
+    for (auto& x : bi) x = dist(gen);
+    report("int32 -> int32 (general kernel)", measure_ms([&]() {
+        gemm_kernel::multiplyRows(ai.data(), n, bi.data(), n, ci.data(), n, 0, n, n, n, gemm_kernel::params());
+    }));
+    report("int32 -> int64", integerGemmMs<int32_t, int64_t>(n, 1000));
+    report("int16 -> int32", integerGemmMs<int16_t, int32_t>(n, 1000));
+    report("int8 -> int32", integerGemmMs<int8_t, int32_t>(n, 127));
+}
+
+// Отложенное вычисление против немедленного: цепочка A(n x k) * B(k x n) * C(n x k) + D,
+// где слева направо получается промежуточная n x n, и та же цепочка с диагональным
+// множителем; время, пиковый объём созданных матриц и расхождение результатов
+void benchLazy(unsigned n, unsigned k) {
+    MatrixDense<double> a(n, k), b(k, n), c(n, k), d(n, k);
+    fillRandom(a, 1);
+    fillRandom(b, 2);
+    fillRandom(c, 3);
+    fillRandom(d, 4);
+    MatrixDiagonal<double> g(n);
+    for (unsigned i = 0; i < n; ++i) g(i, i) = 1.0 + i % 7;
+
+    auto run = [&](const std::string& name, bool withDiagonal) {
+        Matrix<double>* eager = nullptr;
+        const double eagerMs = measure_ms([&]() {
+            Matrix<double>* ab = a * b;
+            if (withDiagonal) {
+                // диагональная * плотная немедленными операторами не поддерживается - по строкам
+                for (unsigned i = 0; i < n; ++i)
+                    for (unsigned j = 0; j < n; ++j) (*ab)(i, j) *= g(i, i);
+            }
+            Matrix<double>* abc = *ab * c;
+            delete ab;
+            eager = *abc + d;
+            delete abc;
+        });
+        const size_t eagerBytes = sizeof(double) * (size_t(n) * n + size_t(n) * k);
+
+        lazy::Stats stats;
+        Matrix<double>* result = nullptr;
+        const double lazyMs = measure_ms([&]() {
+            auto expression = withDiagonal ? lazy::ref(g) * lazy::ref(a) * lazy::ref(b) * lazy::ref(c) + lazy::ref(d)
+                                           : lazy::ref(a) * lazy::ref(b) * lazy::ref(c) + lazy::ref(d);
+            result = lazy::evaluate(expression, &stats);
+        });
+        double diff = 0;
+        for (unsigned i = 0; i < n; ++i)
+            for (unsigned j = 0; j < k; ++j) diff = std::max(diff, std::abs((*eager)(i, j) - (*result)(i, j)));
+        std::cout << "  " << name << ": eager " << eagerMs << "ms, peak " << eagerBytes / 1024 << "KB -> lazy " << lazyMs
+                  << "ms, peak " << stats.peakBytes / 1024 << "KB, plan " << stats.plan << ", fused "
+                  << stats.fusedOperations << ", diff " << diff << "\n";
+        delete eager;
+        delete result;
+    };
+    std::cout << "Lazy expressions, n = " << n << ", k = " << k << ":\n";
+    run("A*B*C + D", false);
+    run("G*A*B*C + D", true);
+}
+
+// Умножение блочных матриц из файлов при бюджете памяти меньше самих матриц: объём
+// чтения против нижней границы (каждый тайл один раз), с фоновым чтением и без; для
+// сравнения - то же умножение целиком в памяти
+void benchOutOfCore(unsigned blocks, unsigned blockSize, size_t memoryBytes) {
+    MatrixBlock<double> a(blocks, blocks, blockSize), b(blocks, blocks, blockSize);
+    for (unsigned i = 0; i < blocks; ++i) {
+        for (unsigned j = 0; j < blocks; ++j) {
+            MatrixDense<double>* x = new MatrixDense<double>(blockSize, blockSize);
+            MatrixDense<double>* y = new MatrixDense<double>(blockSize, blockSize);
+            fillRandom(*x, i * blocks + j);
+            fillRandom(*y, i * blocks + j + blocks * blocks);
+            a.setBlock(i, j, x);
+            b.setBlock(i, j, y);
+        }
+    }
+    a.exportToBinaryFile("bench_ooc_a.bin");
+    b.exportToBinaryFile("bench_ooc_b.bin");
+    const double matrixMB = sizeof(double) * double(a.getRows()) * a.getCols() / (1 << 20);
+    std::cout << "Out-of-core multiply " << a.getRows() << "x" << a.getCols() << " (" << matrixMB << "MB per matrix, budget "
+              << memoryBytes / (1 << 20) << "MB):\n";
+
+    Matrix<double>* inMemory = nullptr;
+    const double inMemoryMs = measure_ms([&]() { inMemory = a * b; });
+    std::cout << "  in memory: " << inMemoryMs << "ms\n";
+    for (bool prefetch : {false, true}) {
+        out_of_core::Options options;
+        options.memoryBytes = memoryBytes;
+        options.prefetch = prefetch;
+        const out_of_core::Report report = out_of_core::multiply<double>("bench_ooc_a.bin", "bench_ooc_b.bin", "bench_ooc_c.bin", options);
+        MatrixBlock<double> c(1, 1, 1);
+        c.importFromBinaryFile("bench_ooc_c.bin");
+        double diff = 0;
+        for (unsigned i = 0; i < c.getRows(); i += 7)
+            for (unsigned j = 0; j < c.getCols(); j += 5) diff = std::max(diff, std::abs(c(i, j) - (*inMemory)(i, j)));
+        std::cout << "  " << (prefetch ? "with prefetch" : "no prefetch") << ": " << report.ms << "ms, panel "
+                  << report.panelRows << "x" << report.panelCols << " tiles" << (report.residentRows ? " (A rows resident)" : "")
+                  << ", read " << report.bytesRead / (1 << 20)
+                  << "MB (minimum " << report.minimalBytesRead / (1 << 20) << "MB), written " << report.bytesWritten / (1 << 20)
+                  << "MB, cache hits " << report.hits << ", misses " << report.misses << ", prefetched "
+                  << report.prefetched << ", max diff (sampled) " << diff << "\n";
+    }
+    delete inMemory;
+    std::remove("bench_ooc_a.bin");
+    std::remove("bench_ooc_b.bin");
+    std::remove("bench_ooc_c.bin");
+}
+
+// Автонастройка (benchmark --tune): подбирает параметры умножения и сохраняет профиль,
+// который читается при следующих запусках
+int tuneMain() {
+    gemm_tuner::Result result = gemm_tuner::tuneAndSave();
+    const tuning_profile::Profile& p = result.profile;
+    std::cout << "Tuned GEMM " << gemm_tuner::Options().n << "x" << gemm_tuner::Options().n << ": "
+              << result.defaultMs << "ms -> " << result.tunedMs << "ms (mc " << p.mc << ", kc " << p.kc << ", nc "
+              << p.nc << ", threads " << (p.threads == 1 ? "1" : "all") << "), MatrixBlock block size "
+              << p.blockSize << " (" << result.blockMs << "ms); profile saved to " << tuning_profile::defaultPath()
+              << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        if (argc > 1 && std::string(argv[1]) == "--tune") {
+            return tuneMain();
+        }
+        const gemm_kernel::Params& p = gemm_kernel::params();
+        std::cout << "GEMM parameters " << (tuning_profile::current().loaded ? "from profile" : "(defaults)") << ": mc "
+                  << p.mc << ", kc " << p.kc << ", nc " << p.nc << ", MatrixBlock block size "
+                  << tuning_profile::current().blockSize << "\n";
+        benchTranspose(4096, 4096);
+        benchTranspose(3001, 1999);
+        benchMultiplyTransposed(512);
+        benchDenseIO(2048);
+        benchBlockIO(32, 64);
+        benchBlockCopy(64, 32);
+        benchBlockMultiply(32, 32, 10);
+        benchBlockMultiply(16, 64, 50);
+        benchStrassen(1024);
+        benchBlockStrassen(16, 64);
+        benchGemv(4096, 8);
+        benchBlockGemv(64, 64, 20);
+        benchFactorization(1536, 128);
+        benchIterative(3072, 512, 64);
+        benchFixedTiles<4>(256, 20);
+        benchFixedTiles<8>(128, 20);
+        benchFixedTiles<16>(64, 20);
+        benchBanded(1024, 1 << 22);
+        benchTypedGemm(1024);
+        benchLazy(2048, 64);
+        benchOutOfCore(12, 128, size_t(8) << 20);
+        benchOutOfCore(12, 128, size_t(20) << 20);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <iomanip>
+#include <future>
+#include <numeric>
+#include <utility>
+#include "../lab2/HardwareInfo.cpp"
+
+template <typename T>
+class Vector {
+private:
+    size_t n;
+    T* data;
+    bool is_initialized;
+
+    // Вспомогательная функция для проверки границ
+    void check_index(size_t index) const {
+        if (index >= n) {
+            throw std::out_of_range("Index is out of range");
+        }
+    }
+
+    // Число потоков при num_threads == 0: все доступные процессоры машины, но на поток
+    // приходится не меньше L2 данных - на меньших частях запуск потока дороже работы
+    size_t resolve_threads(size_t num_threads) const {
+        if (num_threads != 0) {
+            return num_threads;
+        }
+        const hardware_info::Info& info = hardware_info::local();
+        const size_t min_chunk = std::max<size_t>(1, info.l2 / sizeof(T));
+        return std::max<size_t>(1, std::min<size_t>(info.memoryThreads(), n / min_chunk));
+    }
+
+    // Размер части кратен строке кэша, чтобы соседние потоки не делили строки
+    size_t chunk_size_for(size_t num_threads) const {
+        const size_t line = std::max<size_t>(1, hardware_info::local().cacheLine / sizeof(T));
+        const size_t chunk = n / num_threads;
+        return chunk >= line ? chunk / line * line : chunk;
+    }
+
+    template <typename Func>
+    T parallel_reduce(Func f, size_t num_threads) const{
+        check_initialization();
+        if(n == 0){
+            return 0;
+        }
+        num_threads = resolve_threads(num_threads);
+        std::vector<std::future<T>> futures;
+        size_t chunk_size = chunk_size_for(num_threads);
+
+        for (size_t i = 0; i < num_threads; ++i) {
+            size_t start = i * chunk_size;
+            size_t end = (i == num_threads - 1) ? n : (i + 1) * chunk_size;
+            futures.push_back(std::async(std::launch::async, f, start, end));
+        }
+
+        T result = 0;
+        for (auto& future : futures) {
+            result += future.get();
+        }
+        return result;
+    }
+
+    template <typename Func>
+    auto parallel_find_min_max(Func f, size_t num_threads) const {
+        check_initialization();
+        if(n == 0){
+             return std::make_pair(std::make_pair(static_cast<T>(0), static_cast<size_t>(0)), std::make_pair(static_cast<T>(0), static_cast<size_t>(0)));
+        }
+        num_threads = resolve_threads(num_threads);
+        std::vector<std::future<std::pair<std::pair<T, size_t>, std::pair<T, size_t>>>> futures;
+        size_t chunk_size = chunk_size_for(num_threads);
+
+        for (size_t i = 0; i < num_threads; ++i) {
+            size_t start = i * chunk_size;
+            size_t end = (i == num_threads - 1) ? n : (i + 1) * chunk_size;
+            futures.push_back(std::async(std::launch::async, f, start, end));
+        }
+        // Пустые части (потоков больше, чем элементов) пропускаются
+        bool found = false;
+        std::pair<T, size_t> min_result, max_result;
+        for (auto& future : futures) {
+            auto result = future.get();
+            if (result.first.second == size_t(-1)) {
+                continue;
+            }
+            if (!found || result.first.first < min_result.first) {
+                min_result = result.first;
+            }
+            if (!found || result.second.first > max_result.first) {
+                max_result = result.second;
+            }
+            found = true;
+        }
+
+       return std::make_pair(min_result, max_result);
+    }
+public:
+    // Конструктор
+    Vector(size_t size) : n(size), data(nullptr), is_initialized(false) {
+      if (size > 0) {
+          try {
+              data = new T[n];
+          } catch (const std::bad_alloc& e) {
+              std::cerr << "Memory allocation failed: " << e.what() << std::endl;
+              throw; // Re-throw the exception to be handled by the caller
+          }
+      } else {
+        throw std::invalid_argument("Vector size must be positive");
+      }
+    }
+
+    // Копирование (глубокое) и перемещение (без копирования данных)
+    Vector(const Vector& other) : n(other.n), data(new T[other.n]), is_initialized(other.is_initialized) {
+        std::copy(other.data, other.data + n, data);
+    }
+
+    Vector(Vector&& other) noexcept : n(other.n), data(other.data), is_initialized(other.is_initialized) {
+        other.data = nullptr;
+        other.n = 0;
+        other.is_initialized = false;
+    }
+
+    Vector& operator=(Vector other) {
+        std::swap(n, other.n);
+        std::swap(data, other.data);
+        std::swap(is_initialized, other.is_initialized);
+        return *this;
+    }
+
+    // Деструктор
+    ~Vector() {
+        delete[] data;
+    }
+
+    // Проверка инициализации
+    void check_initialization() const {
+        if (!is_initialized) {
+            throw std::runtime_error("Vector is not initialized");
+        }
+    }
+
+    // Инициализация константой
+    std::chrono::duration<double> initialize(const T& value) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            data[i] = value;
+        }
+        is_initialized = true;
+        auto end = std::chrono::high_resolution_clock::now();
+        return end - start;
+    }
+
+
+    // Оператор доступа по индексу (с проверкой границ)
+    T& operator[](size_t index) {
+        check_initialization();
+        check_index(index);
+        return data[index];
+    }
+
+    const T& operator[](size_t index) const{
+        check_initialization();
+        check_index(index);
+        return data[index];
+    }
+
+    // Инициализация случайными числами
+    std::chrono::duration<double> initialize_random(T min, T max) {
+        auto start = std::chrono::high_resolution_clock::now();
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<T> dist(min, max);
+
+        for (size_t i = 0; i < n; ++i) {
+            data[i] = dist(gen);
+        }
+        is_initialized = true;
+        auto end = std::chrono::high_resolution_clock::now();
+        return end - start;
+    }
+        // Экспорт в файл
+    std::chrono::duration<double> export_to_file(const std::string& filename) {
+        check_initialization();
+        auto start = std::chrono::high_resolution_clock::now();
+        std::ofstream file(filename, std::ios::binary);
+        if (file.is_open()) {
+           file.write(reinterpret_cast<char*>(data), sizeof(T) * n);
+           file.close();
+        } else {
+           throw std::runtime_error("File can not be opened.");
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return end - start;
+    }
+
+    // Импорт из файла
+    std::chrono::duration<double> import_from_file(const std::string& filename) {
+        if (data == nullptr) {
+            data = new T[n];
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        std::ifstream file(filename, std::ios::binary);
+        if(file.is_open()){
+            file.read(reinterpret_cast<char*>(data), sizeof(T) * n);
+            file.close();
+            is_initialized = true;
+        } else {
+           throw std::runtime_error("File can not be opened.");
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return end - start;
+    }
+
+    // ... (Методы для поиска мин/макс, среднего, суммы, норм и скалярного произведения - см. ниже)
+    // Методы поиска минимума и максимума с индексами.
+   std::pair<std::pair<T, size_t>, std::pair<T, size_t>> parallel_find_min_max(size_t num_threads = 0) const {
+
+       return parallel_find_min_max([this](size_t start, size_t end) {
+            if (start >= end) {
+                // пустая часть: индекс size_t(-1)
+                return std::make_pair(std::make_pair(T(), size_t(-1)), std::make_pair(T(), size_t(-1)));
+            }
+
+        T min_val = data[start];
+        T max_val = data[start];
+        size_t min_index = start;
+        size_t max_index = start;
+
+        for (size_t i = start + 1; i < end; ++i) {
+            if (data[i] < min_val) {
+                min_val = data[i];
+                min_index = i;
+            }
+            if (data[i] > max_val) {
+                max_val = data[i];
+                max_index = i;
+            }
+        }
+
+        return std::make_pair(std::make_pair(min_val, min_index), std::make_pair(max_val, max_index));
+        }, num_threads);
+    }
+     //Параллельная Евклидова норма
+    double parallel_euclidean_norm(size_t num_threads = 0) const{
+        return std::sqrt(parallel_reduce([this](size_t start, size_t end){
+            double local_sum_of_squares = 0;
+            for(size_t i = start; i < end; ++i){
+                local_sum_of_squares += std::pow(data[i], 2);
+            }
+            return local_sum_of_squares;
+        }, num_threads));
+    }
+
+    // Среднее значение (с использованием std::accumulate)
+    T average() const{
+        check_initialization();
+        if (n == 0) {
+          throw std::runtime_error("Vector is empty, can't calculate average");
+        }
+        return std::accumulate(data, data + n, static_cast<T>(0)) / n;
+    }
+
+    // Сумма элементов (с использованием std::accumulate)
+    T sum() const{
+        check_initialization();
+        return std::accumulate(data, data + n, static_cast<T>(0));
+    }
+
+    T parallel_sum(size_t num_threads = 0) const{
+
+       return parallel_reduce([this](size_t start, size_t end){
+           T local_sum = 0;
+           for(size_t i = start; i < end; ++i){
+               local_sum += data[i];
+           }
+           return local_sum;
+       }, num_threads);
+    }
+    //Параллельное среднее
+    T parallel_average(size_t num_threads = 0) const{
+        if(n == 0){
+            return 0;
+        }
+        return parallel_sum(num_threads)/n;
+    }
+    //Евклидова норма
+    double euclidean_norm() const{
+        check_initialization();
+        double sum_of_squares = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum_of_squares += std::pow(data[i], 2);
+        }
+        return std::sqrt(sum_of_squares);
+    }
+    //Манхеттенская норма
+    T manhattan_norm() const{
+        check_initialization();
+        T sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += std::abs(data[i]);
+        }
+        return sum;
+    }
+    //Скалярное произведение
+    T dot_product(const Vector<T>& other) const{
+        check_initialization();
+        other.check_initialization();
+        if (n != other.n) {
+            throw std::invalid_argument("Vectors must have the same size for dot product");
+        }
+
+        T result = 0;
+        for (size_t i = 0; i < n; ++i) {
+            result += data[i] * other.data[i];
+        }
+        return result;
+    }
+
+
+    //Параллельная Манхеттенская норма
+    T parallel_manhattan_norm(size_t num_threads = 0) const{
+       return parallel_reduce([this](size_t start, size_t end){
+            T local_sum = 0;
+            for(size_t i = start; i < end; ++i){
+                local_sum += std::abs(data[i]);
+            }
+            return local_sum;
+       }, num_threads);
+    }
+
+    //Параллельное Скалярное произведение
+     T parallel_dot_product(const Vector<T>& other, size_t num_threads = 0) const{
+        check_initialization();
+        other.check_initialization();
+        if (n != other.n) {
+            throw std::invalid_argument("Vectors must have the same size for dot product");
+        }
+        return parallel_reduce([this, &other](size_t start, size_t end){
+            T local_result = 0;
+            for (size_t i = start; i < end; ++i) {
+                local_result += data[i] * other.data[i];
+            }
+            return local_result;
+        }, num_threads);
+    }
+
+    size_t size() const { return n; } // Возвращаем размер вектора
+
+    // Прямой доступ к данным для вычислительных ядер (например, умножения матрицы на вектор)
+    T* data_ptr() { return data; }
+    const T* data_ptr() const { return data; }
+
+    // Данные записаны ядром напрямую через data_ptr()
+    void mark_initialized() { is_initialized = true; }
+
+
+};